@@ -0,0 +1,59 @@
+#ifndef AFINA_BENCH_SIZE_DISTRIBUTION_H
+#define AFINA_BENCH_SIZE_DISTRIBUTION_H
+
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace Bench {
+
+/**
+ * Size distribution given by a spec string:
+ *  - fixed:N
+ *  - uniform:MIN:MAX
+ *  - exp:MEAN:MAX - exponential with the given mean, clipped by MAX
+ */
+class SizeDistribution {
+public:
+    SizeDistribution(const std::string &spec) : _kind(spec.substr(0, spec.find(':'))), _a(1), _b(1) {
+        std::vector<size_t> args;
+        std::stringstream ss(spec.substr(std::min(spec.size(), _kind.size() + 1)));
+        std::string arg;
+        while (std::getline(ss, arg, ':')) {
+            args.push_back(std::stoul(arg));
+        }
+
+        if (_kind == "fixed" && args.size() == 1) {
+            _a = _b = args[0];
+        } else if ((_kind == "uniform" || _kind == "exp") && args.size() == 2 && args[0] <= args[1]) {
+            _a = args[0];
+            _b = args[1];
+        } else {
+            throw std::runtime_error("Bad size distribution: " + spec);
+        }
+    }
+
+    template <typename R> size_t operator()(R &rnd) const {
+        if (_kind == "uniform") {
+            return std::uniform_int_distribution<size_t>(_a, _b)(rnd);
+        } else if (_kind == "exp") {
+            size_t size = 1 + std::exponential_distribution<double>(1.0 / _a)(rnd);
+            return std::min(size, _b);
+        }
+        return _a;
+    }
+
+    size_t Max() const { return _b; }
+
+private:
+    std::string _kind;
+    size_t _a, _b;
+};
+
+} // namespace Bench
+
+#endif // AFINA_BENCH_SIZE_DISTRIBUTION_H
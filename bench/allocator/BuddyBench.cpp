@@ -0,0 +1,193 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include <cxxopts.hpp>
+
+#include <afina/allocator/Buddy.h>
+#include <afina/allocator/Error.h>
+
+// Compares Allocator::Buddy with glibc malloc on large values set and read back by a single thread, as storage
+// does for values of 64K and more. Each key either gets a new value of random size, which replaces the old one,
+// or has its value copied out. Both allocators hold no more than the region size: buddy is limited by the
+// region itself, malloc by the byte count, and random values are evicted until the new one fits. Prints one
+// JSON object per allocator with throughput, minor page faults per operation, evictions and, for buddy, the
+// fragmentation it has ended up with.
+
+namespace {
+
+struct Malloc {
+    Malloc(size_t limit) : limit(limit), used(0) {}
+    void *alloc(size_t size) {
+        if (used + size > limit) {
+            return nullptr;
+        }
+        used += size;
+        return std::malloc(size);
+    }
+    void free(void *p, size_t size) {
+        used -= size;
+        std::free(p);
+    }
+    void fragmentation(double &internal, double &external) const {}
+    size_t limit;
+    size_t used;
+};
+
+struct Buddy {
+    Buddy(size_t size) : region(new char[size]), buddy(region.get(), size) {}
+    void *alloc(size_t size) {
+        try {
+            return buddy.alloc(size);
+        } catch (Afina::Allocator::AllocError &) {
+            return nullptr;
+        }
+    }
+    void free(void *p, size_t size) { buddy.free(p); }
+    void fragmentation(double &internal, double &external) const {
+        internal = buddy.internal_fragmentation();
+        external = buddy.external_fragmentation();
+    }
+    std::unique_ptr<char[]> region;
+    Afina::Allocator::Buddy buddy;
+};
+
+struct Value {
+    char *data;
+    size_t size;
+};
+
+long MinorFaults() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_minflt;
+}
+
+struct Result {
+    double ops_per_sec;
+    double faults_per_op;
+    size_t evictions;
+
+    // Taken with all values in place, malloc doesn't report it
+    double internal_fragmentation;
+    double external_fragmentation;
+};
+
+// Runs churn with the same seed for every allocator, so all of them see the same operations
+template <typename TAllocator>
+Result Run(TAllocator &allocator, size_t keys, size_t ops, size_t reads, size_t min_size, size_t max_size) {
+    std::mt19937_64 gen(42);
+    std::uniform_int_distribution<size_t> sizes(min_size, max_size);
+    std::vector<char> source(max_size, 'v');
+    std::vector<char> out(max_size);
+    std::vector<Value> values(keys, Value{nullptr, 0});
+    Result result{0, 0, 0, 0, 0};
+
+    long faults = MinorFaults();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < ops; i++) {
+        Value &value = values[gen() % keys];
+        if (value.data != nullptr && gen() % 100 < reads) {
+            std::memcpy(out.data(), value.data, value.size);
+            continue;
+        }
+
+        if (value.data != nullptr) {
+            allocator.free(value.data, value.size);
+            value.data = nullptr;
+        }
+        size_t size = sizes(gen);
+        void *p;
+        while ((p = allocator.alloc(size)) == nullptr) {
+            Value &victim = values[gen() % keys];
+            if (victim.data != nullptr) {
+                allocator.free(victim.data, victim.size);
+                victim.data = nullptr;
+                result.evictions++;
+            }
+        }
+        value.data = static_cast<char *>(p);
+        value.size = size;
+        std::memcpy(value.data, source.data(), size);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.ops_per_sec = ops / seconds;
+    result.faults_per_op = double(MinorFaults() - faults) / ops;
+    allocator.fragmentation(result.internal_fragmentation, result.external_fragmentation);
+
+    for (auto &value : values) {
+        if (value.data != nullptr) {
+            allocator.free(value.data, value.size);
+        }
+    }
+    return result;
+}
+
+void Print(const char *name, const Result &result, const Result &base) {
+    std::cout << "{\"allocator\": \"" << name << "\", \"ops_per_sec\": " << result.ops_per_sec
+              << ", \"vs_malloc\": " << result.ops_per_sec / base.ops_per_sec
+              << ", \"minor_faults_per_op\": " << result.faults_per_op << ", \"evictions\": " << result.evictions;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    cxxopts::Options options("runBuddyBench", "Buddy allocator benchmark");
+    options.add_options()("r,region", "Region size in MB, both allocators hold no more than that",
+                          cxxopts::value<size_t>()->default_value("256"));
+    options.add_options()("k,keys", "Number of keys", cxxopts::value<size_t>()->default_value("1000"));
+    options.add_options()("n,ops", "Number of operations", cxxopts::value<size_t>()->default_value("100000"));
+    options.add_options()("reads", "Percent of reads", cxxopts::value<size_t>()->default_value("50"));
+    options.add_options()("min", "Minimal value size in bytes", cxxopts::value<size_t>()->default_value("65536"));
+    options.add_options()("max", "Maximal value size in bytes", cxxopts::value<size_t>()->default_value("4194304"));
+    options.add_options()("h,help", "Print usage info");
+
+    try {
+        options.parse(argc, argv);
+    } catch (cxxopts::OptionParseException &ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+    if (options.count("help") > 0) {
+        std::cerr << options.help() << std::endl;
+        return 0;
+    }
+
+    try {
+        size_t region = options["region"].as<size_t>() << 20;
+        size_t keys = options["keys"].as<size_t>();
+        size_t ops = options["ops"].as<size_t>();
+        size_t reads = options["reads"].as<size_t>();
+        size_t min_size = options["min"].as<size_t>();
+        size_t max_size = options["max"].as<size_t>();
+        if (keys == 0 || ops == 0 || reads > 100 || min_size == 0 || min_size > max_size ||
+            region < 2 * max_size) {
+            throw std::runtime_error("Keys and ops must be positive, sizes ordered and region twice the maximum");
+        }
+
+        Malloc malloc_allocator(region);
+        Result base = Run(malloc_allocator, keys, ops, reads, min_size, max_size);
+        Buddy buddy_allocator(region);
+        Result buddy = Run(buddy_allocator, keys, ops, reads, min_size, max_size);
+
+        Print("malloc", base, base);
+        std::cout << "}" << std::endl;
+        Print("buddy", buddy, base);
+        std::cout << ", \"region\": " << buddy_allocator.buddy.capacity()
+                  << ", \"internal_fragmentation\": " << buddy.internal_fragmentation
+                  << ", \"external_fragmentation\": " << buddy.external_fragmentation << "}" << std::endl;
+    } catch (std::exception &ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,435 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <malloc.h>
+#include <memory>
+#include <new>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <cxxopts.hpp>
+
+#include <afina/allocator/Error.h>
+#include <afina/allocator/Pointer.h>
+#include <afina/allocator/Resource.h>
+#include <afina/allocator/Simple.h>
+#include <afina/allocator/Slab.h>
+
+#include "../SizeDistribution.h"
+
+// Replays allocation trace against Allocator::Simple, slab pools behind Allocator::SlabResource and glibc malloc.
+// Trace is either read from a file or generated from size distributions, and could be saved for later runs.
+// Trace file has one operation per line:
+//  - "a <id> <size>" allocates object
+//  - "r <id> <size>" resizes object, keeping its content
+//  - "f <id>" frees object
+// Objects are filled on allocation, as values are, and checked on free, so moves by compaction are verified too.
+//
+// Every --sample-every operations each allocator prints JSON object with live bytes, footprint (memory taken
+// from the system or the region), overhead (share of footprint not holding live bytes) and fragmentation as
+// the allocator itself reports it. The final object per allocator has throughput, peak footprint, number of
+// failed allocations and distribution of compaction pauses.
+//
+// Simple runs the same policy as map_simple storage: bounded defrag_step after free once fragmentation exceeds
+// threshold and full defrag when allocation fails while there is enough free memory in total.
+
+namespace {
+
+struct Op {
+    char kind;
+    uint32_t id;
+    size_t size;
+};
+
+struct Trace {
+    std::vector<Op> ops;
+
+    // Ids are in [0, objects)
+    size_t objects;
+};
+
+/**
+ * Synthetic trace: objects are allocated until there are live of them, after that each operation either
+ * resizes a random live object or frees one, to be replaced by the next allocation. Sizes come from the
+ * phases in turn, each phase takes an equal share of operations, so change of the size mix fragments memory
+ */
+Trace Generate(size_t count, size_t live, size_t realloc_percent, const std::vector<Bench::SizeDistribution> &phases,
+               uint64_t seed) {
+    std::mt19937_64 rnd(seed);
+    Trace trace{{}, 0};
+    trace.ops.reserve(count);
+
+    std::vector<uint32_t> alive;
+    std::vector<uint32_t> unused;
+    for (size_t i = 0; i < count; i++) {
+        const Bench::SizeDistribution &sizes = phases[i * phases.size() / count];
+        if (alive.size() < live) {
+            uint32_t id = trace.objects;
+            if (!unused.empty()) {
+                id = unused.back();
+                unused.pop_back();
+            } else {
+                trace.objects++;
+            }
+            alive.push_back(id);
+            trace.ops.push_back(Op{'a', id, sizes(rnd)});
+            continue;
+        }
+
+        size_t victim = rnd() % alive.size();
+        if (rnd() % 100 < realloc_percent) {
+            trace.ops.push_back(Op{'r', alive[victim], sizes(rnd)});
+        } else {
+            trace.ops.push_back(Op{'f', alive[victim], 0});
+            unused.push_back(alive[victim]);
+            alive[victim] = alive.back();
+            alive.pop_back();
+        }
+    }
+    return trace;
+}
+
+// Reads trace file, ids are renumbered densely
+Trace Load(const std::string &path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("Can't open trace " + path);
+    }
+
+    Trace trace{{}, 0};
+    std::unordered_map<uint64_t, uint32_t> ids;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::stringstream ss(line);
+        char kind;
+        uint64_t id;
+        size_t size = 0;
+        if (!(ss >> kind >> id) || (kind != 'a' && kind != 'r' && kind != 'f') || (kind != 'f' && !(ss >> size))) {
+            throw std::runtime_error("Bad trace line: " + line);
+        }
+
+        auto it = ids.emplace(id, trace.objects).first;
+        trace.objects += it->second == trace.objects;
+        trace.ops.push_back(Op{kind, it->second, size});
+    }
+    return trace;
+}
+
+void Save(const std::string &path, const Trace &trace) {
+    std::ofstream out(path);
+    for (auto &op : trace.ops) {
+        out << op.kind << " " << op.id;
+        if (op.kind != 'f') {
+            out << " " << op.size;
+        }
+        out << "\n";
+    }
+    if (!out) {
+        throw std::runtime_error("Can't write trace " + path);
+    }
+}
+
+struct Malloc {
+    Malloc(size_t objects) : objects(objects, nullptr), base(Heap()) {}
+    static const char *name() { return "malloc"; }
+    bool alloc(uint32_t id, size_t size) { return (objects[id] = std::malloc(size)) != nullptr; }
+    bool realloc(uint32_t id, size_t old_size, size_t size) {
+        void *p = std::realloc(objects[id], size);
+        objects[id] = p != nullptr ? p : objects[id];
+        return p != nullptr;
+    }
+    void free(uint32_t id, size_t size) { std::free(objects[id]); }
+    void *data(uint32_t id) { return objects[id]; }
+
+    // Heap grown since start, both main arena and mapped chunks
+    size_t footprint() const { return Heap() - std::min(base, Heap()); }
+    double fragmentation() const { return -1; }
+    static size_t Heap() {
+        struct mallinfo2 info = mallinfo2();
+        return info.arena + info.hblkhd;
+    }
+
+    std::vector<void *> objects;
+    size_t base;
+    std::vector<double> pauses;
+};
+
+struct Simple {
+    Simple(size_t objects, size_t region, double threshold, size_t step_bytes, std::chrono::microseconds step_time)
+        : objects(objects), region(new char[region]), simple(this->region.get(), region), threshold(threshold),
+          step_bytes(step_bytes), step_time(step_time) {}
+    static const char *name() { return "simple"; }
+    bool alloc(uint32_t id, size_t size) { return Store(objects[id], size); }
+    bool realloc(uint32_t id, size_t old_size, size_t size) { return Store(objects[id], size); }
+    void free(uint32_t id, size_t size) {
+        simple.free(objects[id]);
+        if (simple.fragmentation() > threshold) {
+            auto start = std::chrono::steady_clock::now();
+            simple.defrag_step(step_bytes, step_time);
+            Pause(start);
+        }
+    }
+    void *data(uint32_t id) { return objects[id].get(); }
+    size_t footprint() const { return simple.footprint(); }
+    double fragmentation() const { return simple.fragmentation(); }
+
+    bool Store(Afina::Allocator::Pointer &p, size_t size) {
+        for (bool defragged = false;; defragged = true) {
+            try {
+                simple.realloc(p, size);
+                return true;
+            } catch (Afina::Allocator::AllocError &) {
+            }
+
+            // Enough memory in total, it is just fragmented
+            if (defragged || simple.available() < size + Overhead) {
+                return false;
+            }
+            auto start = std::chrono::steady_clock::now();
+            simple.defrag();
+            Pause(start);
+        }
+    }
+    void Pause(std::chrono::steady_clock::time_point start) {
+        pauses.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    // Upper bound of the allocator overhead per block, as storage assumes
+    static const size_t Overhead = 64;
+
+    std::vector<Afina::Allocator::Pointer> objects;
+    std::unique_ptr<char[]> region;
+    Afina::Allocator::Simple simple;
+    double threshold;
+    size_t step_bytes;
+    std::chrono::microseconds step_time;
+    std::vector<double> pauses;
+};
+
+// Pools take slabs from the arena of their own, so footprint is what the run has mapped. Objects larger than
+// SlabResource::MaxObjectSize and ones that don't fit into the arena go to the heap and are counted at size
+struct Slab {
+    Slab(size_t objects, size_t region)
+        : objects(objects, nullptr), arena(region), cache(arena), resource("replay.slab", cache), heap(0) {}
+    static const char *name() { return "slab"; }
+    bool alloc(uint32_t id, size_t size) {
+        try {
+            objects[id] = resource.allocate(size);
+        } catch (std::bad_alloc &) {
+            return false;
+        }
+        heap += arena.contains(objects[id]) ? 0 : size;
+        return true;
+    }
+    bool realloc(uint32_t id, size_t old_size, size_t size) {
+        void *old = objects[id];
+        if (!alloc(id, size)) {
+            objects[id] = old;
+            return false;
+        }
+        std::memcpy(objects[id], old, std::min(old_size, size));
+        Release(old, old_size);
+        return true;
+    }
+    void free(uint32_t id, size_t size) { Release(objects[id], size); }
+    void *data(uint32_t id) { return objects[id]; }
+    size_t footprint() const { return arena.mapped() + heap; }
+    double fragmentation() const { return -1; }
+
+    void Release(void *p, size_t size) {
+        heap -= arena.contains(p) ? 0 : size;
+        resource.deallocate(p, size);
+    }
+
+    std::vector<void *> objects;
+    Afina::Allocator::Arena arena;
+    Afina::Allocator::SlabCache cache;
+    Afina::Allocator::SlabResource resource;
+    size_t heap;
+    std::vector<double> pauses;
+};
+
+void PrintSample(const char *name, size_t op, size_t live, size_t footprint, double fragmentation) {
+    std::cout << "{\"allocator\": \"" << name << "\", \"op\": " << op << ", \"live_bytes\": " << live
+              << ", \"footprint\": " << footprint
+              << ", \"overhead\": " << (footprint == 0 ? 0 : 1 - std::min(1.0, double(live) / footprint));
+    if (fragmentation >= 0) {
+        std::cout << ", \"fragmentation\": " << fragmentation;
+    }
+    std::cout << "}" << std::endl;
+}
+
+double Percentile(const std::vector<double> &sorted, double p) {
+    return sorted.empty() ? 0 : sorted[std::min(sorted.size() - 1, size_t(p * sorted.size()))];
+}
+
+// Footprint is checked that often to track its peak between samples
+const size_t PeakCheck = 1024;
+
+template <typename TAllocator> void Replay(TAllocator &allocator, const Trace &trace, size_t sample_every) {
+    std::vector<size_t> sizes(trace.objects, 0);
+    size_t live = 0;
+    size_t peak_live = 0;
+    size_t peak_footprint = 0;
+    size_t failures = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < trace.ops.size(); i++) {
+        const Op &op = trace.ops[i];
+        size_t &size = sizes[op.id];
+        if (op.kind == 'f' || (op.kind == 'a' && size != 0)) {
+            if (size != 0) {
+                if (*static_cast<char *>(allocator.data(op.id)) != char(op.id)) {
+                    throw std::runtime_error(std::string("Object content is lost by ") + allocator.name());
+                }
+                allocator.free(op.id, size);
+                live -= size;
+                size = 0;
+            }
+        }
+
+        if (op.kind != 'f' && op.size > 0) {
+            bool done = size == 0 ? allocator.alloc(op.id, op.size) : allocator.realloc(op.id, size, op.size);
+            if (done) {
+                char *data = static_cast<char *>(allocator.data(op.id));
+                std::memset(data + std::min(size, op.size), char(op.id), op.size - std::min(size, op.size));
+                live = live - size + op.size;
+                size = op.size;
+            } else {
+                failures++;
+            }
+        }
+
+        peak_live = std::max(peak_live, live);
+        if ((i + 1) % PeakCheck == 0) {
+            peak_footprint = std::max(peak_footprint, allocator.footprint());
+        }
+        if ((i + 1) % sample_every == 0) {
+            PrintSample(allocator.name(), i + 1, live, allocator.footprint(), allocator.fragmentation());
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    peak_footprint = std::max(peak_footprint, allocator.footprint());
+
+    for (size_t id = 0; id < sizes.size(); id++) {
+        if (sizes[id] != 0) {
+            allocator.free(id, sizes[id]);
+        }
+    }
+
+    std::vector<double> pauses = allocator.pauses;
+    std::sort(pauses.begin(), pauses.end());
+    double total = 0;
+    for (double pause : pauses) {
+        total += pause;
+    }
+    std::cout << "{\"allocator\": \"" << allocator.name() << "\", \"ops\": " << trace.ops.size()
+              << ", \"ops_per_sec\": " << trace.ops.size() / seconds << ", \"failures\": " << failures
+              << ", \"peak_live_bytes\": " << peak_live << ", \"peak_footprint\": " << peak_footprint
+              << ", \"pauses\": " << pauses.size() << ", \"pause_p50_us\": " << Percentile(pauses, 0.5)
+              << ", \"pause_p99_us\": " << Percentile(pauses, 0.99)
+              << ", \"pause_max_us\": " << (pauses.empty() ? 0 : pauses.back()) << ", \"pause_total_us\": " << total
+              << "}" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    cxxopts::Options options("runReplayBench", "Allocators trace replay benchmark");
+    options.add_options()("trace", "Trace file to replay instead of the synthetic one", cxxopts::value<std::string>());
+    options.add_options()("save", "Save trace to the file", cxxopts::value<std::string>());
+    options.add_options()("n,ops", "Number of operations of synthetic trace",
+                          cxxopts::value<size_t>()->default_value("2000000"));
+    options.add_options()("l,live", "Number of live objects of synthetic trace",
+                          cxxopts::value<size_t>()->default_value("20000"));
+    options.add_options()("size", "Comma separated size distributions of synthetic trace phases: fixed:N, "
+                                  "uniform:MIN:MAX or exp:MEAN:MAX",
+                          cxxopts::value<std::string>()->default_value("exp:100:4096,uniform:512:8192"));
+    options.add_options()("realloc", "Percent of resizes among operations of synthetic trace",
+                          cxxopts::value<size_t>()->default_value("10"));
+    options.add_options()("seed", "Seed of synthetic trace", cxxopts::value<uint64_t>()->default_value("1"));
+    options.add_options()("a,allocators", "Comma separated allocators to replay against: malloc, simple, slab",
+                          cxxopts::value<std::string>()->default_value("malloc,simple,slab"));
+    options.add_options()("r,region", "Region size of simple and arena size of slab in MB",
+                          cxxopts::value<size_t>()->default_value("256"));
+    options.add_options()("compact-threshold", "Fragmentation that makes simple compact on free",
+                          cxxopts::value<double>()->default_value("0.25"));
+    options.add_options()("step-bytes", "Bytes moved by a single compaction step",
+                          cxxopts::value<size_t>()->default_value("65536"));
+    options.add_options()("step-us", "Time limit of a single compaction step in microseconds",
+                          cxxopts::value<size_t>()->default_value("100"));
+    options.add_options()("sample-every", "Print sample every that many operations, 0 for 20 samples per run",
+                          cxxopts::value<size_t>()->default_value("0"));
+    options.add_options()("h,help", "Print usage info");
+
+    try {
+        options.parse(argc, argv);
+    } catch (cxxopts::OptionParseException &ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+    if (options.count("help") > 0) {
+        std::cerr << options.help() << std::endl;
+        return 0;
+    }
+
+    try {
+        Trace trace;
+        if (options.count("trace") > 0) {
+            trace = Load(options["trace"].as<std::string>());
+        } else {
+            std::vector<Bench::SizeDistribution> phases;
+            std::stringstream ss(options["size"].as<std::string>());
+            std::string spec;
+            while (std::getline(ss, spec, ',')) {
+                phases.emplace_back(spec);
+            }
+            if (phases.empty() || options["realloc"].as<size_t>() > 100) {
+                throw std::runtime_error("Size distribution is required and realloc is a percent");
+            }
+            trace = Generate(options["ops"].as<size_t>(), options["live"].as<size_t>(),
+                             options["realloc"].as<size_t>(), phases, options["seed"].as<uint64_t>());
+        }
+        if (options.count("save") > 0) {
+            Save(options["save"].as<std::string>(), trace);
+        }
+        if (trace.ops.empty()) {
+            throw std::runtime_error("Trace is empty");
+        }
+
+        size_t sample_every = options["sample-every"].as<size_t>();
+        sample_every = sample_every > 0 ? sample_every : std::max<size_t>(1, trace.ops.size() / 20);
+        size_t region = options["region"].as<size_t>() << 20;
+
+        std::stringstream ss(options["allocators"].as<std::string>());
+        std::string name;
+        while (std::getline(ss, name, ',')) {
+            if (name == "malloc") {
+                Malloc allocator(trace.objects);
+                Replay(allocator, trace, sample_every);
+            } else if (name == "simple") {
+                Simple allocator(trace.objects, region, options["compact-threshold"].as<double>(),
+                                 options["step-bytes"].as<size_t>(),
+                                 std::chrono::microseconds(options["step-us"].as<size_t>()));
+                Replay(allocator, trace, sample_every);
+            } else if (name == "slab") {
+                Slab allocator(trace.objects, region);
+                Replay(allocator, trace, sample_every);
+            } else {
+                throw std::runtime_error("Unknown allocator " + name);
+            }
+        }
+    } catch (std::exception &ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cxxopts.hpp>
+
+#include <afina/allocator/Slab.h>
+
+// Compares Allocator::Mempool used directly (slab) and through per-thread Allocator::Magazine (magazine) with
+// glibc malloc on objects of a single size allocated and freed by many threads at once. Prints one JSON object
+// per allocator and pattern:
+//  - batch: each thread allocates a batch of objects and frees them in the same order
+//  - pairs: each thread frees object right after allocating it
+//  - handoff: each object is freed by the next thread, as connections and tasks passed between threads are
+
+namespace {
+
+struct Malloc {
+    Malloc(size_t size) : size(size) {}
+    void *alloc() { return std::malloc(size); }
+    void free(void *p) { std::free(p); }
+    size_t size;
+};
+
+struct Slab {
+    Slab(Afina::Allocator::Mempool &pool) : pool(pool) {}
+    void *alloc() { return pool.alloc(); }
+    void free(void *p) { pool.free(p); }
+    Afina::Allocator::Mempool &pool;
+};
+
+// Each thread gets its own magazine, that returns objects to the pool once thread exits. There is the only
+// pool per run, so magazine is bound to the pool of the first caller
+struct Magazines {
+    Magazines(Afina::Allocator::Mempool &pool) : pool(pool) {}
+    void *alloc() { return Local().alloc(); }
+    void free(void *p) { Local().free(p); }
+    Afina::Allocator::Magazine &Local() {
+        static thread_local Afina::Allocator::Magazine magazine(pool);
+        return magazine;
+    }
+    Afina::Allocator::Mempool &pool;
+};
+
+// Keeps compiler from eliding allocation that is freed right away
+inline void Escape(void *p) { asm volatile("" : : "g"(p) : "memory"); }
+
+// Runs pattern on the given number of threads, returns number of alloc and free pairs per second
+template <typename TAllocator>
+double Run(TAllocator &allocator, const std::string &pattern, size_t threads, size_t ops, size_t batch) {
+    std::vector<std::atomic<void *>> mailbox(threads);
+    for (auto &box : mailbox) {
+        box = nullptr;
+    }
+
+    std::atomic<size_t> ready(0);
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            std::vector<void *> objects(batch);
+            ready++;
+            while (ready < threads) {
+                std::this_thread::yield();
+            }
+
+            if (pattern == "batch") {
+                for (size_t done = 0; done < ops; done += batch) {
+                    for (size_t i = 0; i < batch; i++) {
+                        objects[i] = allocator.alloc();
+                        *static_cast<size_t *>(objects[i]) = i;
+                    }
+                    for (size_t i = 0; i < batch; i++) {
+                        allocator.free(objects[i]);
+                    }
+                }
+            } else if (pattern == "pairs") {
+                for (size_t i = 0; i < ops; i++) {
+                    void *p = allocator.alloc();
+                    *static_cast<size_t *>(p) = i;
+                    Escape(p);
+                    allocator.free(p);
+                }
+            } else {
+                auto &box = mailbox[(t + 1) % threads];
+                for (size_t i = 0; i < ops; i++) {
+                    void *p = allocator.alloc();
+                    *static_cast<size_t *>(p) = i;
+                    p = box.exchange(p);
+                    if (p != nullptr) {
+                        allocator.free(p);
+                    }
+                }
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (auto &box : mailbox) {
+        if (box != nullptr) {
+            allocator.free(box);
+        }
+    }
+    return threads * ops / seconds;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    cxxopts::Options options("runSlabBench", "Slab allocator benchmark");
+    options.add_options()("t,threads", "Number of threads", cxxopts::value<size_t>()->default_value("8"));
+    options.add_options()("n,ops", "Number of allocations per thread",
+                          cxxopts::value<size_t>()->default_value("10000000"));
+    options.add_options()("s,size", "Object size in bytes", cxxopts::value<size_t>()->default_value("128"));
+    options.add_options()("b,batch", "Objects per batch in batch pattern",
+                          cxxopts::value<size_t>()->default_value("64"));
+    options.add_options()("rounds", "Number of runs per allocator and pattern, best is reported",
+                          cxxopts::value<size_t>()->default_value("3"));
+    options.add_options()("h,help", "Print usage info");
+
+    try {
+        options.parse(argc, argv);
+    } catch (cxxopts::OptionParseException &ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+    if (options.count("help") > 0) {
+        std::cerr << options.help() << std::endl;
+        return 0;
+    }
+
+    try {
+        size_t threads = options["threads"].as<size_t>();
+        size_t ops = options["ops"].as<size_t>();
+        size_t size = options["size"].as<size_t>();
+        size_t batch = options["batch"].as<size_t>();
+        size_t rounds = options["rounds"].as<size_t>();
+        if (threads == 0 || ops == 0 || batch == 0 || rounds == 0 || size < sizeof(size_t)) {
+            throw std::runtime_error("Threads, ops, batch and rounds must be positive, size at least a word");
+        }
+
+        // Main thread magazine is destroyed after main returns, so the pool is never destroyed
+        auto arena = new Afina::Allocator::Arena(Afina::Allocator::Arena::MaxArenaSize);
+        auto cache = new Afina::Allocator::SlabCache(*arena);
+        auto &pool = *new Afina::Allocator::Mempool(*cache, size);
+
+        Malloc malloc_allocator(size);
+        Slab slab_allocator(pool);
+        Magazines magazine_allocator(pool);
+
+        const char *patterns[] = {"batch", "pairs", "handoff"};
+        for (const char *pattern : patterns) {
+            double best[3] = {0, 0, 0};
+            for (size_t round = 0; round < rounds; round++) {
+                best[0] = std::max(best[0], Run(malloc_allocator, pattern, threads, ops, batch));
+                best[1] = std::max(best[1], Run(slab_allocator, pattern, threads, ops, batch));
+                best[2] = std::max(best[2], Run(magazine_allocator, pattern, threads, ops, batch));
+            }
+
+            const char *names[] = {"malloc", "slab", "magazine"};
+            for (size_t i = 0; i < 3; i++) {
+                std::cout << "{\"allocator\": \"" << names[i] << "\", \"pattern\": \"" << pattern
+                          << "\", \"threads\": " << threads << ", \"ops_per_sec\": " << best[i]
+                          << ", \"vs_malloc\": " << best[i] / best[0] << "}" << std::endl;
+            }
+        }
+    } catch (std::exception &ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include <cxxopts.hpp>
+
+#include <afina/Storage.h>
+#include <afina/execute/Command.h>
+#include <afina/execute/StaticCommand.h>
+#include <protocol/Parser.h>
+#include <storage/MapBasedGlobalLockImpl.h>
+
+// Runs the same pipelined memcached input through the request path of the server without network: parse, build
+// command, execute on storage and collect replies. Prints one JSON object per dispatch mode:
+//  - runtime: command object is allocated by Parser::Build and executed by virtual calls, as uv network does
+//  - variant: Execute::StaticCommand executed over Afina::Storage, no command allocation but virtual storage
+//  - static: Execute::StaticCommand executed over the final storage type, as uv_static network does
+//
+// Commands log every call to stdout, by default stdout is muted so that only dispatch cost is compared
+
+namespace {
+
+typedef Afina::Backend::MapBasedGlobalLockImpl StorageImpl;
+
+// Feeds input to the parser and hands every command with its body to execute. Returns number of commands
+template <typename TBuild, typename TExecute>
+size_t Drive(const std::string &input, Afina::Protocol::Parser &parser, TBuild build, TExecute execute) {
+    size_t commands = 0;
+    size_t pos = 0;
+    std::string body;
+    while (pos < input.size()) {
+        size_t parsed = 0;
+        bool complete = parser.Parse(&input[pos], input.size() - pos, parsed);
+        pos += parsed;
+        if (!complete) {
+            throw std::runtime_error("Truncated input");
+        }
+
+        uint32_t body_size = 0;
+        build(body_size);
+        body.assign(input, pos, body_size);
+        pos += body_size > 0 ? body_size + 2 : 0;
+
+        execute(body);
+        parser.Reset();
+        commands++;
+    }
+    return commands;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    cxxopts::Options options("runDispatchBench", "Command dispatch benchmark");
+    options.add_options()("k,keys", "Number of distinct keys", cxxopts::value<size_t>()->default_value("100000"));
+    options.add_options()("n,ops", "Number of commands", cxxopts::value<size_t>()->default_value("1000000"));
+    options.add_options()("r,read-ratio", "Share of get commands, the rest are set",
+                          cxxopts::value<double>()->default_value("0.9"));
+    options.add_options()("value-size", "Value size in bytes", cxxopts::value<size_t>()->default_value("64"));
+    options.add_options()("rounds", "Number of passes over input per mode",
+                          cxxopts::value<size_t>()->default_value("3"));
+    options.add_options()("log", "Keep command logging to stdout");
+    options.add_options()("seed", "Random seed", cxxopts::value<uint64_t>()->default_value("1"));
+    options.add_options()("h,help", "Print usage info");
+
+    try {
+        options.parse(argc, argv);
+    } catch (cxxopts::OptionParseException &ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+    if (options.count("help") > 0) {
+        std::cerr << options.help() << std::endl;
+        return 0;
+    }
+
+    try {
+        size_t keys = options["keys"].as<size_t>();
+        size_t ops = options["ops"].as<size_t>();
+        double read_ratio = options["read-ratio"].as<double>();
+        size_t rounds = options["rounds"].as<size_t>();
+        std::string value(options["value-size"].as<size_t>(), 'v');
+        if (keys == 0 || ops == 0 || rounds == 0) {
+            throw std::runtime_error("Number of keys, commands and rounds must be positive");
+        }
+
+        // Whole key set fits, so every get hits and all modes do the same storage work
+        StorageImpl storage(keys * (value.size() + 64) * 2, true, keys);
+        for (size_t i = 0; i < keys; i++) {
+            storage.Put("key:" + std::to_string(i), value);
+        }
+
+        std::mt19937_64 rnd(options["seed"].as<uint64_t>());
+        std::uniform_int_distribution<size_t> key(0, keys - 1);
+        std::uniform_real_distribution<double> coin(0, 1);
+        std::string input;
+        for (size_t i = 0; i < ops; i++) {
+            if (coin(rnd) < read_ratio) {
+                input.append("get key:").append(std::to_string(key(rnd))).append("\r\n");
+            } else {
+                input.append("set key:").append(std::to_string(key(rnd))).append(" 0 0 ");
+                input.append(std::to_string(value.size())).append("\r\n").append(value).append("\r\n");
+            }
+        }
+
+        std::streambuf *stdout_buf = std::cout.rdbuf();
+        bool log = options.count("log") > 0;
+
+        Afina::Protocol::Parser parser;
+        std::unique_ptr<Afina::Execute::Command> cmd;
+        Afina::Execute::StaticCommand variant;
+        std::string out;
+
+        const char *modes[] = {"runtime", "variant", "static"};
+        for (const char *mode : modes) {
+            std::string name(mode);
+            double best = 0;
+            size_t reply_bytes = 0;
+            for (size_t round = 0; round < rounds; round++) {
+                if (!log) {
+                    std::cout.rdbuf(nullptr);
+                }
+                auto start = std::chrono::steady_clock::now();
+
+                size_t commands = 0;
+                out.clear();
+                if (name == "runtime") {
+                    commands = Drive(input, parser, [&](uint32_t &body_size) { cmd = parser.Build(body_size); },
+                                     [&](const std::string &body) {
+                                         std::string reply;
+                                         cmd->Execute(storage, body, reply);
+                                         out.append(reply).append("\r\n");
+                                     });
+                } else if (name == "variant") {
+                    Afina::Storage &virtual_storage = storage;
+                    commands = Drive(input, parser, [&](uint32_t &body_size) { parser.Build(variant, body_size); },
+                                     [&](const std::string &body) {
+                                         Afina::Execute::ExecuteStatic(virtual_storage, variant, body, out);
+                                         out.append("\r\n");
+                                     });
+                } else {
+                    commands = Drive(input, parser, [&](uint32_t &body_size) { parser.Build(variant, body_size); },
+                                     [&](const std::string &body) {
+                                         Afina::Execute::ExecuteStatic(storage, variant, body, out);
+                                         out.append("\r\n");
+                                     });
+                }
+
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                std::cout.rdbuf(stdout_buf);
+                best = std::max(best, commands / seconds);
+                reply_bytes = out.size();
+            }
+
+            std::cout << "{\"mode\": \"" << name << "\", \"commands\": " << ops << ", \"ops_per_sec\": " << best
+                      << ", \"ns_per_op\": " << 1e9 / best << ", \"reply_bytes\": " << reply_bytes << "}"
+                      << std::endl;
+        }
+    } catch (std::exception &ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
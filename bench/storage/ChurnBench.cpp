@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <cxxopts.hpp>
+
+#include <storage/MapBasedGlobalLockImpl.h>
+
+// Delete heavy workload: every round removes a share of live keys and replaces them with fresh ones, then
+// reads the whole live set. Prints one JSON object per round, throughput and lookup latency must stay flat
+// across rounds and index must not grow if removals leave nothing behind
+
+namespace {
+
+std::string GetStat(const Afina::Backend::MapBasedGlobalLockImpl &storage, const std::string &name) {
+    Afina::Storage::StatsList stats;
+    storage.GetStats("", stats);
+    for (auto &stat : stats) {
+        if (stat.first == name) {
+            return stat.second;
+        }
+    }
+    return "";
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    cxxopts::Options options("runChurnBench", "Storage delete churn benchmark");
+    options.add_options()("k,keys", "Number of live keys", cxxopts::value<size_t>()->default_value("100000"));
+    options.add_options()("r,rounds", "Number of churn rounds", cxxopts::value<size_t>()->default_value("20"));
+    options.add_options()("d,delete-ratio", "Share of live keys replaced every round",
+                          cxxopts::value<double>()->default_value("0.5"));
+    options.add_options()("value-size", "Value size in bytes", cxxopts::value<size_t>()->default_value("64"));
+    options.add_options()("seed", "Random seed", cxxopts::value<uint64_t>()->default_value("1"));
+    options.add_options()("h,help", "Print usage info");
+
+    try {
+        options.parse(argc, argv);
+    } catch (cxxopts::OptionParseException &ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+    if (options.count("help") > 0) {
+        std::cerr << options.help() << std::endl;
+        return 0;
+    }
+
+    try {
+        size_t keys = options["keys"].as<size_t>();
+        size_t rounds = options["rounds"].as<size_t>();
+        double ratio = options["delete-ratio"].as<double>();
+        std::string value(options["value-size"].as<size_t>(), 'v');
+        if (keys == 0 || ratio <= 0 || ratio > 1) {
+            throw std::runtime_error("Number of keys must be positive and delete ratio in (0, 1]");
+        }
+
+        // Memory limit is large enough to never evict, so every removal is an explicit delete
+        Afina::Backend::MapBasedGlobalLockImpl storage(keys * (value.size() + 64) * 2);
+        std::mt19937_64 rnd(options["seed"].as<uint64_t>());
+
+        uint64_t next_key = 0;
+        std::vector<std::string> live(keys);
+        for (auto &key : live) {
+            key = "key:" + std::to_string(next_key++);
+            storage.Put(key, value);
+        }
+
+        size_t replace = std::max<size_t>(1, keys * ratio);
+        std::string out;
+        for (size_t round = 0; round < rounds; round++) {
+            std::shuffle(live.begin(), live.end(), rnd);
+
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < replace; i++) {
+                if (!storage.Delete(live[i])) {
+                    throw std::runtime_error("Live key is missing: " + live[i]);
+                }
+                live[i] = "key:" + std::to_string(next_key++);
+                storage.Put(live[i], value);
+            }
+            auto churned = std::chrono::steady_clock::now();
+
+            size_t hits = 0;
+            for (auto &key : live) {
+                hits += storage.Get(key, out);
+            }
+            auto end = std::chrono::steady_clock::now();
+
+            double churn_sec = std::chrono::duration<double>(churned - start).count();
+            double get_ns = std::chrono::duration<double, std::nano>(end - churned).count() / live.size();
+            std::cout << "{\"round\": " << round << ", \"churn_ops_per_sec\": " << uint64_t(2 * replace / churn_sec)
+                      << ", \"get_ns\": " << get_ns << ", \"hit_ratio\": " << double(hits) / live.size()
+                      << ", \"curr_items\": " << GetStat(storage, "curr_items")
+                      << ", \"index_buckets\": " << GetStat(storage, "index_buckets") << "}" << std::endl;
+        }
+    } catch (std::exception &ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
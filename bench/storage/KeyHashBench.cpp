@@ -0,0 +1,51 @@
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <storage/KeyHash.h>
+
+// Compares storage key hash against std::hash on keys of typical sizes. Prints
+// one line per key size: size, ns per key for std::hash and KeyHash
+template <typename F> double Measure(const std::vector<std::string> &keys, F hash) {
+    const int Rounds = 50;
+    uint64_t sink = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < Rounds; r++) {
+        for (auto &key : keys) {
+            sink += hash(key);
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    // Prevent compiler from throwing hashing away
+    if (sink == 42) {
+        std::cerr << sink << std::endl;
+    }
+    return std::chrono::duration<double, std::nano>(end - start).count() / (Rounds * keys.size());
+}
+
+int main(int argc, char **argv) {
+    std::mt19937_64 rnd(1);
+    std::uniform_int_distribution<int> chars('a', 'z');
+
+    std::cout << "key_size std_hash_ns key_hash_ns" << std::endl;
+    for (size_t size : {20, 32, 48, 64, 80, 100, 120}) {
+        std::vector<std::string> keys(100000);
+        for (auto &key : keys) {
+            key.resize(size);
+            for (auto &c : key) {
+                c = chars(rnd);
+            }
+        }
+
+        double std_ns = Measure(keys, std::hash<std::string>());
+        double key_ns = Measure(keys, [](const std::string &key) { return Afina::Backend::KeyHash(key); });
+        std::cout << size << " " << std_ns << " " << key_ns << std::endl;
+    }
+    return 0;
+}
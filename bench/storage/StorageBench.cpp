@@ -0,0 +1,604 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cxxopts.hpp>
+
+#include <afina/Storage.h>
+#include <network/uv/SPSCQueue.h>
+#include <storage/HugePages.h>
+#include <storage/KeyHash.h>
+#include <storage/MapBasedGlobalLockImpl.h>
+
+#include "../SizeDistribution.h"
+
+// Drives storage implementation with a synthetic workload and prints results as a single JSON object:
+// throughput, hit ratio and latency percentiles. Run with --help for the list of knobs
+
+namespace {
+
+using Bench::SizeDistribution;
+
+/**
+ * Zipfian ranks generator over [0, n), see Gray et al. "Quickly generating billion-record synthetic
+ * databases". Theta 0 gives uniform distribution
+ */
+class Zipfian {
+public:
+    Zipfian(size_t n, double theta) : _n(n), _theta(theta) {
+        double zeta2 = 0;
+        _zetan = 0;
+        for (size_t i = 1; i <= n; i++) {
+            _zetan += 1.0 / std::pow(i, theta);
+            if (i == 2) {
+                zeta2 = _zetan;
+            }
+        }
+        _alpha = 1.0 / (1.0 - theta);
+        _eta = (1 - std::pow(2.0 / n, 1 - theta)) / (1 - zeta2 / _zetan);
+    }
+
+    template <typename R> size_t operator()(R &rnd) const {
+        if (_theta == 0) {
+            return std::uniform_int_distribution<size_t>(0, _n - 1)(rnd);
+        }
+
+        double u = std::uniform_real_distribution<double>(0, 1)(rnd);
+        double uz = u * _zetan;
+        if (uz < 1.0) {
+            return 0;
+        }
+        if (uz < 1.0 + std::pow(0.5, _theta)) {
+            return 1;
+        }
+        return std::min<size_t>(_n - 1, _n * std::pow(_eta * u - _eta + 1, _alpha));
+    }
+
+private:
+    size_t _n;
+    double _theta, _zetan, _alpha, _eta;
+};
+
+struct Workload {
+    std::vector<std::string> keys;
+
+    // Values are substrings of that buffer
+    std::string values;
+
+    size_t ops;
+    double read_ratio;
+    size_t scan_every;
+    size_t scan_length;
+    size_t latency_sample;
+
+    // Load alternates phases of that many operations: configured one and recency heavy one, where
+    // popular keys slide over the key space. Zero disables shifting
+    size_t shift_every;
+
+    // Missed key is put right away, as look-aside cache client does
+    bool fill_misses;
+};
+
+struct ThreadResult {
+    size_t gets = 0;
+    size_t hits = 0;
+    size_t sets = 0;
+    size_t scans = 0;
+
+    // Reads done by scan bursts, accounted in gets and hits as well
+    size_t scan_gets = 0;
+    size_t scan_hits = 0;
+    std::vector<uint64_t> latencies;
+};
+
+/**
+ * Storage split onto partitions, key goes to the partition picked by KeyHashShard, the same way uv workers
+ * route commands. Used as is by "map_striped": bench threads share all partitions, so each partition keeps
+ * its lock and the run shows what many small indexes and locks give against the single shared one
+ */
+class PartitionedStorage : public Afina::Storage {
+public:
+    PartitionedStorage(size_t partitions, size_t max_size, bool use_lock, const std::string &eviction) {
+        for (size_t i = 0; i < partitions; i++) {
+            _partitions.push_back(std::make_shared<Afina::Backend::MapBasedGlobalLockImpl>(
+                max_size / partitions, use_lock, 0, eviction));
+        }
+    }
+
+    void Start() override {
+        for (auto &partition : _partitions) {
+            partition->Start();
+        }
+    }
+
+    void Stop() override {
+        for (auto &partition : _partitions) {
+            partition->Stop();
+        }
+    }
+
+    bool Put(const std::string &key, const std::string &value) override { return Owner(key).Put(key, value); }
+
+    bool PutIfAbsent(const std::string &key, const std::string &value) override {
+        return Owner(key).PutIfAbsent(key, value);
+    }
+
+    bool Set(const std::string &key, const std::string &value) override { return Owner(key).Set(key, value); }
+
+    bool Delete(const std::string &key) override { return Owner(key).Delete(key); }
+
+    bool Get(const std::string &key, std::string &value) const override { return Owner(key).Get(key, value); }
+
+    size_t OwnerOf(const std::string &key) const {
+        return Afina::Backend::KeyHashShard(Afina::Backend::KeyHash(key), _partitions.size());
+    }
+
+    Afina::Storage &Partition(size_t index) const { return *_partitions[index]; }
+
+private:
+    Afina::Storage &Owner(const std::string &key) const { return *_partitions[OwnerOf(key)]; }
+
+    std::vector<std::shared_ptr<Afina::Backend::MapBasedGlobalLockImpl>> _partitions;
+};
+
+/**
+ * Shared-nothing configuration without the network, as "map_partitioned" server runs: partitions have no
+ * locks, each bench thread owns one of them. Operation on the key of another partition is forwarded to the
+ * owner thread over SPSCQueue, origin serves its own inbox while waiting for the result, so forwarding and
+ * queue hops are measured. Thread that is done with its operations keeps serving until all threads are done
+ */
+class SharedNothing {
+public:
+    SharedNothing(size_t threads, size_t max_size, const std::string &eviction)
+        : _storage(threads, max_size, false, eviction), _inbox(threads), _running(threads) {
+        for (size_t i = 0; i < threads; i++) {
+            for (size_t j = 0; j < threads; j++) {
+                _inbox[i].emplace_back(new SPSCQueue<Request *>(InboxSize));
+            }
+            _views.emplace_back(new View(*this, i));
+        }
+    }
+
+    // All partitions, could be used while bench threads aren't running only
+    PartitionedStorage &Storage() { return _storage; }
+
+    // Storage as seen by the bench thread owning the given partition
+    Afina::Storage &ViewOf(size_t thread) { return *_views[thread]; }
+
+    // Called by the bench thread once it is done with its operations
+    void Finish(size_t thread) {
+        _running.fetch_sub(1);
+        while (_running.load() > 0) {
+            if (!Serve(thread)) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+private:
+    template <typename T> using SPSCQueue = Afina::Network::UV::SPSCQueue<T>;
+
+    // Size of the each inbox queue, the same as uv workers have
+    static const size_t InboxSize = 4096;
+
+    enum class Op { Put, PutIfAbsent, Set, Delete, Get };
+
+    // Operation forwarded to the owner, lives on the stack of the origin until done
+    struct Request {
+        Op op;
+        const std::string *key;
+        const std::string *value;
+        std::string *out;
+        bool result;
+        std::atomic<bool> done;
+    };
+
+    class View : public Afina::Storage {
+    public:
+        View(SharedNothing &owner, size_t index) : _owner(owner), _index(index) {}
+
+        bool Put(const std::string &key, const std::string &value) override {
+            return _owner.Call(_index, Op::Put, key, &value, nullptr);
+        }
+
+        bool PutIfAbsent(const std::string &key, const std::string &value) override {
+            return _owner.Call(_index, Op::PutIfAbsent, key, &value, nullptr);
+        }
+
+        bool Set(const std::string &key, const std::string &value) override {
+            return _owner.Call(_index, Op::Set, key, &value, nullptr);
+        }
+
+        bool Delete(const std::string &key) override { return _owner.Call(_index, Op::Delete, key, nullptr, nullptr); }
+
+        bool Get(const std::string &key, std::string &value) const override {
+            return _owner.Call(_index, Op::Get, key, nullptr, &value);
+        }
+
+    private:
+        SharedNothing &_owner;
+        const size_t _index;
+    };
+
+    bool Execute(size_t partition, Op op, const std::string &key, const std::string *value, std::string *out) {
+        Afina::Storage &storage = _storage.Partition(partition);
+        switch (op) {
+        case Op::Put:
+            return storage.Put(key, *value);
+        case Op::PutIfAbsent:
+            return storage.PutIfAbsent(key, *value);
+        case Op::Set:
+            return storage.Set(key, *value);
+        case Op::Delete:
+            return storage.Delete(key);
+        case Op::Get:
+            return storage.Get(key, *out);
+        }
+        return false;
+    }
+
+    bool Call(size_t thread, Op op, const std::string &key, const std::string *value, std::string *out) {
+        size_t owner = _storage.OwnerOf(key);
+        if (owner == thread) {
+            return Execute(thread, op, key, value, out);
+        }
+
+        Request request;
+        request.op = op;
+        request.key = &key;
+        request.value = value;
+        request.out = out;
+        request.done.store(false, std::memory_order_relaxed);
+
+        // Owner could be waiting for this thread at the same time, so own inbox is served while waiting
+        SPSCQueue<Request *> &queue = *_inbox[owner][thread];
+        while (!queue.Push(&request)) {
+            Serve(thread);
+        }
+        while (!request.done.load(std::memory_order_acquire)) {
+            if (!Serve(thread)) {
+                std::this_thread::yield();
+            }
+        }
+        return request.result;
+    }
+
+    // Executes requests forwarded to the partition of the thread, returns false if there were none
+    bool Serve(size_t thread) {
+        bool served = false;
+        Request *request;
+        for (auto &queue : _inbox[thread]) {
+            while (queue->Pop(request)) {
+                request->result = Execute(thread, request->op, *request->key, request->value, request->out);
+                request->done.store(true, std::memory_order_release);
+                served = true;
+            }
+        }
+        return served;
+    }
+
+    PartitionedStorage _storage;
+
+    // Queue _inbox[i][j] holds requests of thread j to partition i
+    std::vector<std::vector<std::unique_ptr<SPSCQueue<Request *>>>> _inbox;
+    std::vector<std::unique_ptr<View>> _views;
+    std::atomic<size_t> _running;
+};
+
+std::shared_ptr<Afina::Storage> MakeStorage(const std::string &name, size_t max_size, size_t keys, int threads,
+                                            const std::string &eviction) {
+    if (name == "map_global") {
+        return std::make_shared<Afina::Backend::MapBasedGlobalLockImpl>(max_size, true, 0, eviction);
+    } else if (name == "map_presized") {
+        return std::make_shared<Afina::Backend::MapBasedGlobalLockImpl>(max_size, true, keys, eviction);
+    } else if (name == "map_nolock") {
+        if (threads != 1) {
+            throw std::runtime_error("map_nolock could be used by a single thread only");
+        }
+        return std::make_shared<Afina::Backend::MapBasedGlobalLockImpl>(max_size, false, 0, eviction);
+    } else if (name == "map_striped") {
+        // Partition per thread, as server has partition per worker
+        return std::make_shared<PartitionedStorage>(threads, max_size, threads != 1, eviction);
+    }
+    throw std::runtime_error("Unknown storage: " + name);
+}
+
+void Run(Afina::Storage &storage, const Workload &load, const Zipfian &zipf, const SizeDistribution &value_size,
+         uint64_t seed, ThreadResult &result) {
+    std::mt19937_64 rnd(seed);
+    std::uniform_real_distribution<double> coin(0, 1);
+    std::string value;
+
+    auto put = [&](const std::string &key) {
+        size_t size = value_size(rnd);
+        size_t offset = std::uniform_int_distribution<size_t>(0, load.values.size() - size)(rnd);
+        storage.Put(key, load.values.substr(offset, size));
+        result.sets++;
+    };
+    auto get = [&](const std::string &key, bool scan) {
+        bool hit = storage.Get(key, value);
+        result.hits += hit;
+        result.gets++;
+        result.scan_hits += scan && hit;
+        result.scan_gets += scan;
+        if (!hit && load.fill_misses) {
+            put(key);
+        }
+    };
+
+    for (size_t op = 0; op < load.ops; op++) {
+        bool sample = op % load.latency_sample == 0;
+        auto start = sample ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+
+        bool recency = load.shift_every != 0 && (op / load.shift_every) % 2 == 1;
+        if (!recency && load.scan_every != 0 && op % load.scan_every == load.scan_every - 1) {
+            // Scan burst: sequential reads of a key range, a pattern that pollutes recency based eviction
+            size_t from = std::uniform_int_distribution<size_t>(0, load.keys.size() - 1)(rnd);
+            for (size_t i = 0; i < load.scan_length; i++) {
+                get(load.keys[(from + i) % load.keys.size()], true);
+            }
+            result.scans++;
+            continue;
+        }
+
+        const std::string &key = load.keys[recency ? (zipf(rnd) + op) % load.keys.size() : zipf(rnd)];
+        if (coin(rnd) < load.read_ratio) {
+            get(key, false);
+        } else {
+            put(key);
+        }
+
+        if (sample) {
+            auto end = std::chrono::steady_clock::now();
+            result.latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        }
+    }
+}
+
+/**
+ * Counts data TLB load misses of the process including threads started after Start. Counter is
+ * unavailable if kernel doesn't allow perf events, in that case Stop returns -1
+ */
+class DTLBCounter {
+public:
+    DTLBCounter() : _fd(-1) {}
+    ~DTLBCounter() {
+        if (_fd >= 0) {
+            close(_fd);
+        }
+    }
+
+    void Start() {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        _fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+        if (_fd >= 0) {
+            ioctl(_fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(_fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    // Must be called once all measured threads are joined
+    int64_t Stop() {
+        uint64_t value;
+        if (_fd < 0 || ioctl(_fd, PERF_EVENT_IOC_DISABLE, 0) != 0 ||
+            read(_fd, &value, sizeof(value)) != sizeof(value)) {
+            return -1;
+        }
+        return value;
+    }
+
+private:
+    int _fd;
+};
+
+uint64_t Percentile(const std::vector<uint64_t> &sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    return sorted[std::min(sorted.size() - 1, size_t(p * sorted.size()))];
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    cxxopts::Options options("runStorageBench", "Storage microbenchmark");
+    options.add_options()("s,storage",
+                          "Storage to test: map_global, map_presized, map_nolock, map_striped, map_partitioned",
+                          cxxopts::value<std::string>()->default_value("map_global"));
+    options.add_options()("t,threads", "Number of client threads", cxxopts::value<int>()->default_value("1"));
+    options.add_options()("n,ops", "Operations per thread", cxxopts::value<size_t>()->default_value("1000000"));
+    options.add_options()("k,keys", "Number of distinct keys", cxxopts::value<size_t>()->default_value("100000"));
+    options.add_options()("m,memory", "Storage size limit in bytes",
+                          cxxopts::value<size_t>()->default_value("67108864"));
+    options.add_options()("z,zipf", "Zipfian skew of key popularity, 0 for uniform",
+                          cxxopts::value<double>()->default_value("0.99"));
+    options.add_options()("key-size", "Key size distribution: fixed:N, uniform:MIN:MAX or exp:MEAN:MAX",
+                          cxxopts::value<std::string>()->default_value("uniform:16:48"));
+    options.add_options()("value-size", "Value size distribution: fixed:N, uniform:MIN:MAX or exp:MEAN:MAX",
+                          cxxopts::value<std::string>()->default_value("exp:100:4096"));
+    options.add_options()("r,read-ratio", "Share of gets among operations",
+                          cxxopts::value<double>()->default_value("0.9"));
+    options.add_options()("scan-every", "Run scan burst every N operations, 0 to disable",
+                          cxxopts::value<size_t>()->default_value("0"));
+    options.add_options()("scan-length", "Number of sequential keys read by a scan burst",
+                          cxxopts::value<size_t>()->default_value("1000"));
+    options.add_options()("shift-every", "Alternate with recency heavy phase every N operations, 0 to disable",
+                          cxxopts::value<size_t>()->default_value("0"));
+    options.add_options()("fill-misses", "Put missed key right away, as look-aside cache does");
+    options.add_options()("eviction", "Eviction policy: lru or arc",
+                          cxxopts::value<std::string>()->default_value("lru"));
+    options.add_options()("latency-sample", "Measure latency of every N-th operation",
+                          cxxopts::value<size_t>()->default_value("16"));
+    options.add_options()("no-prefill", "Don't put all keys before measurement");
+    options.add_options()("huge-pages", "Back storage entries and index by huge pages");
+    options.add_options()("ghost-list", "Track evicted keys and report hits of larger cache sizes");
+    options.add_options()("seed", "Random seed", cxxopts::value<uint64_t>()->default_value("1"));
+    options.add_options()("h,help", "Print usage info");
+
+    try {
+        options.parse(argc, argv);
+    } catch (cxxopts::OptionParseException &ex) {
+        std::cerr << "Error: " << ex.what() << std::endl;
+        return 1;
+    }
+    if (options.count("help") > 0) {
+        std::cerr << options.help() << std::endl;
+        return 0;
+    }
+
+    try {
+        std::string storage_name = options["storage"].as<std::string>();
+        int threads = options["threads"].as<int>();
+        uint64_t seed = options["seed"].as<uint64_t>();
+        SizeDistribution key_size(options["key-size"].as<std::string>());
+        SizeDistribution value_size(options["value-size"].as<std::string>());
+
+        Workload load;
+        load.ops = options["ops"].as<size_t>();
+        load.read_ratio = options["read-ratio"].as<double>();
+        load.scan_every = options["scan-every"].as<size_t>();
+        load.scan_length = options["scan-length"].as<size_t>();
+        load.shift_every = options["shift-every"].as<size_t>();
+        load.fill_misses = options.count("fill-misses") > 0;
+        load.latency_sample = std::max<size_t>(1, options["latency-sample"].as<size_t>());
+        if (threads < 1 || options["keys"].as<size_t>() == 0) {
+            throw std::runtime_error("Number of threads and keys must be positive");
+        }
+
+        std::mt19937_64 rnd(seed);
+        std::uniform_int_distribution<int> chars('a', 'z');
+        load.keys.resize(options["keys"].as<size_t>());
+        for (size_t i = 0; i < load.keys.size(); i++) {
+            std::string &key = load.keys[i];
+            key = "key:" + std::to_string(i) + ":";
+            key.resize(std::max(key.size(), key_size(rnd)), 'k');
+        }
+        load.values.resize(2 * value_size.Max());
+        for (auto &c : load.values) {
+            c = chars(rnd);
+        }
+
+        if (options.count("huge-pages") > 0) {
+            Afina::Backend::EnableHugePages(true);
+        }
+
+        Zipfian zipf(load.keys.size(), options["zipf"].as<double>());
+        std::string eviction = options["eviction"].as<std::string>();
+        std::shared_ptr<SharedNothing> shared;
+        std::shared_ptr<Afina::Storage> storage;
+        if (storage_name == "map_partitioned") {
+            shared = std::make_shared<SharedNothing>(threads, options["memory"].as<size_t>(), eviction);
+            storage = std::shared_ptr<Afina::Storage>(shared, &shared->Storage());
+        } else {
+            storage = MakeStorage(storage_name, options["memory"].as<size_t>(), load.keys.size(), threads, eviction);
+        }
+        if (options.count("ghost-list") > 0) {
+            if (storage_name == "map_striped" || storage_name == "map_partitioned") {
+                throw std::runtime_error("Ghost list isn't supported by " + storage_name);
+            }
+            std::static_pointer_cast<Afina::Backend::MapBasedGlobalLockImpl>(storage)->EnableGhosts(true);
+        }
+        storage->Start();
+
+        if (options.count("no-prefill") == 0) {
+            for (auto &key : load.keys) {
+                storage->Put(key, load.values.substr(0, value_size(rnd)));
+            }
+        }
+
+        std::vector<ThreadResult> results(threads);
+        std::vector<std::thread> workers;
+        DTLBCounter dtlb;
+        dtlb.Start();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < threads; i++) {
+            if (shared) {
+                workers.emplace_back([&shared, &load, &zipf, &value_size, &results, seed, i]() {
+                    Run(shared->ViewOf(i), load, zipf, value_size, seed + i + 1, results[i]);
+                    shared->Finish(i);
+                });
+            } else {
+                workers.emplace_back(Run, std::ref(*storage), std::cref(load), std::cref(zipf),
+                                     std::cref(value_size), seed + i + 1, std::ref(results[i]));
+            }
+        }
+        for (auto &worker : workers) {
+            worker.join();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        int64_t dtlb_misses = dtlb.Stop();
+        Afina::Backend::HugePageUsage huge = Afina::Backend::GetHugePageUsage();
+        storage->Stop();
+
+        // Ghost hits as a JSON object, empty unless ghost list is enabled
+        Afina::Storage::StatsList stats;
+        storage->GetStats("", stats);
+        std::stringstream ghosts;
+        for (auto &stat : stats) {
+            if (stat.first.compare(0, 6, "ghost_") == 0) {
+                ghosts << (ghosts.tellp() == 0 ? "" : ", ") << "\"" << stat.first.substr(6) << "\": " << stat.second;
+            }
+        }
+
+        ThreadResult total;
+        for (auto &result : results) {
+            total.gets += result.gets;
+            total.hits += result.hits;
+            total.sets += result.sets;
+            total.scans += result.scans;
+            total.scan_gets += result.scan_gets;
+            total.scan_hits += result.scan_hits;
+            total.latencies.insert(total.latencies.end(), result.latencies.begin(), result.latencies.end());
+        }
+        std::sort(total.latencies.begin(), total.latencies.end());
+        size_t ops = total.gets + total.sets;
+        size_t point_gets = total.gets - total.scan_gets;
+        size_t point_hits = total.hits - total.scan_hits;
+
+        std::cout << "{\"storage\": \"" << storage_name << "\", \"eviction\": \"" << eviction
+                  << "\", \"threads\": " << threads << ", \"ops\": " << ops
+                  << ", \"seconds\": " << seconds << ", \"ops_per_sec\": " << ops / seconds
+                  << ", \"gets\": " << total.gets << ", \"sets\": " << total.sets << ", \"scans\": " << total.scans
+                  << ", \"hit_ratio\": " << (total.gets ? double(total.hits) / total.gets : 0)
+                  << ", \"point_hit_ratio\": " << (point_gets ? double(point_hits) / point_gets : 0)
+                  << ", \"latency_ns\": {\"p50\": " << Percentile(total.latencies, 0.5)
+                  << ", \"p90\": " << Percentile(total.latencies, 0.9)
+                  << ", \"p99\": " << Percentile(total.latencies, 0.99)
+                  << ", \"p999\": " << Percentile(total.latencies, 0.999)
+                  << ", \"max\": " << (total.latencies.empty() ? 0 : total.latencies.back())
+                  << "}, \"dtlb_load_misses\": " << dtlb_misses << ", \"huge_pages\": {\"mapped\": " << huge.mapped
+                  << ", \"hugetlb\": " << huge.hugetlb << ", \"transparent\": " << huge.transparent
+                  << "}, \"ghost\": {" << ghosts.str() << "}}"
+                  << std::endl;
+    } catch (std::exception &e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
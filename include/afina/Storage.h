@@ -1,7 +1,12 @@
 #ifndef AFINA_STORAGE_H
 #define AFINA_STORAGE_H
 
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace Afina {
 
@@ -10,6 +15,28 @@ namespace Afina {
  */
 class Storage {
 public:
+    /**
+     * Statistics as an ordered list of name/value pairs
+     */
+    typedef std::vector<std::pair<std::string, std::string>> StatsList;
+
+    /**
+     * Outcome of the LeaseGet
+     */
+    enum class LeaseStatus {
+        // Value is found
+        Hit,
+
+        // Value is missing, caller holds the lease and is expected to refill key by LeaseSet
+        Granted,
+
+        // Key is being refilled by other client, invalidated value is returned meanwhile
+        Stale,
+
+        // Key is being refilled by other client and there is no value to return, caller should retry later
+        Wait
+    };
+
     Storage() {}
     virtual ~Storage() {}
 
@@ -56,6 +83,23 @@ public:
      */
     virtual bool Set(const std::string &key, const std::string &value) = 0;
 
+    /**
+     * Appends data to the end of the value associated with the given key.
+     * If requested key doesn't present in storage method returns false and
+     * doesnt change anything.
+     *
+     * Default implementation replaces value by the concatenation, storages
+     * able to extend value in place override it so that repeated appends to
+     * the same key take amortized linear time
+     *
+     * @param key to append data to
+     * @param data to be appended to the value
+     */
+    virtual bool Append(const std::string &key, const std::string &data) {
+        std::string value;
+        return Get(key, value) && Put(key, value.append(data));
+    }
+
     /**
      * Removes association for the given key
      * If requested key doesn't present in storage method returns false and
@@ -84,6 +128,77 @@ public:
      * @param value output parameter to copy value to
      */
     virtual bool Get(const std::string &key, std::string &value) const = 0;
+
+    /**
+     * Appends statistics of the given group to the output list. Empty group means general
+     * statistics. Groups not known to the storage are ignored
+     *
+     * @param group name of the statistics group
+     * @param stats output list to append name/value pairs to
+     */
+    virtual void GetStats(const std::string &group, StatsList &stats) const {}
+
+    /**
+     * Replaces storage content with records of the dump file, see storage/Dump.h for the format.
+     * New content becomes visible at once: concurrent readers see either old content or the new one.
+     * Records with negative exptime are skipped as already expired
+     *
+     * Method returns number of loaded items, in case of any error it throws std::runtime_error
+     * and storage content remains unchanged
+     *
+     * @param path dump file to load
+     * @param accept optional filter, only keys it returns true for are loaded
+     */
+    virtual size_t Load(const std::string &path, const std::function<bool(const std::string &)> &accept) {
+        throw std::runtime_error("Storage doesn't support bulk load");
+    }
+
+    /**
+     * Invalidates all existing associations once given delay passes. After that moment storage
+     * behaves as empty for any existing key. Associations created after the moment are not affected.
+     * Next call replaces delay set by the previous one
+     *
+     * Throws std::runtime_error in case if storage doesn't support flush
+     *
+     * @param delay in seconds, zero means flush right now
+     */
+    virtual void FlushAll(uint32_t delay) { throw std::runtime_error("Storage doesn't support flush"); }
+
+    /**
+     * Get that protects backing store from the stampede of misses. The first client that misses the key
+     * gets a lease token and is expected to refill the key with LeaseSet. Until then other clients get
+     * either invalidated value, if key has been invalidated recently, or a request to wait.
+     *
+     * Throws std::runtime_error in case if storage doesn't support leases
+     *
+     * @param key to retrive value for
+     * @param value output parameter, set for Hit and Stale outcomes only
+     * @param token output parameter, set for Granted outcome only
+     */
+    virtual LeaseStatus LeaseGet(const std::string &key, std::string &value, uint64_t &token) {
+        throw std::runtime_error("Storage doesn't support leases");
+    }
+
+    /**
+     * Stores value if the given lease token is still valid: no other write or invalidation of the key
+     * happened since the lease has been granted. Returns false otherwise
+     *
+     * @param key to be associated with value
+     * @param value to be assigned for the key
+     * @param token lease token returned by LeaseGet
+     */
+    virtual bool LeaseSet(const std::string &key, const std::string &value, uint64_t token) {
+        throw std::runtime_error("Storage doesn't support leases");
+    }
+
+    /**
+     * Marks existing association as invalid: Get doesn't see it anymore, but value could be still
+     * returned by LeaseGet as stale one while key is being refilled. Returns false if there is no
+     * such key
+     *
+     * @param key to be invalidated
+     */
+    virtual bool Invalidate(const std::string &key) { throw std::runtime_error("Storage doesn't support leases"); }
 };
 
 } // namespace Afina
@@ -0,0 +1,151 @@
+#ifndef AFINA_ALLOCATOR_BUDDY_H
+#define AFINA_ALLOCATOR_BUDDY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <afina/allocator/Stats.h>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * # Buddy allocator
+ * Wraps given memory area and serves blocks of power of two number of pages, meant for large values which
+ * malloc maps and unmaps on every allocation. Block of order k is 2^k pages long and starts at the multiple
+ * of its size. Allocation takes the smallest free block of a large enough order and splits it in halves
+ * until it matches the request, free merges block with its buddy, the other half of the block they were
+ * split from, for as long as buddy is free too. So free memory always forms the largest blocks possible.
+ *
+ * Area is cut into top level blocks of decreasing orders. Table of page headers with order, state and
+ * free list links goes in front of them, free blocks themselves are never touched, so pages of the area
+ * are committed only once they are allocated. Optionally free block that merges into a block of release size
+ * or larger gives its pages back to the system by madvise(MADV_DONTNEED), so memory once taken by large
+ * values doesn't stay committed after they are gone. Area must be private anonymous memory in that case.
+ *
+ * Allocator instance doesn't take ownership of wrapped memory, same as Simple.
+ *
+ * Not thread safe
+ */
+class Buddy {
+public:
+    static const size_t DefaultPageSize = 4096;
+
+    /**
+     * Page size must be a power of two, area that doesn't fit a single page after the table makes every
+     * allocation fail. Pages are never released if release size is 0
+     * @param base void*
+     * @param size size_t
+     * @param page_size size_t
+     * @param release_size size_t
+     */
+    Buddy(void *base, size_t size, size_t page_size = DefaultPageSize, size_t release_size = 0);
+
+    Buddy(const Buddy &) = delete;
+    Buddy &operator=(const Buddy &) = delete;
+
+    /**
+     * Allocates block of at least N bytes, throws AllocError of NoMemory type if there is no free block
+     * large enough
+     * @param N size_t
+     */
+    void *alloc(size_t N);
+
+    /**
+     * Releases block, nothing happens for nullptr. Throws AllocError of InvalidFree type for an address not
+     * allocated by the allocator or already freed
+     * @param p void*
+     */
+    void free(void *p);
+
+    // Checks whether address belongs to the area
+    bool contains(const void *p) const {
+        return static_cast<const char *>(p) >= _blocks && static_cast<const char *>(p) < _blocks + capacity();
+    }
+
+    /**
+     * Human readable summary of the allocator state: sizes, number of free blocks of each order and both
+     * kinds of fragmentation
+     */
+    std::string dump() const;
+
+    /**
+     * State in the form shared by all allocators: free blocks by order, fragmentation is the external one
+     */
+    Stats stats() const;
+
+    // Number of bytes in blocks area
+    size_t capacity() const { return _pages * _page_size; }
+
+    // Number of bytes in live blocks
+    size_t allocated() const { return _allocated; }
+
+    // Number of bytes requested by live blocks
+    size_t requested() const { return _requested; }
+
+    // Number of live blocks
+    size_t live() const { return _live; }
+
+    // Number of bytes given back to the system by free
+    size_t released() const { return _released; }
+
+    // Number of bytes in free blocks
+    size_t available() const { return capacity() - _allocated; }
+
+    // Size of the largest free block, the largest request that could succeed
+    size_t largest_free() const;
+
+    /**
+     * Share of allocated memory lost to rounding of requests up to the block size, from 0 to 1
+     */
+    double internal_fragmentation() const;
+
+    /**
+     * Share of free memory that the largest free block misses, from 0 when all free memory is a single
+     * block to 1. Top level blocks never merge, so free memory counts up to the largest of them only
+     */
+    double external_fragmentation() const;
+
+private:
+    static const size_t MaxOrders = 48;
+    static const uint32_t None = UINT32_MAX;
+
+    struct Page;
+
+    // Smallest order of block at least N bytes long, MaxOrders if there is no such
+    size_t OrderOf(size_t N) const;
+
+    void Push(uint32_t page, size_t order);
+    void Unlink(uint32_t page, size_t order);
+
+    size_t _page_size;
+    unsigned _page_shift;
+
+    // Headers of pages, meaningful for the first page of each block only
+    Page *_table;
+
+    // Blocks area, aligned to the page size
+    char *_blocks;
+    size_t _pages;
+
+    // Size of the first top level block, the largest one possible
+    size_t _top_size;
+
+    // Blocks of that order and above are released once free, MaxOrders if release is disabled
+    size_t _release_order;
+    size_t _released;
+
+    // Heads of free lists by order and their lengths
+    uint32_t _free[MaxOrders];
+    size_t _free_count[MaxOrders];
+
+    size_t _allocated;
+    size_t _requested;
+    size_t _live;
+};
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_BUDDY_H
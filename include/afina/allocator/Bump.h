@@ -0,0 +1,87 @@
+#ifndef AFINA_ALLOCATOR_BUMP_H
+#define AFINA_ALLOCATOR_BUMP_H
+
+#include <cstddef>
+#include <string>
+
+#include <afina/allocator/Resource.h>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * # Bump arena
+ * Resource for temporaries of a single request or batch of requests: blocks are cut one after another from
+ * chunks taken by AllocBuffer and all of them are taken back at once by reset, which costs the same no matter
+ * how many blocks were given out. Deallocation of a single block does nothing except for the most recent one,
+ * which is given back, so string or vector growing at the top doesn't waste the chunk.
+ *
+ * Blocks larger than a quarter of the chunk get buffers of their own, released by deallocate or reset. Chunks
+ * are kept by reset for the next round, so arena settles on the size of the largest round.
+ *
+ * Not thread safe
+ */
+class Bump : public Resource {
+public:
+    static const size_t DefaultChunkSize = 4096;
+
+    /**
+     * Chunk size must be large enough to hold the chunk header and a few blocks, it is rounded up to 256
+     * @param name std::string
+     * @param chunk_size size_t
+     */
+    Bump(const std::string &name, size_t chunk_size = DefaultChunkSize);
+    ~Bump();
+
+    /**
+     * Takes back all blocks given out so far. Blocks must not be used after that, containers holding them must
+     * be destroyed or cleared without deallocation, like std::string that fits into its own buffer
+     */
+    void reset();
+
+    // Number of chunks taken
+    size_t chunks() const { return _chunks; }
+
+    // Number of resets
+    size_t resets() const { return _resets; }
+
+protected:
+    void *Allocate(size_t size) override;
+    void Deallocate(void *p, size_t size) override;
+
+private:
+    struct Chunk {
+        Chunk *next;
+    };
+
+    struct Large {
+        Large *next;
+        size_t size;
+    };
+
+    // Moves to the next chunk, taking a new one if needed, and allocates size bytes there
+    void *Grow(size_t size);
+
+    void *AllocLarge(size_t size);
+
+    const size_t _chunk_size;
+
+    // Chunks in the order of use, ones after the current one are empty
+    Chunk *_first;
+    Chunk *_current;
+
+    // Free space of the current chunk
+    char *_top;
+    char *_end;
+
+    // Blocks of their own
+    Large *_large;
+
+    size_t _chunks;
+    size_t _resets;
+};
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_BUMP_H
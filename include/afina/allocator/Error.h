@@ -11,7 +11,7 @@ enum class AllocErrorType {
     NoMemory,
 };
 
-class AllocError : std::runtime_error {
+class AllocError : public std::runtime_error {
 private:
     AllocErrorType type;
 
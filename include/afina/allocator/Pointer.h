@@ -7,6 +7,13 @@ namespace Allocator {
 // to avoid expensive macros calculations and increase compile speed
 class Simple;
 
+/**
+ * Handle of the block allocated by Simple. Handle refers to the slot of the allocator descriptor table
+ * which holds actual block address, so allocator is free to move block around, for example on defrag.
+ * Address returned by get() is valid until the next call to allocator.
+ *
+ * Copies refer to the same block. Once block is freed through one of the copies, others are dangling
+ */
 class Pointer {
 public:
     Pointer();
@@ -17,7 +24,15 @@ public:
     Pointer &operator=(const Pointer &);
     Pointer &operator=(Pointer &&);
 
-    void *get() const { return 0; }
+    void *get() const { return _slot == nullptr ? nullptr : *_slot; }
+
+private:
+    friend class Simple;
+
+    Pointer(void **slot) : _slot(slot) {}
+
+    // Descriptor of the block, nullptr if nothing is allocated
+    void **_slot;
 };
 
 } // namespace Allocator
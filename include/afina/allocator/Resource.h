@@ -0,0 +1,284 @@
+#ifndef AFINA_ALLOCATOR_RESOURCE_H
+#define AFINA_ALLOCATOR_RESOURCE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <afina/allocator/Buddy.h>
+#include <afina/allocator/Simple.h>
+#include <afina/allocator/Slab.h>
+#include <afina/allocator/Stats.h>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * # Accounted memory resource
+ * Named source of memory that C++ containers draw from through StlAllocator, modelled after
+ * std::pmr::memory_resource. Every resource counts bytes and blocks it gave out, so memory taken by
+ * indices, queues and other containers shows up per pool in "stats pools" rather than disappearing
+ * in the global heap.
+ *
+ * All live resources are registered, ForEach walks over them. Registry is split per thread, so resources
+ * created for every connection don't contend for a global lock. Counters are kept per thread slot too and
+ * summed up only once read, allocation touches counters of its own thread only. Resource must outlive every
+ * block it gave out. Accounting is thread safe, allocation is as thread safe as the implementation states
+ */
+class Resource {
+public:
+    Resource(const std::string &name);
+    virtual ~Resource();
+
+    Resource(const Resource &) = delete;
+    Resource &operator=(const Resource &) = delete;
+
+    /**
+     * Returns block of at least size bytes aligned for any type, throws std::bad_alloc if there is no memory
+     * @param size size_t
+     */
+    void *allocate(size_t size);
+
+    /**
+     * Returns block back, size must be the same as requested
+     * @param p void*
+     * @param size size_t
+     */
+    void deallocate(void *p, size_t size);
+
+    const std::string &name() const { return _name; }
+
+    // Number of bytes requested by live blocks
+    size_t bytes() const;
+
+    // Largest number of bytes ever taken at once. Exact if resource is used by a single thread, otherwise it is
+    // sampled once a thread takes more than it ever did
+    size_t peak() const;
+
+    // Number of live blocks
+    size_t blocks() const;
+
+    // Number of allocate calls, successful or not
+    uint64_t allocations() const;
+
+    // Number of allocate calls that threw std::bad_alloc
+    uint64_t failures() const;
+
+    /**
+     * State of the memory behind the resource, what "stats allocator" reports. By default it is only what
+     * the resource counts itself: live blocks and their bytes, both used and reserved. Must be safe to call
+     * from any thread
+     */
+    virtual Stats stats() const;
+
+    /**
+     * Calls visitor for every live resource, registry is locked meanwhile so visitor must not create or
+     * destroy resources
+     * @param visitor std::function<void(const Resource &)>
+     */
+    static void ForEach(const std::function<void(const Resource &)> &visitor);
+
+protected:
+    // Returns block or nullptr if there is no memory
+    virtual void *Allocate(size_t size) = 0;
+
+    virtual void Deallocate(void *p, size_t size) = 0;
+
+private:
+    // Number of counter slots, threads are spread over them round robin
+    static const size_t CounterSlots = 16;
+
+    struct Counters;
+    struct Shard;
+    struct Registry;
+
+    // Registry of live resources and the shard of the calling thread in it
+    static Registry &Resources();
+    static Shard &LocalShard();
+
+    // Counters of the calling thread slot, created on the first use
+    Counters &Local();
+
+    // Sums up counter of all slots
+    template <typename T> T Sum(std::atomic<T> Counters::*counter) const;
+
+    // Raises peak up to the current number of bytes
+    void UpdatePeak() const;
+
+    const std::string _name;
+
+    // Registry shard of the thread that created resource and position in it, protected by shard lock
+    Shard *_shard;
+    size_t _index;
+
+    std::atomic<Counters *> _counters[CounterSlots];
+    mutable std::atomic<size_t> _peak;
+};
+
+/**
+ * Global heap with accounting
+ */
+class HeapResource : public Resource {
+public:
+    HeapResource(const std::string &name) : Resource(name) {}
+
+protected:
+    void *Allocate(size_t size) override;
+    void Deallocate(void *p, size_t size) override;
+};
+
+/**
+ * Fixed blocks of Allocator::Simple, calls to the allocator are serialized by the resource. Allocator must
+ * outlive the resource and could be used directly as well while the resource lock is not held by others
+ */
+class SimpleResource : public Resource {
+public:
+    SimpleResource(const std::string &name, Simple &allocator) : Resource(name), _allocator(allocator) {}
+
+    // State of the whole allocator, blocks used directly included
+    Stats stats() const override;
+
+protected:
+    void *Allocate(size_t size) override;
+    void Deallocate(void *p, size_t size) override;
+
+private:
+    mutable std::mutex _m;
+    Simple &_allocator;
+};
+
+/**
+ * Large blocks of Allocator::Buddy, blocks smaller than min_size and ones that don't fit into the allocator
+ * go to the global heap, the latter are counted as overflows. Calls to the allocator are serialized by the
+ * resource, allocator must outlive it
+ */
+class BuddyResource : public Resource {
+public:
+    BuddyResource(const std::string &name, Buddy &allocator, size_t min_size = 0)
+        : Resource(name), _allocator(allocator), _min_size(min_size), _overflows(0) {}
+
+    // Number of blocks of at least min_size bytes that went to the heap
+    uint64_t overflows() const { return _overflows.load(std::memory_order_relaxed); }
+
+    /**
+     * Calls visitor with the allocator while resource lock is held, to read its state consistently
+     * @param visitor std::function<void(const Buddy &)>
+     */
+    void inspect(const std::function<void(const Buddy &)> &visitor) const;
+
+    // State of the allocator, blocks that went to the heap are not there
+    Stats stats() const override;
+
+protected:
+    void *Allocate(size_t size) override;
+    void Deallocate(void *p, size_t size) override;
+
+private:
+    mutable std::mutex _m;
+    Buddy &_allocator;
+    const size_t _min_size;
+    std::atomic<uint64_t> _overflows;
+};
+
+/**
+ * Objects of the slab pools, one pool per size class of 16 bytes up to MaxObjectSize. Pools are created on
+ * the first request of their size and take slabs from the given cache, blocks larger than MaxObjectSize and
+ * ones that don't fit once arena is exhausted go to the global heap. Container nodes are all of the same
+ * size, so each node type takes a pool of its own without waste.
+ *
+ * Thread safe and lock-free except the first request of a size
+ */
+class SlabResource : public Resource {
+public:
+    static const size_t MaxObjectSize = 1024;
+
+    SlabResource(const std::string &name, SlabCache &cache = DefaultSlabCache());
+    ~SlabResource();
+
+    /**
+     * State of the pools: free blocks are free objects of the pool slabs by object size. Pools never give slabs
+     * back, so fragmentation is the share of pool memory held by free objects beyond one slab per pool, that is
+     * by slabs a pool has outgrown. Blocks that went to the heap are not there
+     */
+    Stats stats() const override;
+
+protected:
+    void *Allocate(size_t size) override;
+    void Deallocate(void *p, size_t size) override;
+
+private:
+    static const size_t Granularity = 16;
+    static const size_t Classes = MaxObjectSize / Granularity;
+
+    static size_t ClassOf(size_t size) { return size == 0 ? 0 : (size - 1) / Granularity; }
+
+    // Returns pool of the size class, creating it on the first request
+    Mempool *Pool(size_t size);
+
+    SlabCache &_cache;
+
+    std::mutex _pools_m;
+    std::atomic<Mempool *> _pools[Classes];
+
+    // Live objects by size class
+    std::atomic<size_t> _objects[Classes];
+};
+
+/**
+ * Process wide accounted global heap, "heap", that allocators without explicit resource use
+ */
+Resource &DefaultResource();
+
+/**
+ * Adapter that satisfies C++11 Allocator requirements on top of a Resource. Copies and rebinds share the
+ * resource, allocators are equal if their resources are the same. Resource follows contents on move
+ * assignment and swap, so container could be given a resource by assigning an empty one to it, copy
+ * assignment keeps resource of the target.
+ *
+ * Usage:
+ *   SlabResource pool("index");
+ *   std::list<int, StlAllocator<int>> list(StlAllocator<int>(pool));
+ */
+template <typename T> class StlAllocator {
+public:
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    StlAllocator() noexcept : _resource(&DefaultResource()) {}
+    StlAllocator(Resource &resource) noexcept : _resource(&resource) {}
+
+    template <typename U> StlAllocator(const StlAllocator<U> &other) noexcept : _resource(&other.resource()) {}
+
+    T *allocate(size_t n) { return static_cast<T *>(_resource->allocate(n * sizeof(T))); }
+    void deallocate(T *p, size_t n) noexcept { _resource->deallocate(p, n * sizeof(T)); }
+
+    Resource &resource() const noexcept { return *_resource; }
+
+private:
+    Resource *_resource;
+};
+
+template <typename T, typename U> bool operator==(const StlAllocator<T> &a, const StlAllocator<U> &b) noexcept {
+    return &a.resource() == &b.resource();
+}
+
+template <typename T, typename U> bool operator!=(const StlAllocator<T> &a, const StlAllocator<U> &b) noexcept {
+    return !(a == b);
+}
+
+// Containers drawing from a resource
+typedef std::basic_string<char, std::char_traits<char>, StlAllocator<char>> String;
+template <typename T> using Vector = std::vector<T, StlAllocator<T>>;
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_RESOURCE_H
@@ -1,8 +1,13 @@
 #ifndef AFINA_ALLOCATOR_SIMPLE_H
 #define AFINA_ALLOCATOR_SIMPLE_H
 
-#include <string>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include <afina/allocator/Stats.h>
 
 namespace Afina {
 namespace Allocator {
@@ -18,44 +23,227 @@ class Pointer;
  * Allocator instance doesn't take ownership of wrapped memmory and do not delete it
  * on destruction. So caller must take care of resource cleaup after allocator stop
  * being needs
+ *
+ * Blocks are placed from the beginning of the area upwards, each one is preceded by a small header. Table
+ * of descriptors grows from the end of the area downwards, Pointer refers to a descriptor that holds
+ * address of the block. Freed blocks are kept in a free list and merged with the following free neighbour,
+ * new blocks are taken from the free list first fit or from the gap between blocks and descriptors.
+ *
+ * Since clients never see block addresses for longer than until the next call, defrag is able to slide
+ * all live blocks to the beginning of the area, which turns all free memory into the single gap. The same
+ * could be done incrementally by defrag_step, that moves a bounded amount of blocks per call and remembers
+ * where it stopped, so compaction of a large area is spread over many short pauses.
+ *
+ * Block could be pinned to keep its address stable while it is read without holding the caller's lock:
+ * pinned blocks are never moved and free of a pinned block is deferred until it is unpinned.
+ *
+ * Blocks given by alloc_fixed are addressed directly and never move, which is what C++ allocators need,
+ * see SimpleResource. They stay in the way of compaction the same way pinned blocks do, so the area should
+ * mostly hold movable blocks.
+ *
+ * Not thread safe
  */
-// TODO: Implements interface to allow usage as C++ allocators
 class Simple {
 public:
     Simple(void *base, const size_t size);
 
     /**
-     * TODO: semantics
+     * Allocates block of at least N bytes, throws AllocError of NoMemory type if there is no free
+     * block large enough. Allocation never defragments memory implicitly
      * @param N size_t
      */
     Pointer alloc(size_t N);
 
     /**
-     * TODO: semantics
+     * Changes size of the block keeping its content up to the smaller of the sizes. Block shrinks in place,
+     * grows in place into free blocks following it and into the gap if they are large enough, otherwise it
+     * is moved. Pointer stays the same in any case. Empty pointer gets a new block. If there is no room,
+     * AllocError is thrown and block is left untouched. Pinned block is never moved, so it could only be
+     * resized in place
      * @param p Pointer
      * @param N size_t
      */
     void realloc(Pointer &p, size_t N);
 
     /**
-     * TODO: semantics
+     * Releases block and resets pointer, nothing happens for an empty pointer. Throws AllocError of
+     * InvalidFree type for a pointer not owned by allocator or already freed. Pinned block stays in place
+     * until the last unpin
      * @param p Pointer
      */
     void free(Pointer &p);
 
     /**
-     * TODO: semantics
+     * Allocates block of at least N bytes which is never moved and returns its address. Throws AllocError
+     * of NoMemory type if there is no free block large enough
+     * @param N size_t
+     */
+    void *alloc_fixed(size_t N);
+
+    /**
+     * Releases block given by alloc_fixed, nothing happens for nullptr. Throws AllocError of InvalidFree
+     * type for other addresses
+     * @param ptr void*
+     */
+    void free_fixed(void *ptr);
+
+    /**
+     * Moves all live blocks except pinned ones to the beginning of the area, so that all free memory
+     * becomes contiguous
      */
     void defrag();
 
     /**
-     * TODO: semantics
+     * Continues compaction from the place where previous step stopped, sliding live blocks down into the
+     * holes before them until either max_bytes are moved or max_time passed. Returns true once there are no
+     * holes left to close, except ones in front of pinned blocks
+     * @param max_bytes size_t
+     * @param max_time std::chrono::microseconds
+     */
+    bool defrag_step(size_t max_bytes, std::chrono::microseconds max_time);
+
+    /**
+     * Prevents block from being moved or reused until the matching unpin. Pins are counted
+     * @param p Pointer
+     */
+    void pin(const Pointer &p);
+
+    /**
+     * Releases pin taken by pin, frees the block if it was freed while pinned
+     * @param p Pointer
+     */
+    void unpin(const Pointer &p);
+
+    // Checks whether block is pinned
+    bool pinned(const Pointer &p) const;
+
+    /**
+     * Human readable summary of the allocator state
      */
     std::string dump() const;
 
+    /**
+     * State in the form shared by all allocators. Free list blocks are counted by power of two classes, the
+     * gap between blocks and descriptors is not a block but counts for the largest free one
+     */
+    Stats stats() const;
+
+    /**
+     * Number of bytes not taken by live blocks and their headers. All of it could be allocated at once
+     * after defrag, minus header of the new block
+     */
+    size_t available() const;
+
+    // Number of bytes taken by live blocks
+    size_t used() const { return _used; }
+
+    // Number of bytes of the area taken by blocks, holes between them and descriptors, that is all but the gap
+    size_t footprint() const { return _base_len - (reinterpret_cast<char *>(_slots) - _top); }
+
+    // Number of live blocks, fixed ones included
+    size_t live() const { return _live; }
+
+    // Number of live fixed blocks
+    size_t fixed() const { return _fixed; }
+
+    /**
+     * Share of available memory scattered over holes between blocks rather than in the gap at the top,
+     * from 0 for the compacted area to 1
+     */
+    double fragmentation() const;
+
+    // Number of bytes moved by defrag and defrag_step in total
+    uint64_t moved() const { return _moved; }
+
+    // Number of defrag_step calls that moved something
+    uint64_t steps() const { return _steps; }
+
+    // Longest and total time spent in defrag and defrag_step, in microseconds
+    uint64_t pause_max() const { return _pause_max; }
+    uint64_t pause_total() const { return _pause_total; }
+
 private:
+    struct Block;
+
+    // Returns header of the block given its address
+    static Block *BlockOf(void *ptr);
+
+    // Takes free descriptor, throws NoMemory if table is unable to grow
+    void **TakeSlot();
+
+    // Finds room for the block of the given rounded size, nullptr if there is no such
+    Block *Place(size_t size);
+
+    // Grows live block in place up to the given rounded size or more, taking free blocks following it and
+    // the gap. Returns false if they are not enough
+    bool Grow(Block *block, size_t size);
+
+    // Cuts tail of the block off if it is large enough to become a free block
+    void Split(Block *block, size_t size);
+
+    // Returns block to the free memory, merging it with the following free neighbour
+    void Release(Block *block);
+
+    // Releases block and descriptor of the freed pointer
+    void Discard(void **slot);
+
+    // Checks whether live block must stay in place
+    bool Immovable(Block *block) const;
+
+    // Moves live block down to the given address and returns its new header
+    Block *Move(Block *block, char *to);
+
+    // Accounts time spent since start to the pause statistics
+    void Pause(std::chrono::steady_clock::time_point start);
+
+    void LinkFree(Block *block);
+    void UnlinkFree(Block *block);
+
+    // Checks pointer was given by this allocator and is not freed yet
+    void Validate(const Pointer &p) const;
+
     void *_base;
     const size_t _base_len;
+
+    // Blocks area [_begin, _top)
+    char *_begin;
+    char *_top;
+
+    // Descriptors table [_slots, _slots_end), grows downwards
+    void **_slots;
+    void **_slots_end;
+
+    // List of unused descriptors, linked through descriptors themselves
+    void **_free_slots;
+
+    // Doubly linked list of free blocks
+    Block *_free_blocks;
+
+    // Bytes in free blocks, headers included
+    size_t _free_bytes;
+
+    // Bytes in live blocks, headers excluded
+    size_t _used;
+    size_t _live;
+    size_t _fixed;
+
+    // Incremental compaction position, blocks area below it has no holes except ones before pinned blocks
+    char *_cursor;
+
+    struct Pin {
+        uint32_t count;
+
+        // Block was freed while pinned, it is released on the last unpin
+        bool freed;
+    };
+
+    // Pins by descriptor
+    std::unordered_map<void **, Pin> _pins;
+
+    uint64_t _moved;
+    uint64_t _steps;
+    uint64_t _pause_max;
+    uint64_t _pause_total;
 };
 
 } // namespace Allocator
@@ -0,0 +1,324 @@
+#ifndef AFINA_ALLOCATOR_SLAB_H
+#define AFINA_ALLOCATOR_SLAB_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include <afina/allocator/Stats.h>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * # Slab allocator
+ * Three layers modelled after tarantool's small library:
+ *  - Arena reserves one large range of address space and cuts it into slabs of the same size
+ *  - SlabCache hands slabs out to pools and takes them back, reusing returned ones first
+ *  - Mempool serves objects of a single size carved from slabs
+ *
+ * On top of them Magazine keeps a bounded per-thread cache of a pool objects, which it exchanges with the pool
+ * in batches, so most allocations and frees touch neither shared memory nor atomics.
+ *
+ * All layers are thread safe and lock-free on the object path: free lists are stacks updated by a single
+ * compare-and-swap of a 64 bit word that holds 32 bit offset of the top element and 32 bit modification
+ * counter, which protects from ABA. Offsets are taken relative to the arena start, so an arena is limited
+ * by MaxArenaSize. Memory of the arena is never unmapped until arena is destroyed, so a thread may safely
+ * read link of an element that is concurrently taken by other one.
+ */
+
+/**
+ * Reserved range of address space cut into slabs. Pages are committed slab by slab once slabs are mapped
+ */
+class Arena {
+public:
+    static const size_t DefaultSlabSize = 1 << 20;
+    static const size_t MaxArenaSize = size_t(16) << 30;
+
+    /**
+     * Reserves size bytes of address space, throws std::bad_alloc if that is impossible.
+     * Slab size must be a power of two and a multiple of the page size
+     * @param size size_t
+     * @param slab_size size_t
+     */
+    Arena(size_t size, size_t slab_size = DefaultSlabSize);
+    ~Arena();
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    /**
+     * Maps next slab, returns nullptr once arena is exhausted
+     */
+    void *map();
+
+    // Checks whether address belongs to the arena
+    bool contains(const void *p) const {
+        return static_cast<const char *>(p) >= _base && static_cast<const char *>(p) < _base + _size;
+    }
+
+    char *base() const { return _base; }
+    size_t size() const { return _size; }
+    size_t slab_size() const { return _slab_size; }
+
+    // Number of bytes in slabs mapped so far
+    size_t mapped() const;
+
+private:
+    char *_raw;
+    size_t _raw_size;
+
+    // Reserved range aligned to the slab size
+    char *_base;
+    const size_t _size;
+    const size_t _slab_size;
+
+    // Offset of the next slab to map, could grow beyond size once arena is exhausted
+    std::atomic<size_t> _next;
+};
+
+/**
+ * Cache of free slabs over an arena
+ */
+class SlabCache {
+public:
+    SlabCache(Arena &arena);
+
+    SlabCache(const SlabCache &) = delete;
+    SlabCache &operator=(const SlabCache &) = delete;
+
+    /**
+     * Returns a free slab, mapping a new one if cache is empty. Returns nullptr once arena is exhausted
+     */
+    void *get();
+
+    /**
+     * Returns slab back to the cache
+     * @param slab void*
+     */
+    void put(void *slab);
+
+    Arena &arena() const { return _arena; }
+
+    // Number of slabs in the cache
+    size_t cached() const { return _cached.load(std::memory_order_relaxed); }
+
+    /**
+     * State of the arena in the form shared by all allocators, slabs are blocks: used ones are taken by pools,
+     * free ones are either cached or not mapped yet. All slabs are of the same size, so nothing is fragmented
+     */
+    Stats stats() const;
+
+private:
+    Arena &_arena;
+
+    // Stack of free slabs
+    std::atomic<uint64_t> _free;
+    std::atomic<size_t> _cached;
+};
+
+/**
+ * Pool of objects of the single size. Freed objects go to one of a few free lists chosen by the calling
+ * thread, so threads rarely touch the same list. Thread that finds its list empty takes over all objects
+ * of another list, then a batch from the depot, and only if all of them are empty carves a new slab.
+ *
+ * Depot is a stack of batches of BatchSize objects linked together, new slabs are cut into batches as well.
+ * Batch is taken or returned by a single compare-and-swap, that is what magazines use.
+ *
+ * Slabs are never returned to the cache while pool is alive, destructor returns all of them at once, so all
+ * objects must be freed by then
+ */
+class Mempool {
+public:
+    /**
+     * Object size is rounded up to 8 bytes for sizes up to 8 and to 16 otherwise, objects are aligned the same
+     * way. Object must fit into a slab
+     * @param cache SlabCache
+     * @param object_size size_t
+     */
+    Mempool(SlabCache &cache, size_t object_size);
+    ~Mempool();
+
+    Mempool(const Mempool &) = delete;
+    Mempool &operator=(const Mempool &) = delete;
+
+    /**
+     * Returns an object, nullptr if arena is exhausted
+     */
+    void *alloc();
+
+    /**
+     * Returns object allocated by this pool back
+     * @param p void*
+     */
+    void free(void *p);
+
+    static const size_t BatchSize = 32;
+
+    /**
+     * Takes up to BatchSize objects at once, returns number of objects taken, 0 if arena is exhausted
+     * @param objects void*[BatchSize]
+     */
+    size_t alloc_batch(void **objects);
+
+    /**
+     * Returns count objects at once, full batch goes to the depot
+     * @param objects void*[count]
+     * @param count size_t
+     */
+    void free_batch(void **objects, size_t count);
+
+    size_t object_size() const { return _object_size; }
+
+    // Number of slabs taken by the pool
+    size_t slabs() const { return _nslabs.load(std::memory_order_relaxed); }
+
+    // Number of objects the slabs taken hold, live and free
+    size_t capacity() const { return slabs() * (_cache.arena().slab_size() / _object_size); }
+
+private:
+    static const size_t Stripes = 16;
+
+    // Each list takes its own cache line
+    struct Stripe {
+        std::atomic<uint64_t> head;
+        char pad[64 - sizeof(std::atomic<uint64_t>)];
+    };
+
+    // Takes an object from the list, steals other list if it is empty
+    void *Pop(size_t stripe);
+
+    // Moves all objects of other list into the given one and returns one of them
+    void *Steal(size_t stripe);
+
+    // Takes a new slab and puts it into the depot by batches, the incomplete one goes to the list
+    bool Carve();
+
+    SlabCache &_cache;
+    char *const _base;
+    const size_t _object_size;
+
+    Stripe _stripes[Stripes];
+
+    // Stack of batches, linked through the second word of the first object of a batch
+    Stripe _depot;
+
+    // Slabs taken from the cache, updated on carving only
+    std::mutex _slabs_m;
+    std::vector<void *> _slabs;
+    std::atomic<size_t> _nslabs;
+};
+
+/**
+ * Per-thread cache of up to Capacity objects of a pool. Empty magazine takes a batch from the pool, full one
+ * returns a half of its objects, so a thread allocating and freeing objects at about the same rate rarely
+ * goes to the pool. Objects freed by other threads than allocated them simply migrate between magazines.
+ *
+ * Meant to be a thread_local variable. Destructor returns all objects to the pool, magazine used after that
+ * passes calls to the pool directly
+ */
+class Magazine {
+public:
+    static const size_t Capacity = 2 * Mempool::BatchSize;
+
+    Magazine() : _pool(nullptr), _count(0), _limit(Capacity) {}
+    explicit Magazine(Mempool &pool) : _pool(&pool), _count(0), _limit(Capacity) {}
+    ~Magazine();
+
+    Magazine(const Magazine &) = delete;
+    Magazine &operator=(const Magazine &) = delete;
+
+    // Attaches default constructed magazine to the pool, must be done before the first use
+    void bind(Mempool &pool) { _pool = &pool; }
+
+    /**
+     * Returns an object, nullptr if arena is exhausted
+     */
+    void *alloc() { return _count > 0 ? _objects[--_count] : Refill(); }
+
+    /**
+     * Returns object of the pool back
+     * @param p void*
+     */
+    void free(void *p) {
+        if (_count < _limit) {
+            _objects[_count++] = p;
+        } else {
+            Drain(p);
+        }
+    }
+
+    // Number of cached objects
+    size_t size() const { return _count; }
+
+private:
+    void *Refill();
+    void Drain(void *p);
+
+    Mempool *_pool;
+    size_t _count;
+
+    // Capacity, 0 once magazine is destroyed
+    size_t _limit;
+
+    void *_objects[Capacity];
+};
+
+/**
+ * Process wide arena and slab cache shared by all default pools. Arena reserves as much address space as the
+ * system allows, up to MaxArenaSize
+ */
+Arena &DefaultArena();
+SlabCache &DefaultSlabCache();
+
+/**
+ * Base that makes objects of T allocated from the default slab cache by a pool of sizeof(T) objects through
+ * per-thread magazines. Objects of derived classes and objects that don't fit once arena is exhausted go to
+ * the global heap. Pool is never destroyed, so objects could be freed at any time up to the process exit.
+ *
+ * Usage: struct Connection : Allocator::SlabAllocated<Connection> { ... };
+ */
+template <typename T> class SlabAllocated {
+public:
+    static void *operator new(size_t size) {
+        void *p = size == sizeof(T) ? Cache().alloc() : nullptr;
+        return p != nullptr ? p : ::operator new(size);
+    }
+
+    static void operator delete(void *p) {
+        if (DefaultArena().contains(p)) {
+            Cache().free(p);
+        } else {
+            ::operator delete(p);
+        }
+    }
+
+    static Mempool &Pool() {
+        static Mempool *pool = new Mempool(DefaultSlabCache(), sizeof(T));
+        return *pool;
+    }
+
+    static Magazine &Cache() {
+        static thread_local Magazine magazine(Pool());
+        return magazine;
+    }
+};
+
+/**
+ * Buffers of variable size from the default slab cache. Size is rounded up to a power of two starting from
+ * MinBufferSize and buffers of each size come from their own pool through per-thread magazines. Buffers larger
+ * than MaxBufferSize are allocated on the global heap. Size passed to FreeBuffer must be the same as requested
+ */
+const size_t MinBufferSize = 64;
+const size_t MaxBufferSize = 64 * 1024;
+
+char *AllocBuffer(size_t size);
+void FreeBuffer(char *buffer, size_t size);
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_SLAB_H
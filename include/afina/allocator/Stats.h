@@ -0,0 +1,63 @@
+#ifndef AFINA_ALLOCATOR_STATS_H
+#define AFINA_ALLOCATOR_STATS_H
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Afina {
+namespace Allocator {
+
+/**
+ * # Allocator state
+ * The same set of numbers for every allocator, what "stats allocator" reports, so one alert on fragmentation
+ * or on the largest free block fits all of them. Each allocator fills it the way its memory is organized,
+ * see stats() of Simple, Buddy, Arena and Resource
+ */
+struct Stats {
+    // Bytes of the region or of the system memory the allocator manages
+    size_t reserved = 0;
+
+    // Bytes taken by live blocks, rounding included
+    size_t used = 0;
+
+    // Bytes that could still be allocated, some of them maybe only after defragmentation
+    size_t free = 0;
+
+    // Number of live blocks
+    size_t live = 0;
+
+    // Largest block that could be allocated right now
+    size_t largest_free = 0;
+
+    // Share of memory lost to fragmentation, from 0 to 1, as the allocator defines it
+    double fragmentation = 0;
+
+    // Number of free blocks by size class, class is the largest block size in it, in ascending order
+    std::vector<std::pair<size_t, size_t>> free_blocks;
+
+    /**
+     * Sums up state of another allocator of the same kind, fragmentation is weighted by free bytes
+     * @param other Stats
+     */
+    void merge(const Stats &other);
+
+    /**
+     * Appends "<prefix>:<field> <value>" pairs, free blocks go as "<prefix>:free_blocks_<class> <count>"
+     * @param prefix std::string
+     * @param out std::vector<std::pair<std::string, std::string>>
+     */
+    void report(const std::string &prefix, std::vector<std::pair<std::string, std::string>> &out) const;
+};
+
+/**
+ * Size class of a free block for allocators without classes of their own: power of two not less than size
+ * @param size size_t
+ */
+size_t SizeClass(size_t size);
+
+} // namespace Allocator
+} // namespace Afina
+
+#endif // AFINA_ALLOCATOR_STATS_H
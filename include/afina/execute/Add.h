@@ -4,6 +4,8 @@
 #include <cstdint>
 #include <string>
 
+#include <afina/allocator/Slab.h>
+
 #include "InsertCommand.h"
 
 namespace Afina {
@@ -18,7 +20,7 @@ namespace Execute {
  * - "NOT_STORED" to indicate the data was not stored, but not because of an
  * error. This normally means that the condition for the command wasn't met.
  */
-class Add : public InsertCommand {
+class Add : public InsertCommand, public Allocator::SlabAllocated<Add> {
 public:
     Add(const std::string &key, uint32_t flags, int32_t expire) : InsertCommand(key, flags, expire) {}
     ~Add() {}
@@ -10,8 +10,9 @@ class Storage;
 namespace Execute {
 
 /**
- *
- *
+ * # Command parsed out of the request
+ * Command object is created for every request, so commands of frequent requests are allocated from slab pools
+ * through per-thread magazines, see afina/allocator/Slab.h
  */
 class Command {
 public:
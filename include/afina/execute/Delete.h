@@ -1,6 +1,10 @@
 #ifndef AFINA_EXECUTE_DELETE_H
 #define AFINA_EXECUTE_DELETE_H
 
+#include <string>
+
+#include <afina/allocator/Slab.h>
+
 #include "Command.h"
 
 namespace Afina {
@@ -11,16 +15,25 @@ namespace Execute {
  * Delete existing key from the cache. If key not found then command does
  * nothing
  *
+ * delete <key> [noreply]\r\n
+ *
  * Command must write result to the output, which could be:
  * - "DELETED" to indicate success
  * - "NOT_FOUND" to indicate that the item with this key was not found
+ *
+ * With noreply server executes command and drops its result, see Protocol::Parser::NoReply
  */
-class Delete : public Command {
+class Delete : public Command, public Allocator::SlabAllocated<Delete> {
 public:
-    Delete();
-    ~Delete();
+    Delete(const std::string &key) : _key(key) {}
+    ~Delete() {}
+
+    inline const std::string &key() const { return _key; }
 
     void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+private:
+    std::string _key;
 };
 
 } // namespace Execute
@@ -0,0 +1,38 @@
+#ifndef AFINA_EXECUTE_FLUSH_ALL_H
+#define AFINA_EXECUTE_FLUSH_ALL_H
+
+#include <cstdint>
+#include <string>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Invalidate all items
+ * Optional argument is delay in seconds before items become invalid:
+ * flush_all [delay] [noreply]\r\n
+ *
+ * Reply is always:
+ * OK\r\n
+ *
+ * With noreply server executes command and drops its result, see Protocol::Parser::NoReply
+ */
+class FlushAll : public Command {
+public:
+    FlushAll(uint32_t delay = 0) : _delay(delay) {}
+    ~FlushAll() {}
+
+    inline uint32_t delay() const { return _delay; }
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+private:
+    uint32_t _delay;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_FLUSH_ALL_H
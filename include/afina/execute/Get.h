@@ -4,6 +4,9 @@
 #include <string>
 #include <vector>
 
+#include <afina/allocator/Resource.h>
+#include <afina/allocator/Slab.h>
+
 #include "Command.h"
 
 namespace Afina {
@@ -32,17 +35,26 @@ namespace Execute {
  * but deleted to make space for more items, or expired, or explicitly
  * deleted by a client).
  */
-class Get : public Command {
+class Get : public Command, public Allocator::SlabAllocated<Get> {
 public:
-    Get(const std::vector<std::string> &keys) : _keys(keys) {}
+    // List of keys could be taken from the arena of the request together with the keys themselves
+    typedef Allocator::Vector<Allocator::String> Keys;
+
+    Get(const std::vector<std::string> &keys, Allocator::Resource &resource = Allocator::DefaultResource())
+        : _keys(Keys::allocator_type(resource)) {
+        for (auto &key : keys) {
+            _keys.emplace_back(key.data(), key.size(), _keys.get_allocator());
+        }
+    }
+    Get(Keys &&keys) : _keys(std::move(keys)) {}
     ~Get() {}
 
-    inline const std::vector<std::string> &keys() const { return _keys; }
+    inline const Keys &keys() const { return _keys; }
 
     void Execute(Storage &storage, const std::string &args, std::string &out) override;
 
 private:
-    std::vector<std::string> _keys;
+    Keys _keys;
 };
 
 } // namespace Execute
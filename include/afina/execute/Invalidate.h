@@ -0,0 +1,38 @@
+#ifndef AFINA_EXECUTE_INVALIDATE_H
+#define AFINA_EXECUTE_INVALIDATE_H
+
+#include <string>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Invalidate key keeping its value for lease holders
+ * Key disappears for get, but the old value is still returned as stale by lget while the key is refilled,
+ * see Storage::Invalidate
+ *
+ * invalidate <key>\r\n
+ *
+ * Command must write result to the output, which could be:
+ * - "DELETED" to indicate success
+ * - "NOT_FOUND" to indicate that the item with this key was not found
+ */
+class Invalidate : public Command {
+public:
+    Invalidate(const std::string &key) : _key(key) {}
+    ~Invalidate() {}
+
+    inline const std::string &key() const { return _key; }
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+private:
+    std::string _key;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_INVALIDATE_H
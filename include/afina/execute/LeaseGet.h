@@ -0,0 +1,39 @@
+#ifndef AFINA_EXECUTE_LEASE_GET_H
+#define AFINA_EXECUTE_LEASE_GET_H
+
+#include <string>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Get value or lease to refill it
+ * Protects backing store from the stampede of misses, see Storage::LeaseGet
+ *
+ * lget <key>\r\n
+ *
+ * Reply is terminated by "END" and starts with one of:
+ * - "VALUE <key> <flags> <bytes>\r\n<data>" if key is found
+ * - "LEASE <key> <token>" if key is missing and client is expected to refill it with lset
+ * - "STALE <key> <flags> <bytes>\r\n<data>" if other client refills invalidated key, data is the old value
+ * - "WAIT <key>" if other client refills the key, client should retry later
+ */
+class LeaseGet : public Command {
+public:
+    LeaseGet(const std::string &key) : _key(key) {}
+    ~LeaseGet() {}
+
+    inline const std::string &key() const { return _key; }
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+private:
+    std::string _key;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_LEASE_GET_H
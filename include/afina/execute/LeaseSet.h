@@ -0,0 +1,39 @@
+#ifndef AFINA_EXECUTE_LEASE_SET_H
+#define AFINA_EXECUTE_LEASE_SET_H
+
+#include <cstdint>
+#include <string>
+
+#include "InsertCommand.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Refill key under lease
+ * Stores value only if lease returned by lget is still valid
+ *
+ * lset <key> <flags> <exptime> <bytes> <token>\r\n<data>\r\n
+ *
+ * Command must write result to the output, which could be:
+ * - "STORED", to indicate success.
+ * - "NOT_STORED" if lease is not valid anymore: key has been written or invalidated since then
+ */
+class LeaseSet : public InsertCommand {
+public:
+    LeaseSet(const std::string &key, uint32_t flags, int32_t expire, uint64_t token)
+        : InsertCommand(key, flags, expire), _token(token) {}
+    ~LeaseSet() {}
+
+    inline uint64_t token() const { return _token; }
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+private:
+    uint64_t _token;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_LEASE_SET_H
@@ -0,0 +1,35 @@
+#ifndef AFINA_EXECUTE_LOAD_H
+#define AFINA_EXECUTE_LOAD_H
+
+#include <string>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Replace storage content with the dump
+ * Admin command, dump file must be located on the server:
+ * load <path>\r\n
+ *
+ * Reply contains number of loaded items:
+ * LOADED <items>\r\n
+ */
+class Load : public Command {
+public:
+    Load(const std::string &path) : _path(path) {}
+    ~Load() {}
+
+    inline const std::string &path() const { return _path; }
+
+    void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+private:
+    std::string _path;
+};
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_LOAD_H
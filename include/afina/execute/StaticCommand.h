@@ -0,0 +1,95 @@
+#ifndef AFINA_EXECUTE_STATIC_COMMAND_H
+#define AFINA_EXECUTE_STATIC_COMMAND_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Command.h"
+
+namespace Afina {
+namespace Execute {
+
+/**
+ * # Command variant for the compile time composed pipeline
+ * Hot commands are kept inline as a kind and keys, so parsing them allocates no command object and executing
+ * them is a switch calling storage of the concrete type directly. Everything else is held as a regular
+ * Command and executed through the virtual call.
+ *
+ * Instance is supposed to be reused for the whole connection, so keys keep their capacity between commands
+ */
+class StaticCommand {
+public:
+    enum class Kind : uint8_t { None, Get, Set, Add, Append, Delete, Dynamic };
+
+    StaticCommand() : kind(Kind::None) {}
+
+    void Reset() {
+        kind = Kind::None;
+        keys.clear();
+        dynamic.reset();
+    }
+
+    Kind kind;
+
+    // Keys of the inline command, exactly one for everything but get
+    std::vector<std::string> keys;
+
+    // Command of the Dynamic kind
+    std::unique_ptr<Command> dynamic;
+};
+
+/**
+ * Executes command on the storage and appends reply to the output, networking layer should add the last \r\n.
+ * Replies are the same as of the Command implementations. TStorage must be the final type of the storage,
+ * otherwise calls stay virtual
+ */
+template <typename TStorage>
+void ExecuteStatic(TStorage &storage, const StaticCommand &cmd, const std::string &args, std::string &out) {
+    switch (cmd.kind) {
+    case StaticCommand::Kind::Get: {
+        std::string value;
+        for (auto &key : cmd.keys) {
+            if (storage.Get(key, value)) {
+                out.append("VALUE ").append(key).append(" 0 ").append(std::to_string(value.size())).append("\r\n");
+                out.append(value).append("\r\n");
+            }
+        }
+        out.append("END");
+        break;
+    }
+
+    case StaticCommand::Kind::Set:
+        storage.Put(cmd.keys[0], args);
+        out.append("STORED");
+        break;
+
+    case StaticCommand::Kind::Add:
+        out.append(storage.PutIfAbsent(cmd.keys[0], args) ? "STORED" : "NOT_STORED");
+        break;
+
+    case StaticCommand::Kind::Append:
+        out.append(storage.Append(cmd.keys[0], args) ? "STORED" : "NOT_STORED");
+        break;
+
+    case StaticCommand::Kind::Delete:
+        out.append(storage.Delete(cmd.keys[0]) ? "DELETED" : "NOT_FOUND");
+        break;
+
+    case StaticCommand::Kind::Dynamic: {
+        std::string reply;
+        cmd.dynamic->Execute(storage, args, reply);
+        out.append(reply);
+        break;
+    }
+
+    case StaticCommand::Kind::None:
+        break;
+    }
+}
+
+} // namespace Execute
+} // namespace Afina
+
+#endif // AFINA_EXECUTE_STATIC_COMMAND_H
@@ -2,17 +2,43 @@
 #define AFINA_EXECUTE_STATS_H
 
 #include <string>
+#include <vector>
 
 #include "Command.h"
 
 namespace Afina {
 namespace Execute {
 
+/**
+ * # Report server statistics
+ * Optional argument selects group of statistics, for example "stats items". Group "pools" reports usage of
+ * memory pools containers are allocated from, see Allocator::Resource, rather than storage statistics.
+ * Group "allocator" reports Allocator::Stats of the same pools, of the slab arena and of allocators storage
+ * owns
+ *
+ * Each statistics line looks like this:
+ * STAT <name> <value>\r\n
+ * ...
+ * END
+ */
 class Stats : public Command {
 public:
-    Stats() {}
+    Stats(const std::string &group = "") : _group(group) {}
     ~Stats() {}
+
+    inline const std::string &group() const { return _group; }
+
     void Execute(Storage &storage, const std::string &args, std::string &out) override;
+
+    /**
+     * Merges outputs of the same command executed by several storage partitions into a single reply. Stats are
+     * matched by name: integers and lists of them are summed up, fractions are averaged over outputs reporting
+     * them, anything else is taken from the first output. Names keep the order they first appear in
+     */
+    static void Merge(const std::vector<const std::string *> &outputs, std::string &out);
+
+private:
+    std::string _group;
 };
 
 } // namespace Execute
@@ -2,7 +2,7 @@
 use 5.016;
 use warnings;
 use threads;
-use Test::More tests => 85;
+use Test::More tests => 106;
 use IO::Socket::INET;
 use Getopt::Long;
 
@@ -170,16 +170,29 @@ TODO: {
 	);
 }
 
-TODO: {
-	local $TODO = "Delete command isn't yet implemented";
+afina_test(
+	"delete test\r\n",
+	"DELETED\r\n",
+	"Delete a key",
+	1
+);
 
-	afina_test(
-		"delete test\r\n",
-		"DELETED\r\n",
-		"Delete a key",
-		1
-	);
-}
+afina_test(
+	"delete test\r\n",
+	"NOT_FOUND\r\n",
+	"Don't delete non-existent key",
+	1
+);
+
+afina_test(
+	"set test 0 0 3\r\nzzz\r\n"
+	."delete test noreply\r\n"
+	."get test\r\n",
+	"STORED\r\n"
+	."END\r\n",
+	"Delete a key without reply",
+	1
+);
 
 afina_test(
 	"blablabla 0 0 0\r\n",
@@ -217,3 +230,32 @@ afina_test(
 	"Correct result of partially written command",
 	0
 );
+
+SKIP: {
+	skip "Connection reset needs a socket", 6 if defined $rfifo;
+
+	# Replies are written to the peer that has already reset the connection, server must drop them and
+	# keep serving others
+	my $socket = IO::Socket::INET::->new(PeerAddr => "$server:$port", Proto => "tcp");
+	ok($socket, "Connected to Afina to reset connection");
+	$socket->autoflush(1);
+	print $socket "get foo\r\n" x 10000;
+	setsockopt($socket, SOL_SOCKET, SO_LINGER, pack("ii", 1, 0));
+	close($socket);
+	select(undef, undef, undef, .5);
+
+	afina_test(
+		"get foo\r\n",
+		"VALUE foo 0 3\r\nwtf\r\nEND\r\n",
+		"Server survives replies to the reset connection",
+		0
+	);
+}
+
+afina_test(
+	"flush_all noreply\r\n"
+	."get foo\r\n",
+	"END\r\n",
+	"Flush all without reply",
+	1
+);
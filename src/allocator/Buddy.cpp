@@ -0,0 +1,256 @@
+#include <afina/allocator/Buddy.h>
+
+#include <cstring>
+#include <sstream>
+#include <sys/mman.h>
+
+#include <afina/allocator/Error.h>
+
+namespace Afina {
+namespace Allocator {
+
+// Header of the first page of a block, headers of the other pages are zero
+struct Buddy::Page {
+    enum State : uint8_t { Inner = 0, Free, Allocated };
+
+    struct Links {
+        uint32_t prev;
+        uint32_t next;
+    };
+
+    union {
+        // Allocated block
+        uint64_t requested;
+
+        // Free block, page indices
+        Links links;
+    };
+    uint8_t order;
+    uint8_t state;
+};
+
+const size_t Buddy::DefaultPageSize;
+const size_t Buddy::MaxOrders;
+const uint32_t Buddy::None;
+
+// See Buddy.h
+Buddy::Buddy(void *base, size_t size, size_t page_size, size_t release_size)
+    : _page_size(page_size), _page_shift(0), _table(nullptr), _blocks(nullptr), _pages(0), _top_size(0),
+      _release_order(MaxOrders), _released(0), _allocated(0), _requested(0), _live(0) {
+    while ((size_t(1) << _page_shift) < page_size) {
+        _page_shift++;
+    }
+    if (release_size > 0) {
+        _release_order = OrderOf(release_size);
+    }
+
+    uintptr_t start = (reinterpret_cast<uintptr_t>(base) + alignof(Page) - 1) & ~(alignof(Page) - 1);
+    uintptr_t end = reinterpret_cast<uintptr_t>(base) + size;
+    size_t pages = end > start ? (end - start) / (page_size + sizeof(Page)) : 0;
+    pages = pages < None ? pages : None - 1;
+
+    // Alignment of the blocks area could take a page more
+    uintptr_t blocks = 0;
+    while (pages > 0) {
+        blocks = (start + pages * sizeof(Page) + page_size - 1) & ~(page_size - 1);
+        if (blocks + pages * page_size <= end) {
+            break;
+        }
+        pages--;
+    }
+
+    _table = reinterpret_cast<Page *>(start);
+    _blocks = reinterpret_cast<char *>(blocks);
+    _pages = pages;
+    if (_pages > 0) {
+        std::memset(_table, 0, _pages * sizeof(Page));
+    }
+    for (size_t order = 0; order < MaxOrders; order++) {
+        _free[order] = None;
+        _free_count[order] = 0;
+    }
+
+    size_t page = 0;
+    for (size_t order = MaxOrders; order-- > 0;) {
+        if (_pages - page >= (size_t(1) << order)) {
+            Push(page, order);
+            page += size_t(1) << order;
+            _top_size = _top_size > 0 ? _top_size : size_t(1) << (order + _page_shift);
+        }
+    }
+}
+
+// See Buddy.h
+void *Buddy::alloc(size_t N) {
+    size_t order = OrderOf(N);
+    size_t from = order;
+    while (from < MaxOrders && _free[from] == None) {
+        from++;
+    }
+    if (from >= MaxOrders) {
+        throw AllocError(AllocErrorType::NoMemory, "No block of " + std::to_string(N) + " bytes available");
+    }
+
+    uint32_t page = _free[from];
+    Unlink(page, from);
+    while (from > order) {
+        from--;
+        Push(page + (uint32_t(1) << from), from);
+    }
+
+    _table[page].requested = N;
+    _table[page].order = order;
+    _table[page].state = Page::Allocated;
+    _allocated += size_t(1) << (order + _page_shift);
+    _requested += N;
+    _live++;
+    return _blocks + (size_t(page) << _page_shift);
+}
+
+// See Buddy.h
+void Buddy::free(void *p) {
+    if (p == nullptr) {
+        return;
+    }
+
+    size_t offset = static_cast<char *>(p) - _blocks;
+    if (!contains(p) || (offset & (_page_size - 1)) != 0 || _table[offset >> _page_shift].state != Page::Allocated) {
+        throw AllocError(AllocErrorType::InvalidFree, "Address is not allocated by this allocator");
+    }
+
+    uint32_t page = offset >> _page_shift;
+    size_t order = _table[page].order;
+    _allocated -= size_t(1) << (order + _page_shift);
+    _requested -= _table[page].requested;
+    _live--;
+
+    while (order + 1 < MaxOrders) {
+        uint32_t buddy = page ^ (uint32_t(1) << order);
+        if (buddy + (size_t(1) << order) > _pages || _table[buddy].state != Page::Free ||
+            _table[buddy].order != order) {
+            break;
+        }
+
+        Unlink(buddy, order);
+        _table[buddy].state = Page::Inner;
+        _table[page].state = Page::Inner;
+        page = page < buddy ? page : buddy;
+        order++;
+    }
+    Push(page, order);
+
+    // Block is free and is never touched until allocated, so its pages could go. Part of them could be
+    // released already, kernel skips pages that aren't committed
+    if (order >= _release_order) {
+        size_t bytes = size_t(1) << (order + _page_shift);
+        if (madvise(_blocks + (size_t(page) << _page_shift), bytes, MADV_DONTNEED) == 0) {
+            _released += bytes;
+        }
+    }
+}
+
+// See Buddy.h
+std::string Buddy::dump() const {
+    std::stringstream ss;
+    ss << "capacity " << capacity() << "\n"
+       << "page_size " << _page_size << "\n"
+       << "allocated " << _allocated << "\n"
+       << "requested " << _requested << "\n"
+       << "live " << _live << "\n"
+       << "released " << _released << "\n"
+       << "available " << available() << "\n"
+       << "largest_free_block " << largest_free() << "\n"
+       << "internal_fragmentation " << internal_fragmentation() << "\n"
+       << "external_fragmentation " << external_fragmentation() << "\n";
+    for (size_t order = 0; order < MaxOrders; order++) {
+        if (_free_count[order] > 0) {
+            ss << "free_blocks_" << (size_t(1) << (order + _page_shift)) << " " << _free_count[order] << "\n";
+        }
+    }
+    return ss.str();
+}
+
+// See Buddy.h
+Stats Buddy::stats() const {
+    Stats stats;
+    stats.reserved = capacity();
+    stats.used = _allocated;
+    stats.free = available();
+    stats.live = _live;
+    stats.largest_free = largest_free();
+    stats.fragmentation = external_fragmentation();
+    for (size_t order = 0; order < MaxOrders; order++) {
+        if (_free_count[order] > 0) {
+            stats.free_blocks.emplace_back(size_t(1) << (order + _page_shift), _free_count[order]);
+        }
+    }
+    return stats;
+}
+
+// See Buddy.h
+size_t Buddy::largest_free() const {
+    for (size_t order = MaxOrders; order-- > 0;) {
+        if (_free_count[order] > 0) {
+            return size_t(1) << (order + _page_shift);
+        }
+    }
+    return 0;
+}
+
+// See Buddy.h
+double Buddy::internal_fragmentation() const {
+    if (_allocated == 0) {
+        return 0;
+    }
+    return 1 - double(_requested) / _allocated;
+}
+
+// See Buddy.h
+double Buddy::external_fragmentation() const {
+    size_t available = this->available() < _top_size ? this->available() : _top_size;
+    if (available == 0) {
+        return 0;
+    }
+    return 1 - double(largest_free()) / available;
+}
+
+// See Buddy.h
+size_t Buddy::OrderOf(size_t N) const {
+    size_t pages = N == 0 ? 1 : ((N - 1) >> _page_shift) + 1;
+    size_t order = 0;
+    while (order < MaxOrders && (size_t(1) << order) < pages) {
+        order++;
+    }
+    return order;
+}
+
+// See Buddy.h
+void Buddy::Push(uint32_t page, size_t order) {
+    Page &head = _table[page];
+    head.links.prev = None;
+    head.links.next = _free[order];
+    head.order = order;
+    head.state = Page::Free;
+    if (_free[order] != None) {
+        _table[_free[order]].links.prev = page;
+    }
+    _free[order] = page;
+    _free_count[order]++;
+}
+
+// See Buddy.h
+void Buddy::Unlink(uint32_t page, size_t order) {
+    Page &head = _table[page];
+    if (head.links.prev != None) {
+        _table[head.links.prev].links.next = head.links.next;
+    } else {
+        _free[order] = head.links.next;
+    }
+    if (head.links.next != None) {
+        _table[head.links.next].links.prev = head.links.prev;
+    }
+    _free_count[order]--;
+}
+
+} // namespace Allocator
+} // namespace Afina
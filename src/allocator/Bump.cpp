@@ -0,0 +1,116 @@
+#include <afina/allocator/Bump.h>
+
+#include <afina/allocator/Slab.h>
+
+namespace Afina {
+namespace Allocator {
+
+namespace {
+
+const size_t Alignment = 16;
+
+size_t Round(size_t size, size_t to) { return (size + to - 1) & ~(to - 1); }
+
+} // namespace
+
+const size_t Bump::DefaultChunkSize;
+
+// See Bump.h
+Bump::Bump(const std::string &name, size_t chunk_size)
+    : Resource(name), _chunk_size(Round(chunk_size < 256 ? 256 : chunk_size, 256)), _first(nullptr),
+      _current(nullptr), _top(nullptr), _end(nullptr), _large(nullptr), _chunks(0), _resets(0) {}
+
+// See Bump.h
+Bump::~Bump() {
+    reset();
+    while (_first != nullptr) {
+        Chunk *next = _first->next;
+        FreeBuffer(reinterpret_cast<char *>(_first), _chunk_size);
+        _first = next;
+    }
+}
+
+// See Bump.h
+void Bump::reset() {
+    while (_large != nullptr) {
+        Large *next = _large->next;
+        FreeBuffer(reinterpret_cast<char *>(_large), _large->size);
+        _large = next;
+    }
+
+    _current = _first;
+    if (_current != nullptr) {
+        _top = reinterpret_cast<char *>(_current) + Round(sizeof(Chunk), Alignment);
+        _end = reinterpret_cast<char *>(_current) + _chunk_size;
+    }
+    _resets++;
+}
+
+// See Bump.h
+void *Bump::Allocate(size_t size) {
+    size = Round(size == 0 ? 1 : size, Alignment);
+    if (size > _chunk_size / 4) {
+        return AllocLarge(size);
+    }
+
+    if (static_cast<size_t>(_end - _top) < size) {
+        return Grow(size);
+    }
+    void *p = _top;
+    _top += size;
+    return p;
+}
+
+// See Bump.h
+void Bump::Deallocate(void *p, size_t size) {
+    size = Round(size == 0 ? 1 : size, Alignment);
+    if (size <= _chunk_size / 4) {
+        if (static_cast<char *>(p) + size == _top) {
+            _top = static_cast<char *>(p);
+        }
+        return;
+    }
+
+    Large *block = reinterpret_cast<Large *>(static_cast<char *>(p) - Round(sizeof(Large), Alignment));
+    for (Large **link = &_large; *link != nullptr; link = &(*link)->next) {
+        if (*link == block) {
+            *link = block->next;
+            FreeBuffer(reinterpret_cast<char *>(block), block->size);
+            return;
+        }
+    }
+}
+
+// See Bump.h
+void *Bump::Grow(size_t size) {
+    if (_current == nullptr || _current->next == nullptr) {
+        Chunk *chunk = reinterpret_cast<Chunk *>(AllocBuffer(_chunk_size));
+        chunk->next = nullptr;
+        if (_current == nullptr) {
+            _first = chunk;
+        } else {
+            _current->next = chunk;
+        }
+        _chunks++;
+        _current = chunk;
+    } else {
+        _current = _current->next;
+    }
+
+    _top = reinterpret_cast<char *>(_current) + Round(sizeof(Chunk), Alignment) + size;
+    _end = reinterpret_cast<char *>(_current) + _chunk_size;
+    return _top - size;
+}
+
+// See Bump.h
+void *Bump::AllocLarge(size_t size) {
+    size_t total = Round(sizeof(Large), Alignment) + size;
+    Large *block = reinterpret_cast<Large *>(AllocBuffer(total));
+    block->next = _large;
+    block->size = total;
+    _large = block;
+    return reinterpret_cast<char *>(block) + Round(sizeof(Large), Alignment);
+}
+
+} // namespace Allocator
+} // namespace Afina
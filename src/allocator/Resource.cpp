@@ -0,0 +1,379 @@
+#include <afina/allocator/Resource.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <afina/allocator/Error.h>
+
+namespace Afina {
+namespace Allocator {
+
+// Counters of a single slot, padded to the cache line so slots of different threads rarely share one. Bytes and
+// blocks could go below zero in a slot of the thread that frees blocks allocated by other ones
+struct Resource::Counters {
+    std::atomic<int64_t> bytes;
+    std::atomic<int64_t> blocks;
+    std::atomic<uint64_t> allocations;
+    std::atomic<uint64_t> failures;
+
+    // The largest number of bytes in the slot, peak is updated once it grows
+    std::atomic<int64_t> peak;
+    char padding[64 - 5 * sizeof(int64_t)];
+
+    Counters() : bytes(0), blocks(0), allocations(0), failures(0), peak(0) {}
+};
+
+// Resources created by a single thread. Shard belongs to a thread for its lifetime and is given to a new thread
+// after, resources that outlive the thread stay in it
+struct Resource::Shard {
+    std::mutex m;
+    std::vector<Resource *> resources;
+    bool taken;
+};
+
+// Shards of live resources. Registry is never destroyed, so resources could be static objects destroyed in
+// any order
+struct Resource::Registry {
+    std::mutex m;
+    std::vector<Shard *> shards;
+};
+
+// See Resource.h
+Resource::Registry &Resource::Resources() {
+    static Registry *registry = new Registry();
+    return *registry;
+}
+
+// See Resource.h
+Resource::Shard &Resource::LocalShard() {
+    // Registry lock is taken once per thread only, shard is given back once thread exits
+    struct Holder {
+        Shard *shard = nullptr;
+        ~Holder() {
+            if (shard != nullptr) {
+                std::lock_guard<std::mutex> lock(Resources().m);
+                shard->taken = false;
+            }
+        }
+    };
+    thread_local Holder holder;
+
+    if (holder.shard == nullptr) {
+        Registry &registry = Resources();
+        std::lock_guard<std::mutex> lock(registry.m);
+        for (Shard *shard : registry.shards) {
+            if (!shard->taken) {
+                holder.shard = shard;
+                break;
+            }
+        }
+        if (holder.shard == nullptr) {
+            holder.shard = new Shard();
+            registry.shards.push_back(holder.shard);
+        }
+        holder.shard->taken = true;
+    }
+    return *holder.shard;
+}
+
+namespace {
+
+// Counter slot of the calling thread
+size_t LocalSlot(size_t slots) {
+    static std::atomic<size_t> next(0);
+    thread_local size_t slot = next.fetch_add(1, std::memory_order_relaxed);
+    return slot % slots;
+}
+
+} // namespace
+
+const size_t Resource::CounterSlots;
+const size_t SlabResource::MaxObjectSize;
+const size_t SlabResource::Granularity;
+const size_t SlabResource::Classes;
+
+// See Resource.h
+Resource::Resource(const std::string &name) : _name(name), _shard(&LocalShard()), _peak(0) {
+    for (auto &counters : _counters) {
+        counters.store(nullptr, std::memory_order_relaxed);
+    }
+
+    std::lock_guard<std::mutex> lock(_shard->m);
+    _index = _shard->resources.size();
+    _shard->resources.push_back(this);
+}
+
+// See Resource.h
+Resource::~Resource() {
+    {
+        std::lock_guard<std::mutex> lock(_shard->m);
+        Resource *last = _shard->resources.back();
+        _shard->resources[_index] = last;
+        last->_index = _index;
+        _shard->resources.pop_back();
+    }
+
+    for (auto &counters : _counters) {
+        delete counters.load(std::memory_order_relaxed);
+    }
+}
+
+// See Resource.h
+void *Resource::allocate(size_t size) {
+    Counters &counters = Local();
+    counters.allocations.fetch_add(1, std::memory_order_relaxed);
+    void *p = Allocate(size);
+    if (p == nullptr) {
+        counters.failures.fetch_add(1, std::memory_order_relaxed);
+        throw std::bad_alloc();
+    }
+
+    counters.blocks.fetch_add(1, std::memory_order_relaxed);
+    int64_t bytes = counters.bytes.fetch_add(size, std::memory_order_relaxed) + size;
+    if (bytes > counters.peak.load(std::memory_order_relaxed)) {
+        counters.peak.store(bytes, std::memory_order_relaxed);
+        UpdatePeak();
+    }
+    return p;
+}
+
+// See Resource.h
+void Resource::deallocate(void *p, size_t size) {
+    if (p == nullptr) {
+        return;
+    }
+    Deallocate(p, size);
+
+    Counters &counters = Local();
+    counters.blocks.fetch_sub(1, std::memory_order_relaxed);
+    counters.bytes.fetch_sub(size, std::memory_order_relaxed);
+}
+
+// See Resource.h
+size_t Resource::bytes() const { return std::max<int64_t>(0, Sum(&Counters::bytes)); }
+
+// See Resource.h
+size_t Resource::peak() const {
+    UpdatePeak();
+    return _peak.load(std::memory_order_relaxed);
+}
+
+// See Resource.h
+size_t Resource::blocks() const { return std::max<int64_t>(0, Sum(&Counters::blocks)); }
+
+// See Resource.h
+uint64_t Resource::allocations() const { return Sum(&Counters::allocations); }
+
+// See Resource.h
+uint64_t Resource::failures() const { return Sum(&Counters::failures); }
+
+// See Resource.h
+Resource::Counters &Resource::Local() {
+    std::atomic<Counters *> &slot = _counters[LocalSlot(CounterSlots)];
+    Counters *counters = slot.load(std::memory_order_acquire);
+    if (counters == nullptr) {
+        Counters *created = new Counters();
+        if (slot.compare_exchange_strong(counters, created, std::memory_order_acq_rel)) {
+            counters = created;
+        } else {
+            delete created;
+        }
+    }
+    return *counters;
+}
+
+// See Resource.h
+template <typename T> T Resource::Sum(std::atomic<T> Counters::*counter) const {
+    T sum = 0;
+    for (auto &slot : _counters) {
+        Counters *counters = slot.load(std::memory_order_acquire);
+        if (counters != nullptr) {
+            sum += (counters->*counter).load(std::memory_order_relaxed);
+        }
+    }
+    return sum;
+}
+
+// See Resource.h
+void Resource::UpdatePeak() const {
+    size_t bytes = this->bytes();
+    size_t peak = _peak.load(std::memory_order_relaxed);
+    while (bytes > peak && !_peak.compare_exchange_weak(peak, bytes, std::memory_order_relaxed)) {
+    }
+}
+
+// See Resource.h
+Stats Resource::stats() const {
+    Stats stats;
+    stats.reserved = bytes();
+    stats.used = stats.reserved;
+    stats.live = blocks();
+    return stats;
+}
+
+// See Resource.h
+void Resource::ForEach(const std::function<void(const Resource &)> &visitor) {
+    Registry &registry = Resources();
+    std::lock_guard<std::mutex> lock(registry.m);
+    for (Shard *shard : registry.shards) {
+        std::lock_guard<std::mutex> shard_lock(shard->m);
+        for (Resource *resource : shard->resources) {
+            visitor(*resource);
+        }
+    }
+}
+
+// See Resource.h
+void *HeapResource::Allocate(size_t size) { return ::operator new(size, std::nothrow); }
+
+// See Resource.h
+void HeapResource::Deallocate(void *p, size_t size) { ::operator delete(p); }
+
+// See Resource.h
+void *SimpleResource::Allocate(size_t size) {
+    std::lock_guard<std::mutex> lock(_m);
+    try {
+        return _allocator.alloc_fixed(size);
+    } catch (AllocError &) {
+        return nullptr;
+    }
+}
+
+// See Resource.h
+void SimpleResource::Deallocate(void *p, size_t size) {
+    std::lock_guard<std::mutex> lock(_m);
+    _allocator.free_fixed(p);
+}
+
+// See Resource.h
+Stats SimpleResource::stats() const {
+    std::lock_guard<std::mutex> lock(_m);
+    return _allocator.stats();
+}
+
+// See Resource.h
+void BuddyResource::inspect(const std::function<void(const Buddy &)> &visitor) const {
+    std::lock_guard<std::mutex> lock(_m);
+    visitor(_allocator);
+}
+
+// See Resource.h
+Stats BuddyResource::stats() const {
+    std::lock_guard<std::mutex> lock(_m);
+    return _allocator.stats();
+}
+
+// See Resource.h
+void *BuddyResource::Allocate(size_t size) {
+    if (size >= _min_size) {
+        std::lock_guard<std::mutex> lock(_m);
+        try {
+            return _allocator.alloc(size);
+        } catch (AllocError &) {
+            _overflows.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    return ::operator new(size, std::nothrow);
+}
+
+// See Resource.h
+void BuddyResource::Deallocate(void *p, size_t size) {
+    if (size < _min_size || !_allocator.contains(p)) {
+        ::operator delete(p);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(_m);
+    _allocator.free(p);
+}
+
+// See Resource.h
+SlabResource::SlabResource(const std::string &name, SlabCache &cache) : Resource(name), _cache(cache) {
+    for (auto &pool : _pools) {
+        pool.store(nullptr, std::memory_order_relaxed);
+    }
+    for (auto &objects : _objects) {
+        objects.store(0, std::memory_order_relaxed);
+    }
+}
+
+// See Resource.h
+SlabResource::~SlabResource() {
+    for (auto &pool : _pools) {
+        delete pool.load(std::memory_order_relaxed);
+    }
+}
+
+// See Resource.h
+void *SlabResource::Allocate(size_t size) {
+    Mempool *pool = size <= MaxObjectSize ? Pool(size) : nullptr;
+    void *p = pool != nullptr ? pool->alloc() : nullptr;
+    if (p == nullptr) {
+        return ::operator new(size, std::nothrow);
+    }
+    _objects[ClassOf(size)].fetch_add(1, std::memory_order_relaxed);
+    return p;
+}
+
+// See Resource.h
+void SlabResource::Deallocate(void *p, size_t size) {
+    if (size > MaxObjectSize || !_cache.arena().contains(p)) {
+        ::operator delete(p);
+        return;
+    }
+    Pool(size)->free(p);
+    _objects[ClassOf(size)].fetch_sub(1, std::memory_order_relaxed);
+}
+
+// See Resource.h
+Stats SlabResource::stats() const {
+    Stats stats;
+    size_t outgrown = 0;
+    for (size_t cls = 0; cls < Classes; cls++) {
+        Mempool *pool = _pools[cls].load(std::memory_order_acquire);
+        if (pool == nullptr) {
+            continue;
+        }
+
+        // Counters are read one after another, so they could disagree for a moment
+        size_t capacity = pool->capacity();
+        size_t objects = std::min(_objects[cls].load(std::memory_order_relaxed), capacity);
+        stats.reserved += pool->slabs() * _cache.arena().slab_size();
+        stats.used += objects * pool->object_size();
+        size_t free = (capacity - objects) * pool->object_size();
+        stats.free += free;
+        stats.live += objects;
+        outgrown += free > _cache.arena().slab_size() ? free - _cache.arena().slab_size() : 0;
+        if (capacity > objects) {
+            stats.largest_free = pool->object_size();
+            stats.free_blocks.emplace_back(pool->object_size(), capacity - objects);
+        }
+    }
+    stats.fragmentation = stats.reserved == 0 ? 0 : double(outgrown) / stats.reserved;
+    return stats;
+}
+
+// See Resource.h
+Mempool *SlabResource::Pool(size_t size) {
+    size_t cls = ClassOf(size);
+    Mempool *pool = _pools[cls].load(std::memory_order_acquire);
+    if (pool != nullptr) {
+        return pool;
+    }
+
+    std::lock_guard<std::mutex> lock(_pools_m);
+    pool = _pools[cls].load(std::memory_order_relaxed);
+    if (pool == nullptr) {
+        pool = new Mempool(_cache, (cls + 1) * Granularity);
+        _pools[cls].store(pool, std::memory_order_release);
+    }
+    return pool;
+}
+
+// See Resource.h
+Resource &DefaultResource() {
+    static HeapResource *resource = new HeapResource("heap");
+    return *resource;
+}
+
+} // namespace Allocator
+} // namespace Afina
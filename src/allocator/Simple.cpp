@@ -1,40 +1,547 @@
 #include <afina/allocator/Simple.h>
 
+#include <cstring>
+#include <map>
+#include <sstream>
+
+#include <afina/allocator/Error.h>
 #include <afina/allocator/Pointer.h>
 
 namespace Afina {
 namespace Allocator {
 
-Simple::Simple(void *base, size_t size) : _base(base), _base_len(size) {}
-
 /**
- * TODO: semantics
- * @param N size_t
+ * Header preceding every block. Free block keeps links of the free list in its payload
  */
-Pointer Simple::alloc(size_t N) { return Pointer(); }
+struct Simple::Block {
+    // Payload size, multiple of Alignment
+    size_t size;
 
-/**
- * TODO: semantics
- * @param p Pointer
- * @param N size_t
- */
-void Simple::realloc(Pointer &p, size_t N) {}
+    // Descriptor of the live block, nullptr for free one
+    void **slot;
 
-/**
- * TODO: semantics
- * @param p Pointer
- */
-void Simple::free(Pointer &p) {}
+    struct Links {
+        Block *prev;
+        Block *next;
+    };
 
-/**
- * TODO: semantics
- */
-void Simple::defrag() {}
+    void *payload() { return this + 1; }
+    Links *links() { return static_cast<Links *>(payload()); }
+    Block *next() { return reinterpret_cast<Block *>(static_cast<char *>(payload()) + size); }
+    size_t total() const { return sizeof(Block) + size; }
+};
 
-/**
- * TODO: semantics
- */
-std::string Simple::dump() const { return ""; }
+namespace {
+
+const size_t Alignment = 2 * sizeof(void *);
+
+// Free block must be able to hold free list links
+const size_t MinSize = 2 * sizeof(void *);
+
+// Descriptor of fixed blocks, shared by all of them and never dereferenced
+void *FixedSlot = nullptr;
+void **const Fixed = &FixedSlot;
+
+size_t Round(size_t size) {
+    size = (size + Alignment - 1) & ~(Alignment - 1);
+    return size < MinSize ? MinSize : size;
+}
+
+} // namespace
+
+// See Simple.h
+Simple::Simple(void *base, size_t size)
+    : _base(base), _base_len(size), _free_slots(nullptr), _free_blocks(nullptr), _free_bytes(0), _used(0),
+      _live(0), _fixed(0), _moved(0), _steps(0), _pause_max(0), _pause_total(0) {
+    uintptr_t begin = (reinterpret_cast<uintptr_t>(base) + Alignment - 1) & ~(Alignment - 1);
+    uintptr_t end = (reinterpret_cast<uintptr_t>(base) + size) & ~(sizeof(void *) - 1);
+    if (end < begin) {
+        end = begin;
+    }
+
+    _begin = _top = _cursor = reinterpret_cast<char *>(begin);
+    _slots = _slots_end = reinterpret_cast<void **>(end);
+}
+
+// See Simple.h
+Simple::Block *Simple::BlockOf(void *ptr) { return static_cast<Block *>(ptr) - 1; }
+
+// See Simple.h
+Pointer Simple::alloc(size_t N) {
+    size_t size = Round(N);
+    void **slot = TakeSlot();
+
+    Block *block = Place(size);
+    if (block == nullptr) {
+        *slot = _free_slots;
+        _free_slots = slot;
+        throw AllocError(AllocErrorType::NoMemory, "No block of " + std::to_string(N) + " bytes available");
+    }
+
+    block->slot = slot;
+    *slot = block->payload();
+    _used += block->size;
+    _live++;
+    return Pointer(slot);
+}
+
+// See Simple.h
+void Simple::realloc(Pointer &p, size_t N) {
+    if (p._slot == nullptr) {
+        p = alloc(N);
+        return;
+    }
+    Validate(p);
+
+    size_t size = Round(N);
+    Block *block = BlockOf(*p._slot);
+    if (size <= block->size || Grow(block, size)) {
+        _used -= block->size;
+        Split(block, size);
+        _used += block->size;
+        return;
+    }
+
+    if (pinned(p)) {
+        throw AllocError(AllocErrorType::NoMemory, "Pinned block can't grow to " + std::to_string(N) + " bytes");
+    }
+
+    Block *moved = Place(size);
+    if (moved == nullptr) {
+        throw AllocError(AllocErrorType::NoMemory, "No block of " + std::to_string(N) + " bytes available");
+    }
+
+    std::memcpy(moved->payload(), block->payload(), block->size);
+    moved->slot = p._slot;
+    *p._slot = moved->payload();
+    _used += moved->size - block->size;
+
+    block->slot = nullptr;
+    Release(block);
+}
+
+// See Simple.h
+void Simple::free(Pointer &p) {
+    if (p._slot == nullptr) {
+        return;
+    }
+    Validate(p);
+
+    void **slot = p._slot;
+    p._slot = nullptr;
+    if (!_pins.empty()) {
+        auto pin = _pins.find(slot);
+        if (pin != _pins.end()) {
+            pin->second.freed = true;
+            return;
+        }
+    }
+    Discard(slot);
+}
+
+// See Simple.h
+void *Simple::alloc_fixed(size_t N) {
+    Block *block = Place(Round(N));
+    if (block == nullptr) {
+        throw AllocError(AllocErrorType::NoMemory, "No block of " + std::to_string(N) + " bytes available");
+    }
+
+    block->slot = Fixed;
+    _used += block->size;
+    _live++;
+    _fixed++;
+    return block->payload();
+}
+
+// See Simple.h
+void Simple::free_fixed(void *ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+
+    char *p = static_cast<char *>(ptr);
+    if (p < _begin + sizeof(Block) || p >= _top || BlockOf(ptr)->slot != Fixed) {
+        throw AllocError(AllocErrorType::InvalidFree, "Address is not allocated by this allocator");
+    }
+
+    Block *block = BlockOf(ptr);
+    _used -= block->size;
+    _live--;
+    _fixed--;
+
+    block->slot = nullptr;
+    Release(block);
+}
+
+// See Simple.h
+void Simple::defrag() {
+    auto start = std::chrono::steady_clock::now();
+
+    // Holes are rebuilt from scratch, only ones in front of pinned blocks survive
+    _free_blocks = nullptr;
+    _free_bytes = 0;
+    _cursor = nullptr;
+
+    char *dst = _begin;
+    for (Block *block = reinterpret_cast<Block *>(_begin); reinterpret_cast<char *>(block) < _top;) {
+        Block *next = block->next();
+        if (block->slot == nullptr) {
+            block = next;
+            continue;
+        }
+
+        if (reinterpret_cast<char *>(block) != dst) {
+            if (!Immovable(block)) {
+                block = Move(block, dst);
+            } else {
+                Block *hole = reinterpret_cast<Block *>(dst);
+                hole->size = reinterpret_cast<char *>(block) - dst - sizeof(Block);
+                hole->slot = nullptr;
+                LinkFree(hole);
+                _cursor = _cursor == nullptr ? dst : _cursor;
+            }
+        }
+        dst = reinterpret_cast<char *>(block) + block->total();
+        block = next;
+    }
+
+    _top = dst;
+    _cursor = _cursor == nullptr ? _top : _cursor;
+    Pause(start);
+}
+
+// See Simple.h
+bool Simple::defrag_step(size_t max_bytes, std::chrono::microseconds max_time) {
+    if (_cursor >= _top) {
+        return true;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    size_t moved = 0;
+    for (size_t skipped = 0; _cursor < _top && moved < max_bytes;) {
+        Block *block = reinterpret_cast<Block *>(_cursor);
+        if (block->slot != nullptr) {
+            // Long runs of live blocks take time as well
+            _cursor += block->total();
+            if (++skipped % 256 == 0 && std::chrono::steady_clock::now() - start >= max_time) {
+                break;
+            }
+            continue;
+        }
+
+        // Hole absorbs free neighbours following it, since blocks are merged with the next one only
+        UnlinkFree(block);
+        Block *next = block->next();
+        while (reinterpret_cast<char *>(next) < _top && next->slot == nullptr) {
+            UnlinkFree(next);
+            block->size += next->total();
+            next = block->next();
+        }
+
+        if (reinterpret_cast<char *>(next) == _top) {
+            _top = _cursor;
+            break;
+        }
+
+        if (Immovable(next)) {
+            LinkFree(block);
+            _cursor = reinterpret_cast<char *>(next);
+            continue;
+        }
+
+        // Live block and the hole swap places
+        size_t hole = block->total();
+        moved += next->total();
+        Block *rest = Move(next, _cursor)->next();
+        rest->size = hole - sizeof(Block);
+        rest->slot = nullptr;
+        LinkFree(rest);
+        _cursor = reinterpret_cast<char *>(rest);
+
+        if (std::chrono::steady_clock::now() - start >= max_time) {
+            break;
+        }
+    }
+
+    _steps += moved > 0;
+    Pause(start);
+    return _cursor >= _top;
+}
+
+// See Simple.h
+void Simple::pin(const Pointer &p) {
+    Validate(p);
+    _pins[p._slot].count++;
+}
+
+// See Simple.h
+void Simple::unpin(const Pointer &p) {
+    auto pin = _pins.find(p._slot);
+    if (pin == _pins.end()) {
+        throw AllocError(AllocErrorType::InvalidFree, "Pointer is not pinned");
+    }
+    if (--pin->second.count > 0) {
+        return;
+    }
+
+    bool freed = pin->second.freed;
+    _pins.erase(pin);
+
+    Block *block = BlockOf(*p._slot);
+    if (freed) {
+        Discard(p._slot);
+    } else if (reinterpret_cast<char *>(block) < _cursor) {
+        // Hole in front of the block could be closed now
+        _cursor = _begin;
+    }
+}
+
+// See Simple.h
+bool Simple::pinned(const Pointer &p) const { return !_pins.empty() && _pins.find(p._slot) != _pins.end(); }
+
+// See Simple.h
+std::string Simple::dump() const {
+    size_t free_blocks = 0;
+    size_t largest = 0;
+    for (Block *block = _free_blocks; block != nullptr; block = block->links()->next) {
+        free_blocks++;
+        largest = block->size > largest ? block->size : largest;
+    }
+
+    size_t gap = reinterpret_cast<char *>(_slots) - _top;
+    std::stringstream ss;
+    ss << "size " << _base_len << "\n"
+       << "used " << _used << "\n"
+       << "live " << _live << "\n"
+       << "free_blocks " << free_blocks << "\n"
+       << "free_bytes " << _free_bytes << "\n"
+       << "largest_free_block " << largest << "\n"
+       << "gap " << gap << "\n"
+       << "slots " << (_slots_end - _slots) << "\n"
+       << "pinned " << _pins.size() << "\n"
+       << "fixed " << _fixed << "\n"
+       << "fragmentation " << fragmentation() << "\n"
+       << "moved_bytes " << _moved << "\n"
+       << "defrag_steps " << _steps << "\n"
+       << "pause_max_us " << _pause_max << "\n"
+       << "pause_total_us " << _pause_total << "\n";
+    return ss.str();
+}
+
+// See Simple.h
+Stats Simple::stats() const {
+    Stats stats;
+    stats.reserved = _base_len;
+    stats.used = _used;
+    stats.free = available();
+    stats.live = _live;
+    stats.fragmentation = fragmentation();
+
+    std::map<size_t, size_t> classes;
+    for (Block *block = _free_blocks; block != nullptr; block = block->links()->next) {
+        classes[SizeClass(block->size)]++;
+        stats.largest_free = block->size > stats.largest_free ? block->size : stats.largest_free;
+    }
+    stats.free_blocks.assign(classes.begin(), classes.end());
+
+    // New block in the gap takes a header and maybe a descriptor
+    size_t gap = reinterpret_cast<char *>(_slots) - _top;
+    size_t overhead = sizeof(Block) + (_free_slots == nullptr ? sizeof(void *) : 0);
+    if (gap > overhead + stats.largest_free) {
+        stats.largest_free = (gap - overhead) & ~(Alignment - 1);
+    }
+    return stats;
+}
+
+// See Simple.h
+size_t Simple::available() const { return _free_bytes + (reinterpret_cast<char *>(_slots) - _top); }
+
+// See Simple.h
+double Simple::fragmentation() const {
+    size_t total = available();
+    return total == 0 ? 0 : static_cast<double>(_free_bytes) / total;
+}
+
+// See Simple.h
+void **Simple::TakeSlot() {
+    if (_free_slots != nullptr) {
+        void **slot = _free_slots;
+        _free_slots = static_cast<void **>(*slot);
+        return slot;
+    }
+
+    if (reinterpret_cast<char *>(_slots - 1) < _top) {
+        throw AllocError(AllocErrorType::NoMemory, "No room for block descriptor");
+    }
+    return --_slots;
+}
+
+// See Simple.h
+Simple::Block *Simple::Place(size_t size) {
+    for (Block *block = _free_blocks; block != nullptr; block = block->links()->next) {
+        if (block->size >= size) {
+            UnlinkFree(block);
+            Split(block, size);
+            return block;
+        }
+    }
+
+    if (reinterpret_cast<char *>(_slots) - _top < static_cast<ptrdiff_t>(sizeof(Block) + size)) {
+        return nullptr;
+    }
+
+    Block *block = reinterpret_cast<Block *>(_top);
+    block->size = size;
+    _top += block->total();
+    return block;
+}
+
+// See Simple.h
+void Simple::Split(Block *block, size_t size) {
+    if (block->size < size + sizeof(Block) + MinSize) {
+        return;
+    }
+
+    Block *rest = reinterpret_cast<Block *>(static_cast<char *>(block->payload()) + size);
+    rest->size = block->size - size - sizeof(Block);
+    rest->slot = nullptr;
+    block->size = size;
+    Release(rest);
+}
+
+// See Simple.h
+bool Simple::Grow(Block *block, size_t size) {
+    size_t room = block->size;
+    Block *next = block->next();
+    while (room < size && reinterpret_cast<char *>(next) < _top && next->slot == nullptr) {
+        room += next->total();
+        next = next->next();
+    }
+
+    // Free blocks before the gap are not merged into it, so the gap could follow them
+    size_t gap = 0;
+    if (room < size) {
+        size_t available = reinterpret_cast<char *>(_slots) - _top;
+        if (reinterpret_cast<char *>(next) != _top || available < size - room) {
+            return false;
+        }
+        gap = size - room;
+    }
+
+    for (Block *free = block->next(); free != next;) {
+        Block *following = free->next();
+        UnlinkFree(free);
+        free = following;
+    }
+    _used += room + gap - block->size;
+    block->size = room + gap;
+    _top += gap;
+
+    // Compaction position must stay at the block boundary, area below it has no holes anyway
+    if (_cursor > reinterpret_cast<char *>(block) && _cursor < reinterpret_cast<char *>(block->next())) {
+        _cursor = reinterpret_cast<char *>(block->next());
+    }
+    return true;
+}
+
+// See Simple.h
+void Simple::Release(Block *block) {
+    if (reinterpret_cast<char *>(block) < _cursor) {
+        _cursor = reinterpret_cast<char *>(block);
+    }
+
+    Block *next = block->next();
+    if (reinterpret_cast<char *>(next) < _top && next->slot == nullptr) {
+        UnlinkFree(next);
+        block->size += next->total();
+    }
+
+    if (reinterpret_cast<char *>(block->next()) == _top) {
+        _top = reinterpret_cast<char *>(block);
+        return;
+    }
+    LinkFree(block);
+}
+
+// See Simple.h
+void Simple::Discard(void **slot) {
+    Block *block = BlockOf(*slot);
+    _used -= block->size;
+    _live--;
+
+    *slot = _free_slots;
+    _free_slots = slot;
+
+    block->slot = nullptr;
+    Release(block);
+}
+
+// See Simple.h
+bool Simple::Immovable(Block *block) const {
+    return block->slot == Fixed || (!_pins.empty() && _pins.find(block->slot) != _pins.end());
+}
+
+// See Simple.h
+Simple::Block *Simple::Move(Block *block, char *to) {
+    size_t total = block->total();
+    std::memmove(to, block, total);
+    _moved += total;
+
+    Block *moved = reinterpret_cast<Block *>(to);
+    *moved->slot = moved->payload();
+    return moved;
+}
+
+// See Simple.h
+void Simple::Pause(std::chrono::steady_clock::time_point start) {
+    uint64_t pause =
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    _pause_max = pause > _pause_max ? pause : _pause_max;
+    _pause_total += pause;
+}
+
+// See Simple.h
+void Simple::LinkFree(Block *block) {
+    block->links()->prev = nullptr;
+    block->links()->next = _free_blocks;
+    if (_free_blocks != nullptr) {
+        _free_blocks->links()->prev = block;
+    }
+    _free_blocks = block;
+    _free_bytes += block->total();
+}
+
+// See Simple.h
+void Simple::UnlinkFree(Block *block) {
+    Block::Links *links = block->links();
+    if (links->prev != nullptr) {
+        links->prev->links()->next = links->next;
+    } else {
+        _free_blocks = links->next;
+    }
+    if (links->next != nullptr) {
+        links->next->links()->prev = links->prev;
+    }
+    _free_bytes -= block->total();
+}
+
+// See Simple.h
+void Simple::Validate(const Pointer &p) const {
+    bool valid = p._slot >= _slots && p._slot < _slots_end;
+    if (valid) {
+        // Unused descriptors point to other descriptors or nowhere
+        char *ptr = static_cast<char *>(*p._slot);
+        valid = ptr >= _begin + sizeof(Block) && ptr < _top && BlockOf(*p._slot)->slot == p._slot;
+    }
+    if (valid && !_pins.empty()) {
+        auto pin = _pins.find(p._slot);
+        valid = pin == _pins.end() || !pin->second.freed;
+    }
+
+    if (!valid) {
+        throw AllocError(AllocErrorType::InvalidFree, "Pointer is not allocated by this allocator");
+    }
+}
 
 } // namespace Allocator
 } // namespace Afina
@@ -0,0 +1,442 @@
+#include <afina/allocator/Slab.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <sys/mman.h>
+
+namespace Afina {
+namespace Allocator {
+
+namespace {
+
+/**
+ * Lock-free stack of elements of the arena linked through 4 bytes at the given offset. Head packs modification
+ * counter in the high half and index of the top element in the low one, index is the offset from the arena
+ * base in granules plus one, so that zero means empty stack
+ */
+class Stack {
+public:
+    Stack(std::atomic<uint64_t> &head, char *base, size_t granule, size_t offset = 0)
+        : _head(head), _base(base), _granule(granule), _offset(offset) {}
+
+    void *pop() {
+        uint64_t head = _head.load(std::memory_order_acquire);
+        while (Index(head) != 0) {
+            char *top = Decode(Index(head));
+            uint32_t next = __atomic_load_n(Link(top), __ATOMIC_RELAXED);
+            if (_head.compare_exchange_weak(head, Pack(head, next), std::memory_order_acquire)) {
+                return top;
+            }
+        }
+        return nullptr;
+    }
+
+    // Pushes chain of elements already linked from first to last
+    void push(void *first, void *last) {
+        uint32_t index = Encode(first);
+        uint64_t head = _head.load(std::memory_order_relaxed);
+        do {
+            __atomic_store_n(Link(last), Index(head), __ATOMIC_RELAXED);
+        } while (!_head.compare_exchange_weak(head, Pack(head, index), std::memory_order_release,
+                                             std::memory_order_relaxed));
+    }
+
+    // Takes all elements at once, returns the first one of the chain
+    void *take() {
+        uint64_t head = _head.load(std::memory_order_acquire);
+        while (Index(head) != 0 && !_head.compare_exchange_weak(head, Pack(head, 0), std::memory_order_acquire)) {
+        }
+        return Index(head) == 0 ? nullptr : Decode(Index(head));
+    }
+
+    void *next(void *p) const {
+        uint32_t index = __atomic_load_n(Link(p), __ATOMIC_RELAXED);
+        return index == 0 ? nullptr : Decode(index);
+    }
+
+    void link(void *p, void *next) const {
+        __atomic_store_n(Link(p), next == nullptr ? 0 : Encode(next), __ATOMIC_RELAXED);
+    }
+
+private:
+    static uint32_t Index(uint64_t head) { return static_cast<uint32_t>(head); }
+    static uint64_t Pack(uint64_t head, uint32_t index) { return ((head >> 32) + 1) << 32 | index; }
+
+    uint32_t *Link(void *p) const { return reinterpret_cast<uint32_t *>(static_cast<char *>(p) + _offset); }
+    uint32_t Encode(void *p) const { return (static_cast<char *>(p) - _base) / _granule + 1; }
+    char *Decode(uint32_t index) const { return _base + (index - 1) * _granule; }
+
+    std::atomic<uint64_t> &_head;
+    char *_base;
+    size_t _granule;
+    size_t _offset;
+};
+
+// Offsets of objects are counted in these units
+const size_t Granule = 8;
+
+// Objects of a batch are linked through the first word, batches in the depot through the second one
+const size_t DepotLink = 4;
+
+size_t RoundObject(size_t size) { return size <= 8 ? 8 : (size + 15) & ~size_t(15); }
+
+// Free list used by the calling thread, threads are spread over lists in order they come
+size_t ThreadStripe(size_t stripes) {
+    static std::atomic<size_t> threads(0);
+
+    // Constant initialized, so access doesn't go through TLS init guard. Zero means not assigned yet
+    static thread_local size_t stripe = 0;
+    if (stripe == 0) {
+        stripe = threads.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+    return stripe % stripes;
+}
+
+} // namespace
+
+const size_t Arena::DefaultSlabSize;
+const size_t Arena::MaxArenaSize;
+const size_t Mempool::BatchSize;
+const size_t Magazine::Capacity;
+
+// See Slab.h
+Arena::Arena(size_t size, size_t slab_size) : _size(size / slab_size * slab_size), _slab_size(slab_size), _next(0) {
+    if (slab_size == 0 || (slab_size & (slab_size - 1)) != 0 || slab_size % 4096 != 0 || size > MaxArenaSize) {
+        throw std::invalid_argument("Invalid arena geometry");
+    }
+
+    // Address space only, pages are made accessible slab by slab
+    _raw_size = _size + _slab_size;
+    void *raw = mmap(nullptr, _raw_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (raw == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    _raw = static_cast<char *>(raw);
+    _base = reinterpret_cast<char *>((reinterpret_cast<uintptr_t>(raw) + _slab_size - 1) & ~(_slab_size - 1));
+}
+
+// See Slab.h
+Arena::~Arena() { munmap(_raw, _raw_size); }
+
+// See Slab.h
+void *Arena::map() {
+    size_t offset = _next.fetch_add(_slab_size, std::memory_order_relaxed);
+    if (offset >= _size || mprotect(_base + offset, _slab_size, PROT_READ | PROT_WRITE) != 0) {
+        return nullptr;
+    }
+    return _base + offset;
+}
+
+// See Slab.h
+size_t Arena::mapped() const {
+    size_t next = _next.load(std::memory_order_relaxed);
+    return next < _size ? next : _size;
+}
+
+// See Slab.h
+SlabCache::SlabCache(Arena &arena) : _arena(arena), _free(0), _cached(0) {}
+
+// See Slab.h
+void *SlabCache::get() {
+    void *slab = Stack(_free, _arena.base(), _arena.slab_size()).pop();
+    if (slab != nullptr) {
+        _cached.fetch_sub(1, std::memory_order_relaxed);
+        return slab;
+    }
+    return _arena.map();
+}
+
+// See Slab.h
+void SlabCache::put(void *slab) {
+    Stack(_free, _arena.base(), _arena.slab_size()).push(slab, slab);
+    _cached.fetch_add(1, std::memory_order_relaxed);
+}
+
+// See Slab.h
+Stats SlabCache::stats() const {
+    size_t slab_size = _arena.slab_size();
+    size_t mapped = _arena.mapped() / slab_size;
+
+    // Counter follows the stack, so it could be ahead of the mapped slabs for a moment
+    size_t cached = std::min(this->cached(), mapped);
+
+    Stats stats;
+    stats.reserved = _arena.size();
+    stats.live = mapped - cached;
+    stats.used = stats.live * slab_size;
+    stats.free = stats.reserved - stats.used;
+    stats.largest_free = stats.free > 0 ? slab_size : 0;
+    if (stats.free > 0) {
+        stats.free_blocks.emplace_back(slab_size, stats.free / slab_size);
+    }
+    return stats;
+}
+
+// See Slab.h
+Mempool::Mempool(SlabCache &cache, size_t object_size)
+    : _cache(cache), _base(cache.arena().base()), _object_size(RoundObject(object_size)), _nslabs(0) {
+    if (_object_size > cache.arena().slab_size()) {
+        throw std::invalid_argument("Object doesn't fit into slab");
+    }
+    for (auto &stripe : _stripes) {
+        stripe.head.store(0);
+    }
+    _depot.head.store(0);
+}
+
+// See Slab.h
+Mempool::~Mempool() {
+    for (void *slab : _slabs) {
+        _cache.put(slab);
+    }
+}
+
+// See Slab.h
+void *Mempool::alloc() {
+    size_t stripe = ThreadStripe(Stripes);
+    for (;;) {
+        void *p = Pop(stripe);
+        if (p != nullptr) {
+            return p;
+        }
+
+        // Batch from the depot goes to the list except the object returned
+        p = Stack(_depot.head, _base, Granule, DepotLink).pop();
+        if (p != nullptr) {
+            Stack own(_stripes[stripe].head, _base, Granule);
+            void *rest = own.next(p);
+            if (rest != nullptr) {
+                void *last = rest;
+                for (void *next = own.next(last); next != nullptr; next = own.next(last)) {
+                    last = next;
+                }
+                own.push(rest, last);
+            }
+            return p;
+        }
+
+        if (!Carve()) {
+            return nullptr;
+        }
+    }
+}
+
+// See Slab.h
+void Mempool::free(void *p) {
+    Stack(_stripes[ThreadStripe(Stripes)].head, _base, Granule).push(p, p);
+}
+
+// See Slab.h
+size_t Mempool::alloc_batch(void **objects) {
+    size_t stripe = ThreadStripe(Stripes);
+    Stack own(_stripes[stripe].head, _base, Granule);
+    for (;;) {
+        size_t count = 0;
+        void *batch = Stack(_depot.head, _base, Granule, DepotLink).pop();
+        for (void *p = batch; p != nullptr; p = own.next(p)) {
+            objects[count++] = p;
+        }
+        if (count > 0) {
+            return count;
+        }
+
+        // Loose objects freed one by one
+        for (void *p; count < BatchSize && (p = Pop(stripe)) != nullptr;) {
+            objects[count++] = p;
+        }
+        if (count > 0 || !Carve()) {
+            return count;
+        }
+    }
+}
+
+// See Slab.h
+void Mempool::free_batch(void **objects, size_t count) {
+    if (count == 0) {
+        return;
+    }
+
+    Stack own(_stripes[ThreadStripe(Stripes)].head, _base, Granule);
+    for (size_t i = 0; i + 1 < count; i++) {
+        own.link(objects[i], objects[i + 1]);
+    }
+    own.link(objects[count - 1], nullptr);
+
+    if (count == BatchSize) {
+        Stack(_depot.head, _base, Granule, DepotLink).push(objects[0], objects[0]);
+    } else {
+        own.push(objects[0], objects[count - 1]);
+    }
+}
+
+// See Slab.h
+void *Mempool::Pop(size_t stripe) {
+    void *p = Stack(_stripes[stripe].head, _base, Granule).pop();
+    return p != nullptr ? p : Steal(stripe);
+}
+
+// See Slab.h
+void *Mempool::Steal(size_t stripe) {
+    for (size_t i = 1; i < Stripes; i++) {
+        Stack victim(_stripes[(stripe + i) % Stripes].head, _base, Granule);
+        void *first = victim.take();
+        if (first == nullptr) {
+            continue;
+        }
+
+        // Rest of the chain goes to the thread's own list
+        void *rest = victim.next(first);
+        if (rest != nullptr) {
+            void *last = rest;
+            for (void *next = victim.next(last); next != nullptr; next = victim.next(last)) {
+                last = next;
+            }
+            Stack(_stripes[stripe].head, _base, Granule).push(rest, last);
+        }
+        return first;
+    }
+    return nullptr;
+}
+
+// See Slab.h
+bool Mempool::Carve() {
+    char *slab = static_cast<char *>(_cache.get());
+    if (slab == nullptr) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_slabs_m);
+        _slabs.push_back(slab);
+        _nslabs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    size_t count = _cache.arena().slab_size() / _object_size;
+    void *objects[BatchSize];
+    for (size_t first = 0; first < count; first += BatchSize) {
+        size_t batch = count - first < BatchSize ? count - first : BatchSize;
+        for (size_t i = 0; i < batch; i++) {
+            objects[i] = slab + (first + i) * _object_size;
+        }
+        free_batch(objects, batch);
+    }
+    return true;
+}
+
+// See Slab.h
+Magazine::~Magazine() {
+    if (_pool != nullptr) {
+        _pool->free_batch(_objects, _count);
+    }
+    _count = 0;
+    _limit = 0;
+}
+
+// See Slab.h
+void *Magazine::Refill() {
+    if (_limit == 0) {
+        return _pool->alloc();
+    }
+
+    _count = _pool->alloc_batch(_objects);
+    return _count > 0 ? _objects[--_count] : nullptr;
+}
+
+// See Slab.h
+void Magazine::Drain(void *p) {
+    if (_limit == 0) {
+        _pool->free(p);
+        return;
+    }
+
+    _count -= Mempool::BatchSize;
+    _pool->free_batch(_objects + _count, Mempool::BatchSize);
+    _objects[_count++] = p;
+}
+
+// See Slab.h
+Arena &DefaultArena() {
+    static Arena *arena = []() -> Arena * {
+        // Address space could be limited, fall back to smaller reservations
+        for (size_t size = Arena::MaxArenaSize;; size /= 2) {
+            try {
+                return new Arena(size);
+            } catch (std::bad_alloc &) {
+                if (size <= 64 * Arena::DefaultSlabSize) {
+                    throw;
+                }
+            }
+        }
+    }();
+    return *arena;
+}
+
+// See Slab.h
+SlabCache &DefaultSlabCache() {
+    static SlabCache *cache = new SlabCache(DefaultArena());
+    return *cache;
+}
+
+namespace {
+
+const size_t BufferClasses = 11;
+
+size_t BufferClass(size_t size) {
+    size_t index = 0;
+    for (size_t capacity = MinBufferSize; capacity < size; capacity *= 2) {
+        index++;
+    }
+    return index;
+}
+
+Mempool &BufferPool(size_t index) {
+    static Mempool *pools = []() -> Mempool * {
+        // Never destroyed, as pools of SlabAllocated
+        char *memory = static_cast<char *>(::operator new(sizeof(Mempool) * BufferClasses));
+        for (size_t i = 0; i < BufferClasses; i++) {
+            new (memory + i * sizeof(Mempool)) Mempool(DefaultSlabCache(), MinBufferSize << i);
+        }
+        return reinterpret_cast<Mempool *>(memory);
+    }();
+    return pools[index];
+}
+
+struct BufferMagazines {
+    BufferMagazines() {
+        for (size_t i = 0; i < BufferClasses; i++) {
+            magazines[i].bind(BufferPool(i));
+        }
+    }
+
+    Magazine magazines[BufferClasses];
+};
+
+Magazine &BufferCache(size_t index) {
+    static thread_local BufferMagazines cache;
+    return cache.magazines[index];
+}
+
+} // namespace
+
+// See Slab.h
+char *AllocBuffer(size_t size) {
+    if (size > MaxBufferSize) {
+        return new char[size];
+    }
+
+    char *buffer = static_cast<char *>(BufferCache(BufferClass(size)).alloc());
+    return buffer != nullptr ? buffer : new char[size];
+}
+
+// See Slab.h
+void FreeBuffer(char *buffer, size_t size) {
+    if (size > MaxBufferSize || !DefaultArena().contains(buffer)) {
+        delete[] buffer;
+        return;
+    }
+    BufferCache(BufferClass(size)).free(buffer);
+}
+
+} // namespace Allocator
+} // namespace Afina
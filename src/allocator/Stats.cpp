@@ -0,0 +1,49 @@
+#include <afina/allocator/Stats.h>
+
+#include <algorithm>
+#include <map>
+
+namespace Afina {
+namespace Allocator {
+
+// See Stats.h
+void Stats::merge(const Stats &other) {
+    size_t total = free + other.free;
+    fragmentation = total == 0 ? 0 : (fragmentation * free + other.fragmentation * other.free) / total;
+    reserved += other.reserved;
+    used += other.used;
+    free = total;
+    live += other.live;
+    largest_free = std::max(largest_free, other.largest_free);
+
+    std::map<size_t, size_t> classes(free_blocks.begin(), free_blocks.end());
+    for (auto &blocks : other.free_blocks) {
+        classes[blocks.first] += blocks.second;
+    }
+    free_blocks.assign(classes.begin(), classes.end());
+}
+
+// See Stats.h
+void Stats::report(const std::string &prefix, std::vector<std::pair<std::string, std::string>> &out) const {
+    out.emplace_back(prefix + ":reserved_bytes", std::to_string(reserved));
+    out.emplace_back(prefix + ":used_bytes", std::to_string(used));
+    out.emplace_back(prefix + ":free_bytes", std::to_string(free));
+    out.emplace_back(prefix + ":live", std::to_string(live));
+    out.emplace_back(prefix + ":largest_free", std::to_string(largest_free));
+    out.emplace_back(prefix + ":fragmentation", std::to_string(fragmentation));
+    for (auto &blocks : free_blocks) {
+        out.emplace_back(prefix + ":free_blocks_" + std::to_string(blocks.first), std::to_string(blocks.second));
+    }
+}
+
+// See Stats.h
+size_t SizeClass(size_t size) {
+    size_t cls = 1;
+    while (cls < size) {
+        cls <<= 1;
+    }
+    return cls;
+}
+
+} // namespace Allocator
+} // namespace Afina
@@ -0,0 +1,16 @@
+#include <afina/Storage.h>
+#include <afina/execute/Delete.h>
+
+#include <iostream>
+
+namespace Afina {
+namespace Execute {
+
+// memcached protocol: "DELETED" means success, "NOT_FOUND" means the item was not found
+void Delete::Execute(Storage &storage, const std::string &args, std::string &out) {
+    std::cout << "Delete(" << _key << ")" << std::endl;
+    out = storage.Delete(_key) ? "DELETED" : "NOT_FOUND";
+}
+
+} // namespace Execute
+} // namespace Afina
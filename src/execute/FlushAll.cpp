@@ -0,0 +1,14 @@
+#include <afina/Storage.h>
+#include <afina/execute/FlushAll.h>
+
+namespace Afina {
+namespace Execute {
+
+// See FlushAll.h
+void FlushAll::Execute(Storage &storage, const std::string &args, std::string &out) {
+    storage.FlushAll(_delay);
+    out = "OK";
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -1,9 +1,8 @@
 #include <afina/Storage.h>
 #include <afina/execute/Get.h>
 
+#include <algorithm>
 #include <iostream>
-#include <iterator>
-#include <sstream>
 
 namespace Afina {
 namespace Execute {
@@ -22,22 +21,30 @@ to indicate the end of response.
 */
 
 void Get::Execute(Storage &storage, const std::string &args, std::string &out) {
-    std::stringstream keyStream;
-    copy(_keys.begin(), _keys.end(), std::ostream_iterator<std::string>(keyStream, " "));
-    std::cout << "Get(" << keyStream.str() << ")" << std::endl;
-
-    std::stringstream outStream;
+    std::cout << "Get(";
+    for (auto &key : _keys) {
+        std::cout << key << " ";
+    }
+    std::cout << ")" << std::endl;
 
-    std::string value;
+    // Reply is built in place, value goes into the reply straight from the storage copy. Storage takes
+    // std::string key, the same buffer is reused for every key
+    out.clear();
+    std::string name, value;
     for (auto &key : _keys) {
-        if (!storage.Get(key, value))
+        name.assign(key.data(), key.size());
+        if (!storage.Get(name, value))
             continue;
-        outStream << "VALUE " << key << " 0 " << value.size() << "\r\n";
-        outStream << value << "\r\n";
-    }
-    outStream << "END"; // networking layer should add the last \r\n
 
-    out = outStream.str();
+        std::string size = std::to_string(value.size());
+        size_t need = out.size() + key.size() + size.size() + value.size() + 16;
+        if (need > out.capacity()) {
+            out.reserve(std::max(need, 2 * out.capacity()));
+        }
+        out.append("VALUE ").append(name).append(" 0 ").append(size).append("\r\n");
+        out.append(value).append("\r\n");
+    }
+    out.append("END"); // networking layer should add the last \r\n
 }
 
 } // namespace Execute
@@ -0,0 +1,16 @@
+#include <afina/Storage.h>
+#include <afina/execute/Invalidate.h>
+
+#include <iostream>
+
+namespace Afina {
+namespace Execute {
+
+// Replies the same way as "delete" does
+void Invalidate::Execute(Storage &storage, const std::string &args, std::string &out) {
+    std::cout << "Invalidate(" << _key << ")" << std::endl;
+    out = storage.Invalidate(_key) ? "DELETED" : "NOT_FOUND";
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -0,0 +1,37 @@
+#include <afina/Storage.h>
+#include <afina/execute/LeaseGet.h>
+
+#include <iostream>
+#include <sstream>
+
+namespace Afina {
+namespace Execute {
+
+// See LeaseGet.h for the reply format
+void LeaseGet::Execute(Storage &storage, const std::string &args, std::string &out) {
+    std::cout << "LeaseGet(" << _key << ")" << std::endl;
+
+    std::stringstream outStream;
+    std::string value;
+    uint64_t token = 0;
+    switch (storage.LeaseGet(_key, value, token)) {
+    case Storage::LeaseStatus::Hit:
+        outStream << "VALUE " << _key << " 0 " << value.size() << "\r\n" << value << "\r\n";
+        break;
+    case Storage::LeaseStatus::Granted:
+        outStream << "LEASE " << _key << " " << token << "\r\n";
+        break;
+    case Storage::LeaseStatus::Stale:
+        outStream << "STALE " << _key << " 0 " << value.size() << "\r\n" << value << "\r\n";
+        break;
+    case Storage::LeaseStatus::Wait:
+        outStream << "WAIT " << _key << "\r\n";
+        break;
+    }
+    outStream << "END"; // networking layer should add the last \r\n
+
+    out = outStream.str();
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -0,0 +1,16 @@
+#include <afina/Storage.h>
+#include <afina/execute/LeaseSet.h>
+
+#include <iostream>
+
+namespace Afina {
+namespace Execute {
+
+// Like "set", but only lease holder could store the data
+void LeaseSet::Execute(Storage &storage, const std::string &args, std::string &out) {
+    std::cout << "LeaseSet(" << _key << ", " << _token << "): " << args << std::endl;
+    out = storage.LeaseSet(_key, args, _token) ? "STORED" : "NOT_STORED";
+}
+
+} // namespace Execute
+} // namespace Afina
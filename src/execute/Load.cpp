@@ -0,0 +1,14 @@
+#include <afina/Storage.h>
+#include <afina/execute/Load.h>
+
+namespace Afina {
+namespace Execute {
+
+// See Load.h
+void Load::Execute(Storage &storage, const std::string &args, std::string &out) {
+    size_t loaded = storage.Load(_path, nullptr);
+    out = "LOADED " + std::to_string(loaded);
+}
+
+} // namespace Execute
+} // namespace Afina
@@ -1,14 +1,175 @@
 #include <afina/Storage.h>
+#include <afina/allocator/Resource.h>
+#include <afina/allocator/Slab.h>
+#include <afina/allocator/Stats.h>
 #include <afina/execute/Stats.h>
 
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <iterator>
+#include <map>
 #include <sstream>
 
 namespace Afina {
 namespace Execute {
 
-void Stats::Execute(Storage &storage, const std::string &args, std::string &out) { out.assign("END"); }
+namespace {
+
+// Usage of resources with the same name is summed up, so pools of all partitions show up as one
+void GetPoolStats(Storage::StatsList &stats) {
+    struct Usage {
+        size_t bytes, peak, blocks;
+        uint64_t allocations, failures;
+    };
+
+    std::map<std::string, Usage> pools;
+    Allocator::Resource::ForEach([&pools](const Allocator::Resource &resource) {
+        Usage &usage = pools.emplace(resource.name(), Usage{0, 0, 0, 0, 0}).first->second;
+        usage.bytes += resource.bytes();
+        usage.peak += resource.peak();
+        usage.blocks += resource.blocks();
+        usage.allocations += resource.allocations();
+        usage.failures += resource.failures();
+    });
+
+    for (auto &pool : pools) {
+        stats.emplace_back(pool.first + ":bytes", std::to_string(pool.second.bytes));
+        stats.emplace_back(pool.first + ":peak_bytes", std::to_string(pool.second.peak));
+        stats.emplace_back(pool.first + ":blocks", std::to_string(pool.second.blocks));
+        stats.emplace_back(pool.first + ":allocations", std::to_string(pool.second.allocations));
+        stats.emplace_back(pool.first + ":failures", std::to_string(pool.second.failures));
+    }
+}
+
+// Resources with the same name are merged the same way, the default slab arena goes as "slab_arena" and
+// allocators owned by storage follow
+void GetAllocatorStats(const Storage &storage, Storage::StatsList &stats) {
+    std::map<std::string, Allocator::Stats> allocators;
+    Allocator::Resource::ForEach([&allocators](const Allocator::Resource &resource) {
+        allocators[resource.name()].merge(resource.stats());
+    });
+
+    for (auto &allocator : allocators) {
+        allocator.second.report(allocator.first, stats);
+    }
+    Allocator::DefaultSlabCache().stats().report("slab_arena", stats);
+    storage.GetStats("allocator", stats);
+}
+
+// Stat value that is a number, integers are summed up exactly
+struct Number {
+    uint64_t integer;
+    double real;
+};
+
+// Parses value as a list of numbers separated by spaces, fraction is set if any of them isn't integer
+bool ParseNumbers(const std::string &value, std::vector<Number> &numbers, bool &fraction) {
+    numbers.clear();
+    fraction = false;
+    const char *pos = value.c_str();
+    while (*pos != '\0') {
+        char *end;
+        double real = std::strtod(pos, &end);
+        if (end == pos || (*end != ' ' && *end != '\0')) {
+            return false;
+        }
+        bool integer = std::strspn(pos, "0123456789") == size_t(end - pos);
+        fraction = fraction || !integer;
+        numbers.push_back(Number{integer ? std::strtoull(pos, nullptr, 10) : 0, real});
+        pos = *end == ' ' ? end + 1 : end;
+    }
+    return !numbers.empty();
+}
+
+} // namespace
+
+void Stats::Execute(Storage &storage, const std::string &args, std::string &out) {
+    Storage::StatsList stats;
+    if (_group == "pools") {
+        GetPoolStats(stats);
+    } else if (_group == "allocator") {
+        GetAllocatorStats(storage, stats);
+    } else {
+        storage.GetStats(_group, stats);
+    }
+
+    out.clear();
+    for (auto &stat : stats) {
+        out.append("STAT ").append(stat.first).append(" ").append(stat.second).append("\r\n");
+    }
+    out.append("END"); // networking layer should add the last \r\n
+}
+
+void Stats::Merge(const std::vector<const std::string *> &outputs, std::string &out) {
+    struct Merged {
+        std::string value;
+        std::vector<Number> sum;
+        bool fraction;
+        size_t count;
+    };
+
+    std::vector<std::string> names;
+    std::map<std::string, Merged> merged;
+    std::vector<Number> numbers;
+    std::string errors;
+    for (const std::string *output : outputs) {
+        std::istringstream lines(*output);
+        std::string line;
+        while (std::getline(lines, line)) {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+
+            // Partition that failed replies error instead of stats, it goes after them
+            size_t space = line.find(' ', 5);
+            if (line.compare(0, 5, "STAT ") != 0 || space == std::string::npos) {
+                if (line != "END") {
+                    errors.append(line).append("\r\n");
+                }
+                continue;
+            }
+
+            std::string name = line.substr(5, space - 5);
+            std::string value = line.substr(space + 1);
+            bool fraction;
+            bool numeric = ParseNumbers(value, numbers, fraction);
+
+            auto it = merged.find(name);
+            if (it == merged.end()) {
+                names.push_back(name);
+                merged.emplace(name, Merged{value, numeric ? numbers : std::vector<Number>(), fraction, 1});
+            } else if (numeric && it->second.sum.size() == numbers.size()) {
+                Merged &stat = it->second;
+                for (size_t i = 0; i < numbers.size(); i++) {
+                    stat.sum[i].integer += numbers[i].integer;
+                    stat.sum[i].real += numbers[i].real;
+                }
+                stat.fraction = stat.fraction || fraction;
+                stat.count++;
+            }
+        }
+    }
+
+    out.clear();
+    for (auto &name : names) {
+        Merged &stat = merged[name];
+        out.append("STAT ").append(name).append(" ");
+        if (stat.sum.empty() || stat.count == 1) {
+            out.append(stat.value);
+        } else {
+            for (size_t i = 0; i < stat.sum.size(); i++) {
+                out.append(i == 0 ? "" : " ");
+                out.append(stat.fraction ? std::to_string(stat.sum[i].real / stat.count)
+                                         : std::to_string(stat.sum[i].integer));
+            }
+        }
+        out.append("\r\n");
+    }
+    out.append(errors);
+    out.append("END"); // networking layer should add the last \r\n
+}
 
 } // namespace Execute
 } // namespace Afina
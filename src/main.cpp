@@ -12,7 +12,11 @@
 #include "network/blocking/ServerImpl.h"
 #include "network/nonblocking/ServerImpl.h"
 #include "network/uv/ServerImpl.h"
+#include "network/uv/StaticServerImpl.h"
+#include "storage/HugePages.h"
+#include "storage/KeyHash.h"
 #include "storage/MapBasedGlobalLockImpl.h"
+#include "storage/MapBasedSimpleImpl.h"
 
 
 typedef struct {
@@ -50,6 +54,15 @@ int main(int argc, char **argv) {
         // and simplify validation below
         options.add_options()("s,storage", "Type of storage service to use", cxxopts::value<std::string>());
         options.add_options()("n,network", "Type of network service to use", cxxopts::value<std::string>());
+        options.add_options()("w,workers", "Number of network workers", cxxopts::value<int>());
+        options.add_options()("m,memory", "Storage size limit in bytes, split between partitions",
+                              cxxopts::value<size_t>()->default_value("67108864"));
+        options.add_options()("e,expected-items", "Number of items to presize storage index for",
+                              cxxopts::value<size_t>());
+        options.add_options()("l,load", "Dump file to fill storage with on startup", cxxopts::value<std::string>());
+        options.add_options()("huge-pages", "Back storage entries and index by 2MB pages");
+        options.add_options()("eviction", "Eviction policy: lru or arc", cxxopts::value<std::string>());
+        options.add_options()("ghost-list", "Track evicted keys to report hit ratio of larger cache sizes");
         options.add_options()("h,help", "Print usage info");
         options.parse(argc, argv);
 
@@ -72,8 +85,62 @@ int main(int argc, char **argv) {
         storage_type = options["storage"].as<std::string>();
     }
 
+    int workers = 1;
+    if (options.count("workers") > 0) {
+        workers = options["workers"].as<int>();
+    }
+
+    size_t memory = options["memory"].as<size_t>();
+
+    size_t expected_items = 0;
+    if (options.count("expected-items") > 0) {
+        expected_items = options["expected-items"].as<size_t>();
+    }
+
+    if (options.count("huge-pages") > 0) {
+        Afina::Backend::EnableHugePages(true);
+    }
+
+    bool ghosts = options.count("ghost-list") > 0;
+
+    std::string eviction = "lru";
+    if (options.count("eviction") > 0) {
+        eviction = options["eviction"].as<std::string>();
+    }
+
+    std::string load_path;
+    if (options.count("load") > 0) {
+        load_path = options["load"].as<std::string>();
+    }
+
+    // In shared-nothing mode each network worker owns a private partition and there is no
+    // storage shared between workers
+    Afina::Network::UV::ServerImpl::PartitionFactory partition_factory;
+    std::shared_ptr<Afina::Backend::MapBasedGlobalLockImpl> global_storage;
     if (storage_type == "map_global") {
-        app.storage = std::make_shared<Afina::Backend::MapBasedGlobalLockImpl>();
+        global_storage =
+            std::make_shared<Afina::Backend::MapBasedGlobalLockImpl>(memory, true, expected_items, eviction);
+        global_storage->EnableGhosts(ghosts);
+        app.storage = global_storage;
+    } else if (storage_type == "map_simple") {
+        app.storage = std::make_shared<Afina::Backend::MapBasedSimpleImpl>(memory, true);
+    } else if (storage_type == "map_partitioned") {
+        size_t partition_items = expected_items / workers;
+        size_t partition_memory = memory / workers;
+        partition_factory = [partition_memory, partition_items, load_path, ghosts, eviction](size_t index,
+                                                                                           size_t count) {
+            auto partition = std::make_shared<Afina::Backend::MapBasedGlobalLockImpl>(partition_memory, false,
+                                                                                      partition_items, eviction);
+            partition->EnableGhosts(ghosts);
+            if (!load_path.empty()) {
+                // Each partition picks keys it owns from the same dump
+                size_t loaded = partition->Load(load_path, [index, count](const std::string &key) {
+                    return Afina::Backend::KeyHashShard(Afina::Backend::KeyHash(key), count) == index;
+                });
+                std::cout << "Partition " << index << " loaded " << loaded << " items" << std::endl;
+            }
+            return partition;
+        };
     } else {
         throw std::runtime_error("Unknown storage type");
     }
@@ -85,7 +152,15 @@ int main(int argc, char **argv) {
     }
 
     if (network_type == "uv") {
-        app.server = std::make_shared<Afina::Network::UV::ServerImpl>(app.storage);
+        app.server = std::make_shared<Afina::Network::UV::ServerImpl>(app.storage, partition_factory);
+    } else if (partition_factory) {
+        throw std::runtime_error("Partitioned storage is supported by uv network only");
+    } else if (network_type == "uv_static") {
+        if (!global_storage) {
+            throw std::runtime_error("uv_static network supports map_global storage only");
+        }
+        app.server = std::make_shared<Afina::Network::UV::StaticServerImpl<Afina::Backend::MapBasedGlobalLockImpl>>(
+            global_storage);
     } else if (network_type == "blocking") {
         app.server = std::make_shared<Afina::Network::Blocking::ServerImpl>(app.storage);
     } else if (network_type == "nonblocking") {
@@ -115,8 +190,14 @@ int main(int argc, char **argv) {
 
     // Start services
     try {
-        app.storage->Start();
-        app.server->Start(8080);
+        if (app.storage) {
+            if (!load_path.empty()) {
+                size_t loaded = app.storage->Load(load_path, nullptr);
+                std::cout << "Loaded " << loaded << " items" << std::endl;
+            }
+            app.storage->Start();
+        }
+        app.server->Start(8080, workers);
 
         // Freeze current thread and process events
         std::cout << "Application started" << std::endl;
@@ -125,7 +206,9 @@ int main(int argc, char **argv) {
         // Stop services
         app.server->Stop();
         app.server->Join();
-        app.storage->Stop();
+        if (app.storage) {
+            app.storage->Stop();
+        }
 
         std::cout << "Application stopped" << std::endl;
     } catch (std::exception &e) {
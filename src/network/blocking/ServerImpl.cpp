@@ -251,7 +251,7 @@ void ServerImpl::RunConnection(int socket) {
                 out = std::string("SERVER_ERROR : ") + e.what() + "\r\n";
             }
 
-            if (send(socket, out.data(), out.size(), 0) <= 0) {
+            if (!parser.NoReply() && send(socket, out.data(), out.size(), 0) <= 0) {
                 throw std::runtime_error("Socket dend() failed");
             }
 
@@ -0,0 +1,110 @@
+#ifndef AFINA_NETWORK_UV_SPSC_QUEUE_H
+#define AFINA_NETWORK_UV_SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+namespace Afina {
+namespace Network {
+namespace UV {
+
+/**
+ * # Bounded lock-free single producer/single consumer queue
+ * Ring buffer where only one thread is allowed to call Push and only one (possibly other) thread
+ * is allowed to call Pop. Capacity is rounded up to the power of two.
+ *
+ * Producer and consumer indexes live on separate cache lines, each side caches the last seen value
+ * of the opposite index so that cache line is touched only when queue looks full/empty
+ */
+template <typename T> class SPSCQueue {
+public:
+    SPSCQueue(size_t capacity) : _head(0), _cached_tail(0), _tail(0), _cached_head(0) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        _mask = size - 1;
+        _items.resize(size);
+    }
+
+    SPSCQueue(const SPSCQueue &) = delete;
+    SPSCQueue &operator=(const SPSCQueue &) = delete;
+
+    /**
+     * Indexes are aligned to the cache line, more than operator new guarantees in C++11, so queue takes
+     * memory aligned explicitly
+     */
+    static void *operator new(size_t size) {
+        void *p = nullptr;
+        if (posix_memalign(&p, CacheLineSize, size) != 0) {
+            throw std::bad_alloc();
+        }
+        return p;
+    }
+
+    static void operator delete(void *p) { free(p); }
+
+    /**
+     * Producer side. Returns false if queue is full, in a such case item isn't changed
+     */
+    bool Push(const T &item) {
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _cached_head > _mask) {
+            _cached_head = _head.load(std::memory_order_acquire);
+            if (tail - _cached_head > _mask) {
+                return false;
+            }
+        }
+
+        _items[tail & _mask] = item;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Consumer side. Returns false if queue is empty, otherwise moves the oldest item into output
+     * parameter
+     */
+    bool Pop(T &item) {
+        size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _cached_tail) {
+            _cached_tail = _tail.load(std::memory_order_acquire);
+            if (head == _cached_tail) {
+                return false;
+            }
+        }
+
+        item = _items[head & _mask];
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Approximate check, exact only if called by consumer or producer
+     */
+    bool Empty() const { return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire); }
+
+private:
+    static const size_t CacheLineSize = 64;
+
+    // Consumer side
+    alignas(CacheLineSize) std::atomic<size_t> _head;
+    size_t _cached_tail;
+
+    // Producer side
+    alignas(CacheLineSize) std::atomic<size_t> _tail;
+    size_t _cached_head;
+
+    // Read-only after construction
+    alignas(CacheLineSize) size_t _mask;
+    std::vector<T> _items;
+};
+
+} // namespace UV
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_UV_SPSC_QUEUE_H
@@ -12,7 +12,8 @@ namespace Network {
 namespace UV {
 
 // See Server.h
-ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps) : Server(ps) {}
+ServerImpl::ServerImpl(std::shared_ptr<Afina::Storage> ps, PartitionFactory factory)
+    : Server(ps), partitionFactory(factory) {}
 
 // See Server.h
 ServerImpl::~ServerImpl() { assert(workers.size() == 0); }
@@ -27,8 +28,25 @@ void ServerImpl::Start(uint32_t port, uint16_t n_workers) {
         throw std::runtime_error("Failed to call uv_ip4_addr");
     }
 
+    if (partitionFactory) {
+        // All workers must know about each other before the first one starts
+        for (auto i = 0; i < n_workers; i++) {
+            partitionStorages.push_back(partitionFactory(i, n_workers));
+            partitionStorages.back()->Start();
+            workers.push_back(new Worker(partitionStorages.back()));
+        }
+
+        partitions.workers = workers;
+        for (auto i = 0; i < n_workers; i++) {
+            workers[i]->SetPartitions(&partitions, i);
+        }
+    } else {
+        for (auto i = 0; i < n_workers; i++) {
+            workers.push_back(new Worker(pStorage));
+        }
+    }
+
     for (auto i = 0; i < n_workers; i++) {
-        workers.push_back(new Worker(pStorage));
         workers[i]->Start(address);
     }
 }
@@ -44,6 +62,13 @@ void ServerImpl::Stop() {
 void ServerImpl::Join() {
     for (auto worker : workers) {
         worker->Join();
+        delete worker;
+    }
+    workers.clear();
+    partitions.workers.clear();
+
+    for (auto &partition : partitionStorages) {
+        partition->Stop();
     }
 }
 
@@ -1,6 +1,7 @@
 #ifndef AFINA_NETWORK_UV_SERVER_H
 #define AFINA_NETWORK_UV_SERVER_H
 
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -19,7 +20,16 @@ namespace UV {
  */
 class ServerImpl : public Server {
 public:
-    ServerImpl(std::shared_ptr<Afina::Storage> ps);
+    /**
+     * Creates storage partition for the worker with the given index out of the given number of workers
+     */
+    typedef std::function<std::shared_ptr<Afina::Storage>(size_t index, size_t count)> PartitionFactory;
+
+    /**
+     * In case if partition factory is given server works in the shared-nothing mode: each worker
+     * gets its own storage partition and given shared storage isn't used
+     */
+    ServerImpl(std::shared_ptr<Afina::Storage> ps, PartitionFactory factory = nullptr);
     ~ServerImpl();
 
     // See Server.h
@@ -36,6 +46,21 @@ protected:
      * List of all workers created for this instance of server
      */
     std::vector<Worker *> workers;
+
+    /**
+     * Builds partitions for the shared-nothing mode, empty if storage is shared
+     */
+    PartitionFactory partitionFactory;
+
+    /**
+     * Partitions owned by workers in the shared-nothing mode
+     */
+    std::vector<std::shared_ptr<Afina::Storage>> partitionStorages;
+
+    /**
+     * State shared by workers in the shared-nothing mode
+     */
+    Partitions partitions;
 };
 
 } // namespace UV
@@ -0,0 +1,364 @@
+#ifndef AFINA_NETWORK_UV_STATIC_SERVER_H
+#define AFINA_NETWORK_UV_STATIC_SERVER_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <uv.h>
+#include <vector>
+
+#include <afina/allocator/Slab.h>
+#include <afina/execute/StaticCommand.h>
+#include <afina/network/Server.h>
+#include <protocol/Parser.h>
+
+namespace Afina {
+namespace Network {
+namespace UV {
+
+/**
+ * # Worker of the compile time composed server
+ * Event loop the same as in Worker, but the storage type is known at compile time and commands are parsed into
+ * Execute::StaticCommand, so get/set/add/append/delete run without allocating command object and without
+ * virtual calls. Commands are executed right in the event loop, replies to everything read at once are sent
+ * by a single write.
+ *
+ * Works with storage shared between workers only
+ */
+template <typename TStorage> class StaticWorker {
+public:
+    StaticWorker(std::shared_ptr<TStorage> storage) : storage(storage) {}
+
+    StaticWorker(const StaticWorker &) = delete;
+    StaticWorker &operator=(const StaticWorker &) = delete;
+
+    /**
+     * Starts listening the address in a new thread
+     */
+    void Start(const struct sockaddr_storage &address) {
+        Check(uv_loop_init(&uvLoop), "uv_loop_init");
+
+        Check(uv_async_init(&uvLoop, &uvStopAsync, &StaticWorker::OnStop), "uv_async_init");
+        uvStopAsync.data = this;
+
+        Check(uv_signal_init(&uvLoop, &uvSigPipe), "uv_signal_init");
+        Check(uv_signal_start(&uvSigPipe, [](uv_signal_t *, int) {}, SIGPIPE), "uv_signal_start");
+
+        Check(uv_tcp_init_ex(&uvLoop, &uvNetwork, address.ss_family), "uv_tcp_init_ex");
+        uvNetwork.data = this;
+
+        int fd;
+        Check(uv_fileno((uv_handle_t *)&uvNetwork, &fd), "uv_fileno");
+        Check(uv_tcp_keepalive(&uvNetwork, 1, 60), "uv_tcp_keepalive");
+
+        int on = 1;
+        if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) != 0) {
+            throw std::runtime_error("Failed to call setsockopt");
+        }
+
+        Check(uv_tcp_bind(&uvNetwork, (const struct sockaddr *)&address, 0), "uv_tcp_bind");
+        Check(uv_listen((uv_stream_t *)&uvNetwork, 511, &StaticWorker::OnConnectionOpen), "uv_listen");
+        Check(uv_thread_create(&thread, &StaticWorker::OnRun, this), "uv_thread_create");
+    }
+
+    /**
+     * Signals worker to stop, see Worker::Stop
+     */
+    void Stop() { uv_async_send(&uvStopAsync); }
+
+    /**
+     * Blocks calling thread until worker is stopped
+     */
+    void Join() {
+        if (uv_thread_join(&thread) != 0) {
+            throw std::runtime_error("Failed to join event loop thread");
+        }
+    }
+
+private:
+    // Size of input buffer
+    const static size_t ConnectionInputBufferSize = 64 * 1024L;
+
+    enum ConnectionState : uint8_t { sRecvHeader, sRecvBody, sRecvTrailerCR, sRecvTrailerLF, sExecute };
+
+    /**
+     * Holds information about single connection from the client, taken from the slab pool
+     */
+    struct Connection : Allocator::SlabAllocated<Connection> {
+        Connection(StaticWorker *worker)
+            : worker(worker), state(ConnectionState::sRecvHeader), input(ConnectionInputBufferSize), input_used(0),
+              input_parsed(0), body_size(0), closed(false), writing(false), closing(false) {
+            handler.data = this;
+        }
+
+        uv_tcp_t handler;
+        StaticWorker *worker;
+
+        ConnectionState state;
+        std::vector<char> input;
+        size_t input_used;
+        size_t input_parsed;
+
+        Protocol::Parser parser;
+        Execute::StaticCommand cmd;
+        uint32_t body_size;
+        std::string body;
+
+        // Replies not sent yet and replies being written now
+        std::string output;
+        std::string sending;
+        uv_write_t write;
+
+        // No more commands are read, connection is closed once output is written out
+        bool closed;
+        bool writing;
+        bool closing;
+    };
+
+    static void Check(int rc, const char *call) {
+        if (rc != 0) {
+            std::stringstream ss;
+            ss << "Failed to call " << call << ": [" << uv_err_name(rc) << ", " << rc << "]: " << uv_strerror(rc);
+            throw std::runtime_error(ss.str());
+        }
+    }
+
+    static void OnRun(void *arg) {
+        StaticWorker *worker = static_cast<StaticWorker *>(arg);
+        uv_run(&worker->uvLoop, UV_RUN_DEFAULT);
+        uv_loop_close(&worker->uvLoop);
+    }
+
+    static void OnStop(uv_async_t *async) {
+        StaticWorker *worker = static_cast<StaticWorker *>(async->data);
+        uv_close((uv_handle_t *)&worker->uvStopAsync, nullptr);
+        uv_close((uv_handle_t *)&worker->uvSigPipe, nullptr);
+        uv_close((uv_handle_t *)&worker->uvNetwork, nullptr);
+
+        // Loop exits once the last connection gets closed
+        for (auto pconn : worker->alive) {
+            pconn->closed = true;
+            uv_read_stop((uv_stream_t *)&pconn->handler);
+            worker->Flush(pconn);
+        }
+    }
+
+    static void OnConnectionOpen(uv_stream_t *server, int status) {
+        StaticWorker *worker = static_cast<StaticWorker *>(server->data);
+        if (status != 0) {
+            return;
+        }
+
+        Connection *pconn = new Connection(worker);
+        uv_tcp_init(&worker->uvLoop, &pconn->handler);
+        worker->alive.insert(pconn);
+
+        if (uv_accept(server, (uv_stream_t *)&pconn->handler) != 0 ||
+            uv_read_start((uv_stream_t *)&pconn->handler, &StaticWorker::OnAllocate, &StaticWorker::OnRead) != 0) {
+            pconn->closed = true;
+            worker->Flush(pconn);
+        }
+    }
+
+    static void OnConnectionClosed(uv_handle_t *handle) {
+        Connection *pconn = static_cast<Connection *>(handle->data);
+        pconn->worker->alive.erase(pconn);
+        delete pconn;
+    }
+
+    static void OnAllocate(uv_handle_t *handle, size_t suggested_size, uv_buf_t *buf) {
+        Connection *pconn = static_cast<Connection *>(handle->data);
+
+        size_t unparsed = pconn->input_used - pconn->input_parsed;
+        std::memmove(&pconn->input[0], &pconn->input[pconn->input_parsed], unparsed);
+        pconn->input_parsed = 0;
+        pconn->input_used = unparsed;
+
+        buf->base = &pconn->input[unparsed];
+        buf->len = ConnectionInputBufferSize - unparsed;
+    }
+
+    static void OnRead(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf) {
+        Connection *pconn = static_cast<Connection *>(stream->data);
+        StaticWorker *worker = pconn->worker;
+        if (nread < 0) {
+            pconn->closed = true;
+            uv_read_stop(stream);
+        } else if (!pconn->closed) {
+            pconn->input_used += nread;
+            worker->Process(*pconn);
+        }
+        worker->Flush(pconn);
+    }
+
+    static void OnWriteDone(uv_write_t *req, int status) {
+        Connection *pconn = static_cast<Connection *>(req->data);
+        pconn->writing = false;
+        if (status != 0) {
+            // Peer is gone, nothing else could be sent
+            pconn->closed = true;
+            pconn->output.clear();
+        }
+        pconn->worker->Flush(pconn);
+    }
+
+    /**
+     * Parses and executes all complete commands from the connection input, replies are appended to the
+     * connection output
+     */
+    void Process(Connection &pconn) {
+        try {
+            while (pconn.input_parsed < pconn.input_used) {
+                if (pconn.state == ConnectionState::sRecvHeader) {
+                    size_t parsed = 0;
+                    bool complete = pconn.parser.Parse(&pconn.input[pconn.input_parsed],
+                                                       pconn.input_used - pconn.input_parsed, parsed);
+                    pconn.input_parsed += parsed;
+                    if (!complete) {
+                        continue;
+                    }
+
+                    pconn.body_size = 0;
+                    pconn.parser.Build(pconn.cmd, pconn.body_size);
+                    pconn.state = pconn.body_size > 0 ? ConnectionState::sRecvBody : ConnectionState::sExecute;
+                } else if (pconn.state == ConnectionState::sRecvBody) {
+                    size_t for_copy = std::min(uint32_t(pconn.input_used - pconn.input_parsed), pconn.body_size);
+                    pconn.body.append(&pconn.input[pconn.input_parsed], for_copy);
+                    pconn.body_size -= for_copy;
+                    pconn.input_parsed += for_copy;
+                    if (pconn.body_size == 0) {
+                        pconn.state = ConnectionState::sRecvTrailerCR;
+                    }
+                } else if (pconn.state == ConnectionState::sRecvTrailerCR) {
+                    if (pconn.input[pconn.input_parsed++] != '\r') {
+                        throw std::runtime_error("Invalid chat, \\r expected");
+                    }
+                    pconn.state = ConnectionState::sRecvTrailerLF;
+                } else if (pconn.state == ConnectionState::sRecvTrailerLF) {
+                    if (pconn.input[pconn.input_parsed++] != '\n') {
+                        throw std::runtime_error("Invalid chat, \\n expected");
+                    }
+                    pconn.state = ConnectionState::sExecute;
+                }
+
+                if (pconn.state == ConnectionState::sExecute) {
+                    size_t reply_start = pconn.output.size();
+                    try {
+                        Execute::ExecuteStatic(*storage, pconn.cmd, pconn.body, pconn.output);
+                    } catch (std::runtime_error &ex) {
+                        pconn.output.append("SERVER_ERROR ").append(ex.what());
+                    }
+                    if (pconn.parser.NoReply()) {
+                        pconn.output.resize(reply_start);
+                    } else {
+                        pconn.output.append("\r\n");
+                    }
+
+                    pconn.body.clear();
+                    pconn.parser.Reset();
+                    pconn.state = ConnectionState::sRecvHeader;
+                }
+            }
+        } catch (std::runtime_error &ex) {
+            // Parser throws exception in case if something goes wrong with input data format
+            pconn.output.append("CLIENT_ERROR ").append(ex.what()).append("\r\n");
+            pconn.closed = true;
+            uv_read_stop((uv_stream_t *)&pconn.handler);
+        }
+    }
+
+    /**
+     * Starts writing pending replies unless write is in progress already, closes connection once everything
+     * is written out
+     */
+    void Flush(Connection *pconn) {
+        if (pconn->writing || pconn->closing) {
+            return;
+        }
+
+        if (!pconn->output.empty()) {
+            pconn->sending.swap(pconn->output);
+            pconn->output.clear();
+
+            uv_buf_t buf = uv_buf_init(&pconn->sending[0], pconn->sending.size());
+            pconn->write.data = pconn;
+            if (uv_write(&pconn->write, (uv_stream_t *)&pconn->handler, &buf, 1, &StaticWorker::OnWriteDone) == 0) {
+                pconn->writing = true;
+                return;
+            }
+            pconn->closed = true;
+        }
+
+        if (pconn->closed) {
+            pconn->closing = true;
+            uv_close((uv_handle_t *)&pconn->handler, &StaticWorker::OnConnectionClosed);
+        }
+    }
+
+    std::shared_ptr<TStorage> storage;
+
+    uv_thread_t thread;
+    uv_loop_t uvLoop;
+    uv_signal_t uvSigPipe;
+    uv_async_t uvStopAsync;
+    uv_tcp_t uvNetwork;
+
+    // Connections that are not closed yet
+    std::unordered_set<Connection *> alive;
+};
+
+/**
+ * # Network server composed at compile time
+ * Same as ServerImpl over shared storage, but instantiated for the concrete storage type, so the whole
+ * request path could be inlined, see StaticWorker. Storage partitions are not supported
+ */
+template <typename TStorage> class StaticServerImpl : public Server {
+public:
+    StaticServerImpl(std::shared_ptr<TStorage> ps) : Server(ps), storage(ps) {}
+    ~StaticServerImpl() { assert(workers.empty()); }
+
+    // See Server.h
+    void Start(uint32_t port, uint16_t n_workers) override {
+        struct sockaddr_storage address;
+        int rc = uv_ip4_addr("0.0.0.0", port, (struct sockaddr_in *)&address);
+        if (rc != 0) {
+            throw std::runtime_error("Failed to call uv_ip4_addr");
+        }
+
+        for (auto i = 0; i < n_workers; i++) {
+            workers.emplace_back(new StaticWorker<TStorage>(storage));
+            workers.back()->Start(address);
+        }
+    }
+
+    // See Server.h
+    void Stop() override {
+        for (auto &worker : workers) {
+            worker->Stop();
+        }
+    }
+
+    // See Server.h
+    void Join() override {
+        for (auto &worker : workers) {
+            worker->Join();
+        }
+        workers.clear();
+    }
+
+private:
+    std::shared_ptr<TStorage> storage;
+    std::vector<std::unique_ptr<StaticWorker<TStorage>>> workers;
+};
+
+} // namespace UV
+} // namespace Network
+} // namespace Afina
+
+#endif // AFINA_NETWORK_UV_STATIC_SERVER_H
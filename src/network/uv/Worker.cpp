@@ -1,14 +1,27 @@
 #include "Worker.h"
 
+#include <algorithm>
 #include <arpa/inet.h>
 #include <cassert>
+#include <chrono>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
+#include <thread>
 
 #include <afina/Storage.h>
 #include <afina/execute/Command.h>
+#include <afina/execute/Delete.h>
+#include <afina/execute/FlushAll.h>
+#include <afina/execute/Get.h>
+#include <afina/execute/InsertCommand.h>
+#include <afina/execute/Invalidate.h>
+#include <afina/execute/LeaseGet.h>
+#include <afina/execute/Load.h>
+#include <afina/execute/Stats.h>
+#include <storage/KeyHash.h>
 
 namespace Afina {
 namespace Network {
@@ -53,6 +66,43 @@ template <typename T, typename... Types> struct delegate {
 
 void noop(uv_signal_t *handle, int signum) {}
 
+// Returns size of the get reply item at the given position of the output if it is the item of the key, 0 otherwise
+size_t ItemSize(const std::string &output, size_t pos, const Allocator::String &key) {
+    static const char prefix[] = "VALUE ";
+    const size_t head = sizeof(prefix) - 1;
+    if (output.size() <= pos + head + key.size() || output.compare(pos, head, prefix) != 0 ||
+        output.compare(pos + head, key.size(), key.data(), key.size()) != 0 || output[pos + head + key.size()] != ' ') {
+        return 0;
+    }
+
+    // VALUE <key> <flags> <bytes>\r\n<data>\r\n
+    size_t eol = output.find("\r\n", pos);
+    if (eol == std::string::npos) {
+        return 0;
+    }
+    size_t bytes = std::strtoull(output.c_str() + output.rfind(' ', eol) + 1, nullptr, 10);
+    size_t end = eol + 2 + bytes + 2;
+    return end <= output.size() ? end - pos : 0;
+}
+
+// See Worker.h
+Allocator::Resource &Worker::ContainerPool() {
+    // Connections could outlive workers until the loop closes them, so pool is never destroyed
+    static Allocator::SlabResource *pool = new Allocator::SlabResource("uv");
+    return *pool;
+}
+
+// See Worker.h
+void Worker::SetPartitions(Partitions *p, size_t index) {
+    partitions = p;
+    partitionIndex = index;
+
+    inbox.clear();
+    for (size_t i = 0; i < partitions->workers.size(); i++) {
+        inbox.emplace_back(new SPSCQueue<PartitionJob>(InboxSize));
+    }
+}
+
 // See Worker.h
 void Worker::Start(const struct sockaddr_storage &address) {
     // Init loop
@@ -73,6 +123,19 @@ void Worker::Start(const struct sockaddr_storage &address) {
     }
     uvStopAsync.data = this;
 
+    // Init shared-nothing infrastructure. Inbox doesn't hold loop, peers could forward jobs
+    // even after this worker stops, see OnRun
+    if (partitions != nullptr) {
+        rc = uv_async_init(&uvLoop, &uvInboxAsync, delegate<Worker>::callback<&Worker::OnInbox>);
+        if (rc != 0) {
+            std::stringstream ss;
+            ss << "Failed to call uv_async_init: [" << uv_err_name(rc) << ", " << rc << "]: " << uv_strerror(rc);
+            throw std::runtime_error(ss.str());
+        }
+        uvInboxAsync.data = this;
+        uv_unref((uv_handle_t *)&uvInboxAsync);
+    }
+
     // Init signals
     rc = uv_signal_init(&uvLoop, &uvSigPipe);
     if (rc != 0) {
@@ -154,8 +217,29 @@ void Worker::Join() {
 // Once loop terminated, method cleans up all local resources
 // See Worker.h
 void Worker::OnRun() {
+    if (partitions != nullptr) {
+        // Peers could enqueue jobs before thread started, pick them up
+        inboxReady.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        DrainInbox();
+    }
+
     // Run network loop, that call won't return until event loop shuted down by libuv routines
     uv_run(&uvLoop, UV_RUN_DEFAULT);
+
+    if (partitions != nullptr) {
+        // Other workers could still have commands for keys of this partition in flight, so inbox must be
+        // served until every worker leaves its event loop. After that nobody is able to forward anything
+        partitions->finished++;
+        while (partitions->finished.load() < partitions->workers.size()) {
+            DrainInbox();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        DrainInbox();
+
+        uv_close((uv_handle_t *)&uvInboxAsync, nullptr);
+        uv_run(&uvLoop, UV_RUN_DEFAULT);
+    }
 }
 
 // Called once signal from outside world received that it is time to stop the network layer.
@@ -176,8 +260,8 @@ void Worker::OnStop(uv_async_t *async) {
         conn->state = ConnectionState::sClosed;
         uv_read_stop((uv_stream_t *)conn);
 
-        // Try to close connections if possible
-        if (conn->runningTasks == 0) {
+        // Try to close connections if possible, connection closed by peer could be closing already
+        if (conn->runningTasks == 0 && !uv_is_closing((uv_handle_t *)conn)) {
             uv_close((uv_handle_t *)conn, delegate<Worker>::callback<&Worker::OnConnectionClosed>);
         }
     }
@@ -282,9 +366,14 @@ void Worker::OnRead(uv_stream_t *conn, ssize_t nread, const uv_buf_t *buf) {
     assert(conn != nullptr);
     Connection *pconn = (Connection *)(conn);
 
-    // negative nread indicates that socket has been closed
+    // negative nread indicates that socket has been closed. Replies to the commands that are still
+    // executing must be written out first, so connection gets closed by the last OnWriteDone
     if (nread < 0) {
-        uv_close((uv_handle_t *)(pconn), delegate<Worker>::callback<&Worker::OnConnectionClosed>);
+        pconn->state = ConnectionState::sClosed;
+        uv_read_stop(conn);
+        if (pconn->runningTasks == 0) {
+            uv_close((uv_handle_t *)(pconn), delegate<Worker>::callback<&Worker::OnConnectionClosed>);
+        }
         return;
     } else if (pconn->state == ConnectionState::sClosed) {
         return;
@@ -297,8 +386,12 @@ void Worker::OnRead(uv_stream_t *conn, ssize_t nread, const uv_buf_t *buf) {
         while (pconn->input_parsed < pconn->input_used) {
             // Read header or body if needs
             if (pconn->state == ConnectionState::sRecvHeader) {
-                // Try to parse command out
-                if (!pconn->parser.Parse(pconn->input, pconn->input_used, pconn->input_parsed)) {
+                // Try to parse command out, parser reports bytes consumed from the given position
+                size_t parsed = 0;
+                bool complete = pconn->parser.Parse(pconn->input + pconn->input_parsed,
+                                                    pconn->input_used - pconn->input_parsed, parsed);
+                pconn->input_parsed += parsed;
+                if (!complete) {
                     continue;
                 }
 
@@ -347,74 +440,319 @@ void Worker::OnRead(uv_stream_t *conn, ssize_t nread, const uv_buf_t *buf) {
             }
         }
     } catch (std::runtime_error &ex) {
-        // Parser throws exception in case if something goes wrong with input data format
-        // TODO: That code duplicates too much of OnExecutionDone - refactor
-        std::stringstream ss;
-        ss << "CLIENT_ERROR " << ex.what();
-
-        std::string output = ss.str();
-
-        ExecuteTask *ptask = new ExecuteTask();
-        ptask->connection = pconn;
-        uv_async_init(&uvLoop, &ptask->done, delegate<Worker>::callback<&Worker::OnExecutionDone>);
-        ptask->done.data = this;
-
-        size_t size = output.size() + 2;
-        ptask->result.base = new char[size];
-        ptask->result.len = size;
-
-        std::memcpy(ptask->result.base, &output[0], size - 2);
-        ptask->result.base[size - 2] = '\r';
-        ptask->result.base[size - 1] = '\n';
-
-        pconn->runningTasks++;
+        // Parser throws exception in case if something goes wrong with input data format, error is replied
+        // as if it was output of the command
         pconn->state = ConnectionState::sClosed;
-        OnExecutionDone(&ptask->done);
+        Reply(*pconn, std::string("CLIENT_ERROR ") + ex.what());
     }
 }
 
+// See Worker.h
+void Worker::Reply(Connection &pconn, std::string output) {
+    ExecuteTask *ptask = new ExecuteTask();
+    ptask->connection = &pconn;
+    uv_async_init(&uvLoop, &ptask->done.handle, delegate<Worker>::callback<&Worker::OnExecutionDone>);
+    ptask->done.handle.data = this;
+    ptask->done.task = ptask;
+    ptask->broadcast = false;
+    ptask->noreply = false;
+    ptask->parts.resize(1);
+    ptask->parts[0].output = std::move(output);
+
+    pconn.runningTasks++;
+    pconn.replies.push_back(ptask);
+    OnExecutionDone(&ptask->done.handle);
+}
+
 // See Worker.h
 void Worker::Execute(Connection &pconn) {
     std::cout << "network debug:" << __PRETTY_FUNCTION__ << std::endl;
 
+    // Would load all keys into the local partition
+    if (partitions != nullptr && dynamic_cast<const Execute::Load *>(pconn.cmd.get()) != nullptr) {
+        Reply(pconn, "SERVER_ERROR Load isn't supported in partitioned mode, use --load option");
+        return;
+    }
+
     // Setup execution params
     ExecuteTask *ptask = new ExecuteTask();
     ptask->connection = &pconn;
-    ptask->cmd = std::move(pconn.cmd);
     ptask->argument = std::move(pconn.body);
+    ptask->noreply = pconn.parser.NoReply();
+    Split(std::move(pconn.cmd), *ptask);
+    ptask->pending.store(ptask->parts.size());
     pconn.runningTasks++;
+    pconn.replies.push_back(ptask);
 
     // Setup async signal to be called once task execution is complete
-    int rc = uv_async_init(&uvLoop, &ptask->done, delegate<Worker>::callback<&Worker::OnExecutionDone>);
+    int rc = uv_async_init(&uvLoop, &ptask->done.handle, delegate<Worker>::callback<&Worker::OnExecutionDone>);
     if (rc != 0) {
         throw std::runtime_error("Failed to call uv_async_init for the task");
     }
-    ptask->done.data = this;
+    ptask->done.handle.data = this;
+    ptask->done.task = ptask;
+
+    // Local parts are executed right here, others are sent to partition owners. Note that task
+    // could be completed and even released by other thread once the last part is dispatched
+    size_t parts = ptask->parts.size();
+    for (size_t i = 0; i < parts; i++) {
+        PartitionJob job = {ptask, i};
+        size_t owner = partitions == nullptr ? partitionIndex : ptask->parts[i].owner;
+        if (owner == partitionIndex) {
+            RunPart(job);
+        } else {
+            Forward(owner, job);
+        }
+    }
+}
 
-    // TODO: That should be in another thread
-    {
-        std::string output;
-        try {
-            ptask->cmd->Execute(*pStorage, ptask->argument, output);
-        } catch (std::runtime_error &ex) {
-            std::cerr << "Failed to execute command: " << ex.what() << std::endl;
+// See Worker.h
+void Worker::Split(std::unique_ptr<Execute::Command> cmd, ExecuteTask &task) const {
+    ExecuteParts &parts = task.parts;
+    task.broadcast = false;
+
+    const Execute::Get *get = nullptr;
+    if (partitions != nullptr) {
+        get = dynamic_cast<const Execute::Get *>(cmd.get());
+
+        const Execute::FlushAll *flush = dynamic_cast<const Execute::FlushAll *>(cmd.get());
+        if (flush != nullptr) {
+            task.broadcast = true;
+            parts.resize(partitions->workers.size());
+            for (size_t i = 0; i < parts.size(); i++) {
+                parts[i].cmd.reset(new Execute::FlushAll(flush->delay()));
+                parts[i].owner = i;
+            }
+            return;
+        }
 
-            std::stringstream ss;
-            ss << "SERVER_ERROR " << ex.what();
-            output = ss.str();
+        // Keyspace report covers all partitions, replies are merged back into one
+        const Execute::Stats *stats = dynamic_cast<const Execute::Stats *>(cmd.get());
+        if (stats != nullptr && stats->group() == "keyspace") {
+            task.broadcast = true;
+            parts.resize(partitions->workers.size());
+            for (size_t i = 0; i < parts.size(); i++) {
+                parts[i].cmd.reset(new Execute::Stats(stats->group()));
+                parts[i].owner = i;
+            }
+            return;
+        }
+    }
+
+    if (get != nullptr && get->keys().size() > 1) {
+        const Execute::Get::Keys &keys = get->keys();
+
+        size_t owner = OwnerOf(keys[0]);
+        bool single = true;
+        for (auto &key : keys) {
+            single = single && OwnerOf(key) == owner;
+        }
+
+        if (!single) {
+            // One part per partition, keys keep their order within the part
+            const size_t none = partitions->workers.size();
+            Allocator::Vector<size_t> partOf(partitions->workers.size(), none,
+                                             Allocator::StlAllocator<size_t>(task.connection->scratch));
+            std::vector<Execute::Get::Keys> partKeys;
+            task.order.reserve(keys.size());
+            for (auto &key : keys) {
+                size_t owner = OwnerOf(key);
+                if (partOf[owner] == none) {
+                    partOf[owner] = parts.size();
+                    parts.resize(parts.size() + 1);
+                    parts.back().owner = owner;
+                    partKeys.emplace_back(keys.get_allocator());
+                }
+                partKeys[partOf[owner]].push_back(key);
+                task.order.push_back(partOf[owner]);
+            }
+
+            for (size_t i = 0; i < parts.size(); i++) {
+                parts[i].cmd.reset(new Execute::Get(std::move(partKeys[i])));
+            }
+            return;
+        }
+    }
+
+    parts.resize(1);
+    parts[0].owner = partitions == nullptr ? partitionIndex : OwnerOf(*cmd);
+    parts[0].cmd = std::move(cmd);
+}
+
+// See Worker.h
+size_t Worker::OwnerOf(const char *key, size_t size) const {
+    return Backend::KeyHashShard(Backend::KeyHash(key, size), partitions->workers.size());
+}
+
+// See Worker.h
+size_t Worker::OwnerOf(const Execute::Command &cmd) const {
+    const Execute::InsertCommand *insert = dynamic_cast<const Execute::InsertCommand *>(&cmd);
+    if (insert != nullptr) {
+        return OwnerOf(insert->key());
+    }
+
+    const Execute::Get *get = dynamic_cast<const Execute::Get *>(&cmd);
+    if (get != nullptr && !get->keys().empty()) {
+        return OwnerOf(get->keys()[0]);
+    }
+
+    const Execute::Delete *del = dynamic_cast<const Execute::Delete *>(&cmd);
+    if (del != nullptr) {
+        return OwnerOf(del->key());
+    }
+
+    const Execute::LeaseGet *lget = dynamic_cast<const Execute::LeaseGet *>(&cmd);
+    if (lget != nullptr) {
+        return OwnerOf(lget->key());
+    }
+
+    const Execute::Invalidate *invalidate = dynamic_cast<const Execute::Invalidate *>(&cmd);
+    if (invalidate != nullptr) {
+        return OwnerOf(invalidate->key());
+    }
+
+    // Commands without keys are executed on the local partition
+    return partitionIndex;
+}
+
+// See Worker.h
+void Worker::RunPart(const PartitionJob &job) {
+    ExecutePart &part = job.task->parts[job.part];
+    try {
+        part.cmd->Execute(*pStorage, job.task->argument, part.output);
+    } catch (std::runtime_error &ex) {
+        std::cerr << "Failed to execute command: " << ex.what() << std::endl;
+
+        std::stringstream ss;
+        ss << "SERVER_ERROR " << ex.what();
+        part.output = ss.str();
+    }
+
+    if (job.task->pending.fetch_sub(1) == 1) {
+        Complete(job.task);
+    }
+}
+
+// See Worker.h
+void Worker::Complete(ExecuteTask *ptask) {
+    // Notify event loop about task completition
+    uv_async_send(&ptask->done.handle);
+}
+
+// See Worker.h
+void Worker::BuildResult(ExecuteTask &task) {
+    if (task.noreply) {
+        task.result.base = nullptr;
+        task.result.len = 0;
+        return;
+    }
+
+    // Output of each part is copied once right into the result buffer
+    const std::string *single = nullptr;
+    std::string merged;
+    size_t size = 2;
+    if (task.parts.size() == 1) {
+        single = &task.parts[0].output;
+    } else if (task.broadcast && dynamic_cast<const Execute::Stats *>(task.parts[0].cmd.get()) != nullptr) {
+        std::vector<const std::string *> outputs;
+        for (auto &part : task.parts) {
+            outputs.push_back(&part.output);
+        }
+        Execute::Stats::Merge(outputs, merged);
+        single = &merged;
+    } else if (task.broadcast) {
+        // All partitions reply the same unless some failed
+        single = &task.parts[0].output;
+        for (size_t i = 1; i < task.parts.size(); i++) {
+            if (task.parts[i].output != *single) {
+                single = &task.parts[i].output;
+                break;
+            }
         }
+    } else {
+        // Multi-key get splitted between partitions, each part lists items of its keys and is terminated by END
+        for (auto &part : task.parts) {
+            size_t len = part.output.size();
+            if (len >= 3 && part.output.compare(len - 3, 3, "END") == 0) {
+                len -= 3;
+            }
+            size += len;
+        }
+        size += 3;
+    }
+    if (single != nullptr) {
+        size += single->size();
+    }
 
-        // Prepare output
-        size_t size = output.size() + 2;
-        ptask->result.base = new char[size];
-        ptask->result.len = size;
+    char *result = static_cast<char *>(task.connection->scratch.allocate(size));
+    char *pos = result;
+    if (single != nullptr) {
+        pos = std::copy(single->begin(), single->end(), pos);
+    } else {
+        // Items are taken from the parts in the order of keys, part that failed has no items and its error
+        // goes after them
+        Allocator::StlAllocator<size_t> scratch(task.connection->scratch);
+        Allocator::Vector<size_t> from(task.parts.size(), 0, scratch), next(task.parts.size(), 0, scratch);
+        for (size_t i : task.order) {
+            const std::string &output = task.parts[i].output;
+            const Execute::Get &get = static_cast<const Execute::Get &>(*task.parts[i].cmd);
+            size_t len = ItemSize(output, from[i], get.keys()[next[i]++]);
+            pos = std::copy(output.begin() + from[i], output.begin() + from[i] + len, pos);
+            from[i] += len;
+        }
 
-        std::memcpy(ptask->result.base, &output[0], size - 2);
-        ptask->result.base[size - 2] = '\r';
-        ptask->result.base[size - 1] = '\n';
+        for (size_t i = 0; i < task.parts.size(); i++) {
+            const std::string &output = task.parts[i].output;
+            size_t len = output.size();
+            if (len >= 3 && output.compare(len - 3, 3, "END") == 0) {
+                len -= 3;
+            }
+            pos = std::copy(output.begin() + std::min(from[i], len), output.begin() + len, pos);
+        }
+        pos = std::copy_n("END", 3, pos);
+    }
+    pos[0] = '\r';
+    pos[1] = '\n';
 
-        // Notify event loop about task completition
-        uv_async_send(&ptask->done);
+    task.result.base = result;
+    task.result.len = size;
+}
+
+// See Worker.h
+void Worker::Forward(size_t owner, const PartitionJob &job) {
+    Worker *peer = partitions->workers[owner];
+    SPSCQueue<PartitionJob> &queue = *peer->inbox[partitionIndex];
+
+    while (!queue.Push(job)) {
+        // Owner is overloaded. Keep serving own inbox while waiting, otherwise two workers
+        // forwarding to each other could deadlock
+        peer->WakeUp();
+        DrainInbox();
+        std::this_thread::yield();
+    }
+    peer->WakeUp();
+}
+
+// See Worker.h
+void Worker::WakeUp() {
+    // Pairs with the fence in OnRun: either owner thread sees the job during initial drain or
+    // job producer sees the inbox ready and wakes owner up
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (inboxReady.load()) {
+        uv_async_send(&uvInboxAsync);
+    }
+}
+
+// See Worker.h
+void Worker::OnInbox(uv_async_t *async) { DrainInbox(); }
+
+// See Worker.h
+void Worker::DrainInbox() {
+    PartitionJob job;
+    for (auto &queue : inbox) {
+        while (queue->Pop(job)) {
+            RunPart(job);
+        }
     }
 }
 
@@ -423,18 +761,32 @@ void Worker::OnExecutionDone(uv_async_t *handle) {
     std::cout << "network debug:" << __PRETTY_FUNCTION__ << std::endl;
 
     assert(handle);
-    ExecuteTask *task = (ExecuteTask *)((uint8_t *)handle - offsetof(ExecuteTask, done));
-    assert(&task->done == handle);
-
-    // We don't need async anymore
-    uv_close((uv_handle_t *)&task->done, delegate<Worker>::callback<&Worker::OnHandleClosed>);
+    ExecuteTask *task = reinterpret_cast<TaskSignal *>(handle)->task;
+    assert(&task->done.handle == handle);
+
+    BuildResult(*task);
+
+    // Write out all replies that are ready and not blocked by previous ones, libuv keeps order of writes
+    task->ready = true;
+    Replies &replies = task->connection->replies;
+    while (!replies.empty() && replies.front()->ready) {
+        ExecuteTask *reply = replies.front();
+        replies.pop_front();
+        if (reply->noreply) {
+            FinishReply(reply);
+            continue;
+        }
 
-    // Send buffer to socket. Even if connection is already closed we are still try to write data out,
-    // that would lead to possible write error which is ok and will be handled in the OnWriteDone
-    int rc = uv_write(&task->handler, &task->connection->handler, &task->result, 1,
-                      delegate<Worker, int>::callback<&Worker::OnWriteDone>);
-    if (rc != 0) {
-        throw std::runtime_error("Failed to write request");
+        // Send buffer to socket. Even if connection is already closed we are still try to write data out,
+        // that would lead to possible write error which is ok and will be handled in the OnWriteDone
+        int rc = uv_write(&reply->handler, &reply->connection->handler, &reply->result, 1,
+                          delegate<Worker, int>::callback<&Worker::OnWriteDone>);
+        if (rc != 0) {
+            // Peer is gone, reply is dropped the same way as if write has failed. Task itself is released
+            // later, once its async handle is closed
+            reply->connection->state = ConnectionState::sClosed;
+            FinishReply(reply);
+        }
     }
 }
 
@@ -442,16 +794,38 @@ void Worker::OnExecutionDone(uv_async_t *handle) {
 void Worker::OnWriteDone(uv_write_t *req, int status) {
     std::cout << "network debug:" << __PRETTY_FUNCTION__ << std::endl;
     assert(req != nullptr);
-    ExecuteTask *task = (ExecuteTask *)req;
+    FinishReply((ExecuteTask *)req);
+}
+
+// See Worker.h
+void Worker::FinishReply(ExecuteTask *task) {
+    // Commands could hold memory of the connection arena, they must go before the arena is reset and before
+    // the connection is released, the task itself outlives both
+    task->parts.clear();
+
     Connection *pconn = task->connection;
+    pconn->runningTasks--;
+    if (pconn->state == ConnectionState::sClosed && pconn->runningTasks == 0) {
+        uv_close((uv_handle_t *)(pconn), delegate<Worker>::callback<&Worker::OnConnectionClosed>);
+    }
+
+    pconn->scratch.deallocate(task->result.base, task->result.len);
+
+    // We don't need async anymore, libuv refers to the handle until close callback, which releases the task
+    uv_close((uv_handle_t *)&task->done.handle, delegate<Worker>::callback<&Worker::OnTaskClosed>);
 
-    task->connection->runningTasks--;
-    if (task->connection->state == ConnectionState::sClosed && task->connection->runningTasks == 0) {
-        uv_close((uv_handle_t *)(task->connection), delegate<Worker>::callback<&Worker::OnConnectionClosed>);
+    // Nothing refers to the arena once all replies are written and no command waits for its body, but parser
+    // that could be in the middle of the next command
+    if (pconn->runningTasks == 0 && pconn->cmd == nullptr) {
+        pconn->parser.Rebase(pconn->scratch);
     }
+}
 
-    delete[] task->result.base;
-    delete task;
+// See Worker.h
+void Worker::OnTaskClosed(uv_handle_t *handle) {
+    std::cout << "network debug:" << __PRETTY_FUNCTION__ << std::endl;
+    delete reinterpret_cast<TaskSignal *>(handle)->task;
+    CloseEventLoppIfPossible();
 }
 
 } // namespace UV
@@ -1,14 +1,22 @@
 #ifndef AFINA_NETWORK_UV_WORKER_H
 #define AFINA_NETWORK_UV_WORKER_H
 
+#include <atomic>
+#include <deque>
+#include <memory>
 #include <string>
 #include <unordered_set>
 #include <uv.h>
 #include <vector>
 
+#include <afina/allocator/Bump.h>
+#include <afina/allocator/Resource.h>
+#include <afina/allocator/Slab.h>
 #include <afina/execute/Command.h>
 #include <protocol/Parser.h>
 
+#include "SPSCQueue.h"
+
 namespace Afina {
 class Storage;
 namespace Execute {
@@ -17,6 +25,24 @@ class Command;
 namespace Network {
 namespace UV {
 
+class Worker;
+
+/**
+ * # State shared by workers in the shared-nothing mode
+ * Each worker owns a private storage partition, keys are distributed over partitions by hash. Command
+ * for a key owned by another worker is forwarded to the owner over lock-free queue, owner executes it
+ * and signals back to the origin event loop
+ */
+struct Partitions {
+    Partitions() : finished(0) {}
+
+    // Workers owning partitions, position in the vector is a partition number
+    std::vector<Worker *> workers;
+
+    // Number of workers whose event loop is already finished
+    std::atomic<size_t> finished;
+};
+
 /**
  * # Basic network data processor
  * Reads and writes byte streams from/to clients, parse protocol and submit commands to the execution. Implements
@@ -24,12 +50,19 @@ namespace UV {
  */
 class Worker {
 public:
-    Worker(std::shared_ptr<Afina::Storage> pStorage) : pStorage(pStorage) {}
+    Worker(std::shared_ptr<Afina::Storage> pStorage)
+        : pStorage(pStorage), partitions(nullptr), partitionIndex(0), inboxReady(false) {}
     ~Worker() {}
 
     Worker(const Worker &) = delete;
     Worker &operator=(const Worker &) = delete;
 
+    /**
+     * Switch worker to the shared-nothing mode, storage given in constructor is considered as a
+     * partition with the given index. Must be called for all workers before any of them started
+     */
+    void SetPartitions(Partitions *partitions, size_t index);
+
     void Start(const struct sockaddr_storage &addr);
 
     /**
@@ -75,10 +108,20 @@ protected:
         sClosed
     };
 
+    struct ExecuteTask;
+
+    typedef std::deque<ExecuteTask *, Allocator::StlAllocator<ExecuteTask *>> Replies;
+
+    /**
+     * Accounted slab pool of containers that grow per command: reply queues of connections and parts
+     * of tasks, shown as "uv" in "stats pools"
+     */
+    static Allocator::Resource &ContainerPool();
+
     /**
-     * Holds information about single connection from the client
+     * Holds information about single connection from the client, taken from the slab pool
      */
-    typedef struct Connection {
+    typedef struct Connection : Allocator::SlabAllocated<Connection> {
         // Extend UV stream handler to use Connection instance inside
         // libuv lib
         uv_stream_t handler;
@@ -95,7 +138,11 @@ protected:
         // How many bytes from input has been parsed already
         size_t input_parsed;
 
-        // State of the header parser
+        // Arena of the requests in flight: parsed keys, get key lists and response buffers. Reset once all
+        // replies are written, so a pipelined batch of requests shares the same chunks
+        Allocator::Bump scratch;
+
+        // State of the header parser, command being parsed is kept in the arena
         Protocol::Parser parser;
 
         // Command parsed out from the input
@@ -110,40 +157,101 @@ protected:
         // Number of tasks that are running now
         size_t runningTasks;
 
+        // Tasks in the order commands were received. Parts of tasks could be executed by other
+        // partitions and complete out of order, but responses must be written in order
+        Replies replies;
+
         Connection()
-            : state(ConnectionState::sRecvHeader), input(nullptr), input_used(0), input_parsed(0), cmd(nullptr),
-              body_size(0), body(""), runningTasks(0) {
-            input = new char[ConnectionInputBufferSize];
+            : state(ConnectionState::sRecvHeader), input(nullptr), input_used(0), input_parsed(0),
+              scratch("uv.scratch"), parser(scratch), cmd(nullptr), body_size(0), body(""), runningTasks(0),
+              replies(Replies::allocator_type(ContainerPool())) {
+            input = Allocator::AllocBuffer(ConnectionInputBufferSize);
             parser.Reset();
         }
 
-        ~Connection() { delete[] input; }
+        ~Connection() { Allocator::FreeBuffer(input, ConnectionInputBufferSize); }
     } Connection;
 
+    /**
+     * Piece of the command that could be executed on a single partition. Usually command has the only
+     * part, but multi-key get could be splitted between many partitions
+     */
+    typedef struct ExecutePart {
+        // Command to execute
+        std::unique_ptr<Execute::Command> cmd;
+
+        // Execution result of the part
+        std::string output;
+
+        // Partition executing the part, used in partitioned mode only
+        size_t owner;
+    } ExecutePart;
+
+    typedef std::vector<ExecutePart, Allocator::StlAllocator<ExecutePart>> ExecuteParts;
+
+    typedef std::vector<size_t, Allocator::StlAllocator<size_t>> KeyParts;
+
+    /**
+     * Async signal of the task. Handle data points to the worker, so the task is kept next to the handle
+     */
+    typedef struct TaskSignal {
+        uv_async_t handle;
+        ExecuteTask *task;
+    } TaskSignal;
+
     /**
      * Work passed to the worker thread pool and back in order to execute
-     * some command
+     * some command. Tasks are created for every command, so they are taken from the slab pool
      */
-    typedef struct ExecuteTask {
+    typedef struct ExecuteTask : Allocator::SlabAllocated<ExecuteTask> {
         // Write handler, used to send this task through the libuv write pipeline
         uv_write_t handler;
 
         // Async signal to be called once task execution is complete
-        uv_async_t done;
+        TaskSignal done;
 
         // Connection that received command, used to write out response
         Connection *connection;
 
-        // Command to execute
-        std::unique_ptr<Execute::Command> cmd;
+        // Parts of the command to execute
+        ExecuteParts parts = ExecuteParts(ExecuteParts::allocator_type(ContainerPool()));
+
+        // Part of each key of multi-key get splitted between partitions, in the order keys were requested. Items
+        // replied by the parts are merged back in that order
+        KeyParts order = KeyParts(KeyParts::allocator_type(ContainerPool()));
+
+        // Each part is the same command sent to every partition, so their outputs are not joined. Stats of
+        // the partitions are merged instead
+        bool broadcast;
+
+        // Client asked for no reply, task is executed but nothing is written
+        bool noreply;
+
+        // Result is ready to be written once all previous replies of the connection are written
+        bool ready;
+
+        // Number of parts that are not executed yet, the one who executes last part
+        // completes the task
+        std::atomic<size_t> pending;
 
         // Argument for the command
         std::string argument;
 
-        // Execution result
+        // Execution result, buffer is taken from the connection arena
         uv_buf_t result;
     } ExecuteTask;
 
+    /**
+     * Part of the task forwarded to the partition owner
+     */
+    typedef struct PartitionJob {
+        ExecuteTask *task;
+        size_t part;
+    } PartitionJob;
+
+    // Size of the each inbox queue
+    const static size_t InboxSize = 4096;
+
     /**
      * Called by thread once started, while this method is running Worker considered as alive
      */
@@ -193,6 +301,59 @@ protected:
      */
     void Execute(Connection &pconn);
 
+    /**
+     * Replies with the given output without executing anything, in order with replies to the previous commands
+     */
+    void Reply(Connection &pconn, std::string output);
+
+    /**
+     * Splits command onto task parts, each part touches keys from the single partition only. Multi-key get
+     * gets one part per partition owning any of its keys. Commands affecting whole storage, like flush_all
+     * or stats keyspace, are broadcasted to all partitions
+     */
+    void Split(std::unique_ptr<Execute::Command> cmd, ExecuteTask &task) const;
+
+    /**
+     * Returns index of the partition that owns given key/command
+     */
+    size_t OwnerOf(const char *key, size_t size) const;
+    size_t OwnerOf(const std::string &key) const { return OwnerOf(key.data(), key.size()); }
+    size_t OwnerOf(const Allocator::String &key) const { return OwnerOf(key.data(), key.size()); }
+    size_t OwnerOf(const Execute::Command &cmd) const;
+
+    /**
+     * Executes part of the task on the local storage. Once all parts are executed task gets completed. Could be
+     * called in the worker thread only
+     */
+    void RunPart(const PartitionJob &job);
+
+    /**
+     * Notifies event loop of the connection that task is executed. Could be called from any thread
+     */
+    void Complete(ExecuteTask *task);
+
+    /**
+     * Joins outputs of the task parts into the result buffer taken from the connection arena, items of splitted
+     * get are replied in the order keys were requested. Could be called in the connection event loop only
+     */
+    void BuildResult(ExecuteTask &task);
+
+    /**
+     * Sends part of the task to the partition owner
+     */
+    void Forward(size_t owner, const PartitionJob &job);
+
+    /**
+     * Let event loop know that there are jobs in the inbox. Could be called from any thread
+     */
+    void WakeUp();
+
+    /**
+     * Executes all jobs forwarded to this worker
+     */
+    void OnInbox(uv_async_t *);
+    void DrainInbox();
+
     /**
      * Called once command execution is complete
      */
@@ -203,6 +364,17 @@ protected:
      */
     void OnWriteDone(uv_write_t *req, int status);
 
+    /**
+     * Accounts reply as written or dropped, closes connection once it is closed by peer and has no more
+     * replies, then closes task async handle. Task keeps nothing of the connection after that
+     */
+    void FinishReply(ExecuteTask *task);
+
+    /**
+     * Called by libuv once task async handle is closed, releases the task
+     */
+    void OnTaskClosed(uv_handle_t *handle);
+
 private:
     // // State of worker, could transit only in one direction from left to right
     // enum class WorkerState : uint8_t { kInit, kRun, kStopping, kStopped };
@@ -249,6 +421,32 @@ private:
      * Storage instance to execute commands on
      */
     std::shared_ptr<Afina::Storage> pStorage;
+
+    /**
+     * Shared-nothing mode state, nullptr in case if storage is shared between all workers
+     */
+    Partitions *partitions;
+
+    /**
+     * Number of partition owned by this worker
+     */
+    size_t partitionIndex;
+
+    /**
+     * Jobs forwarded from other workers, queue i is written by worker i only
+     */
+    std::vector<std::unique_ptr<SPSCQueue<PartitionJob>>> inbox;
+
+    /**
+     * Async used by peers to wake up event loop once new jobs are placed into inbox. Doesn't hold
+     * event loop from termination
+     */
+    uv_async_t uvInboxAsync;
+
+    /**
+     * Set once worker thread is ready to process inbox, before that peers just enqueue jobs
+     */
+    std::atomic<bool> inboxReady;
 };
 
 } // namespace UV
@@ -1,15 +1,25 @@
 #include "Parser.h"
 
+#include <cstdint>
+#include <cstdlib>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
 
+#include <afina/allocator/Bump.h>
+#include <afina/allocator/Resource.h>
 #include <afina/execute/Add.h>
 #include <afina/execute/Append.h>
 #include <afina/execute/Command.h>
 #include <afina/execute/Delete.h>
+#include <afina/execute/FlushAll.h>
 #include <afina/execute/Get.h>
+#include <afina/execute/Invalidate.h>
+#include <afina/execute/LeaseGet.h>
+#include <afina/execute/LeaseSet.h>
+#include <afina/execute/Load.h>
 #include <afina/execute/Set.h>
+#include <afina/execute/StaticCommand.h>
 #include <afina/execute/Stats.h>
 
 namespace Afina {
@@ -27,17 +37,27 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
         case State::sName: {
             if (c == ' ' || c == '\r' || c == '\n') {
                 // std::cout << "parser debug: name='" << name << "'" << std::endl;
-                if (name == "set" || name == "add" || name == "append" || name == "prepend") {
+                if (name == "set" || name == "add" || name == "append" || name == "prepend" || name == "lset") {
                     state = State::spKey;
                 } else if (name == "get" || name == "gets") {
                     state = State::sgKey;
-                } else if (name == "stats") {
-                    state = State::sLF;
-                    continue;
+                } else if (name == "delete" || name == "load" || name == "lget" || name == "invalidate") {
+                    if (c != ' ') {
+                        throw std::runtime_error("Client provides no argument for " + std::string(name.data(), name.size()));
+                    }
+                    state = State::sgKey;
+                } else if (name == "stats" || name == "flush_all") {
+                    // Optional statistics group or flush delay follows
+                    if (c == ' ') {
+                        state = State::sgKey;
+                    } else {
+                        state = State::sLF;
+                        continue;
+                    }
                 } else if (name == "") {
                     continue;
                 } else {
-                    throw std::runtime_error("Unknown command name" + name);
+                    throw std::runtime_error("Unknown command name" + std::string(name.data(), name.size()));
                 }
             } else {
                 name.push_back(c);
@@ -48,7 +68,8 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
         case State::spKey: {
             if (c == ' ') {
                 state = State::spFlags;
-                keys.push_back(curKey);
+                keys.push_back(std::move(curKey));
+                curKey.clear();
                 // std::cout << "parser debug: key[" << keys.size() - 1 << "]='" << curKey << "'" << std::endl;
             } else {
                 curKey.push_back(c);
@@ -58,19 +79,26 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
 
         case State::sgKey: {
             if (c == '\r') {
-                keys.push_back(curKey);
+                keys.push_back(std::move(curKey));
                 // std::cout << "parser debug: total '" << keys.size() << " keys" << std::endl;
 
                 if (keys.size() == 0) {
                     throw std::runtime_error("Client provides no key to retrive");
                 }
 
+                // delete <key> noreply, flush_all [delay] noreply
+                size_t args = name == "delete" ? 1 : name == "flush_all" ? 0 : keys.size();
+                if (keys.size() > args && keys.back() == "noreply") {
+                    keys.pop_back();
+                    noreply = true;
+                }
+
                 curKey.clear();
                 state = State::sLF;
             } else if (c == ' ') {
                 // std::cout << "parser debug: key[" << keys.size() << "]='" << curKey << "'" << std::endl;
                 state = State::sgKey;
-                keys.push_back(curKey);
+                keys.push_back(std::move(curKey));
                 curKey.clear();
             } else {
                 curKey.push_back(c);
@@ -132,6 +160,8 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
             if (c == '\r') {
                 state = State::sLF;
                 // std::cout << "parser debug: bytes='" << bytes << "'" << std::endl;
+            } else if (c == ' ') {
+                state = State::spToken;
             } else if (c >= '0' && c <= '9') {
                 uint32_t b = (bytes * 10) + (c - '0');
                 if (b < bytes) {
@@ -143,6 +173,20 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
             break;
         }
 
+        case State::spToken: {
+            if (c == '\r') {
+                state = State::sLF;
+            } else if (c >= '0' && c <= '9') {
+                uint64_t t = (token * 10) + (c - '0');
+                if (t < token) {
+                    // Overflow
+                    throw std::runtime_error("Token field overflow");
+                }
+                token = t;
+            }
+            break;
+        }
+
         case State::sLF: {
             if (c == '\n') {
                 parse_complete = true;
@@ -164,37 +208,136 @@ bool Parser::Parse(const char *input, const size_t size, size_t &parsed) {
 }
 
 // See Parse.h
-std::unique_ptr<Execute::Command> Parser::Build(uint32_t &body_size) const {
+std::unique_ptr<Execute::Command> Parser::Build(uint32_t &body_size) {
     if (state != State::sLF) {
         return std::unique_ptr<Execute::Command>(nullptr);
     }
 
     body_size = bytes;
+    if (name == "get") {
+        return std::unique_ptr<Execute::Command>(new Execute::Get(std::move(keys)));
+    }
+
+    // Other commands keep their arguments for longer than the request
+    std::vector<std::string> args;
+    for (auto &key : keys) {
+        args.emplace_back(key.data(), key.size());
+    }
+
     if (name == "set") {
-        return std::unique_ptr<Execute::Command>(new Execute::Set(keys[0], flags, exprtime));
+        return std::unique_ptr<Execute::Command>(new Execute::Set(args[0], flags, exprtime));
     } else if (name == "add") {
-        return std::unique_ptr<Execute::Command>(new Execute::Add(keys[0], flags, exprtime));
+        return std::unique_ptr<Execute::Command>(new Execute::Add(args[0], flags, exprtime));
     } else if (name == "append") {
-        return std::unique_ptr<Execute::Command>(new Execute::Append(keys[0], flags, exprtime));
-    } else if (name == "get") {
-        return std::unique_ptr<Execute::Command>(new Execute::Get(keys));
+        return std::unique_ptr<Execute::Command>(new Execute::Append(args[0], flags, exprtime));
+    } else if (name == "delete") {
+        if (args.size() != 1 || args[0].empty()) {
+            throw std::runtime_error("Delete expects exactly one key");
+        }
+        return std::unique_ptr<Execute::Command>(new Execute::Delete(args[0]));
+    } else if (name == "lget" || name == "invalidate") {
+        if (args.size() != 1 || args[0].empty()) {
+            throw std::runtime_error("Command expects exactly one key");
+        }
+        if (name == "lget") {
+            return std::unique_ptr<Execute::Command>(new Execute::LeaseGet(args[0]));
+        }
+        return std::unique_ptr<Execute::Command>(new Execute::Invalidate(args[0]));
+    } else if (name == "lset") {
+        return std::unique_ptr<Execute::Command>(new Execute::LeaseSet(args[0], flags, exprtime, token));
     } else if (name == "stats") {
-        return std::unique_ptr<Execute::Command>(new Execute::Stats());
+        return std::unique_ptr<Execute::Command>(new Execute::Stats(args.empty() ? "" : args[0]));
+    } else if (name == "flush_all") {
+        uint32_t delay = 0;
+        if (!args.empty()) {
+            char *end;
+            unsigned long value = std::strtoul(args[0].c_str(), &end, 10);
+            if (args.size() != 1 || args[0].empty() || *end != '\0' || value > UINT32_MAX) {
+                throw std::runtime_error("Invalid flush delay");
+            }
+            delay = value;
+        }
+        return std::unique_ptr<Execute::Command>(new Execute::FlushAll(delay));
+    } else if (name == "load") {
+        if (args.size() != 1 || args[0].empty()) {
+            throw std::runtime_error("Load expects exactly one dump path");
+        }
+        return std::unique_ptr<Execute::Command>(new Execute::Load(args[0]));
     } else {
         throw std::runtime_error("Unsupported command");
     }
 }
 
+// See Parse.h
+bool Parser::Build(Execute::StaticCommand &cmd, uint32_t &body_size) {
+    if (state != State::sLF) {
+        return false;
+    }
+
+    typedef Execute::StaticCommand::Kind Kind;
+    cmd.Reset();
+    if (name == "get") {
+        cmd.kind = Kind::Get;
+    } else if (name == "set") {
+        cmd.kind = Kind::Set;
+    } else if (name == "add") {
+        cmd.kind = Kind::Add;
+    } else if (name == "append") {
+        cmd.kind = Kind::Append;
+    } else if (name == "delete") {
+        if (keys.size() != 1 || keys[0].empty()) {
+            throw std::runtime_error("Delete expects exactly one key");
+        }
+        cmd.kind = Kind::Delete;
+    } else {
+        cmd.dynamic = Build(body_size);
+        cmd.kind = Kind::Dynamic;
+        return true;
+    }
+
+    // Strings of the command keep their capacity for the whole connection
+    body_size = bytes;
+    cmd.keys.resize(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        cmd.keys[i].assign(keys[i].data(), keys[i].size());
+    }
+    return true;
+}
+
 // See Parse.h
 void Parser::Reset() {
     state = State::sName;
-    name.clear();
-    keys.clear();
-    curKey.clear();
+    Allocator::String(name.get_allocator()).swap(name);
+    Allocator::Vector<Allocator::String>(keys.get_allocator()).swap(keys);
+    Allocator::String(curKey.get_allocator()).swap(curKey);
     parse_complete = false;
+    noreply = false;
     flags = 0;
     bytes = 0;
     exprtime = 0;
+    token = 0;
+}
+
+// See Parse.h
+void Parser::Rebase(Allocator::Bump &arena) {
+    // Command is rarely split between reads, so part of it is just copied aside
+    std::string saved_name(name.data(), name.size());
+    std::string saved_key(curKey.data(), curKey.size());
+    std::vector<std::string> saved_keys;
+    for (auto &key : keys) {
+        saved_keys.emplace_back(key.data(), key.size());
+    }
+
+    Allocator::String(name.get_allocator()).swap(name);
+    Allocator::Vector<Allocator::String>(keys.get_allocator()).swap(keys);
+    Allocator::String(curKey.get_allocator()).swap(curKey);
+    arena.reset();
+
+    name.assign(saved_name.data(), saved_name.size());
+    curKey.assign(saved_key.data(), saved_key.size());
+    for (auto &key : saved_keys) {
+        keys.emplace_back(key.data(), key.size(), curKey.get_allocator());
+    }
 }
 
 } // namespace Protocol
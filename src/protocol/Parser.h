@@ -8,19 +8,33 @@
 #include <cstddef>
 #include <cstdint>
 
+#include <afina/allocator/Resource.h>
+
 namespace Afina {
+namespace Allocator {
+class Bump;
+} // namespace Allocator
 namespace Execute {
 class Command;
+class StaticCommand;
 } // namespace Execute
 namespace Protocol {
 
 /**
  * # Memcached protocol parser
  * Parser supports subset of memcached protocol
+ *
+ * Name and keys of the command are kept in the given resource, usually the arena of the connection, and keys
+ * are moved into the built command, so parsing a request takes nothing from the heap
  */
 class Parser {
 public:
-    Parser() { Reset(); }
+    Parser(Allocator::Resource &resource = Allocator::DefaultResource())
+        : name(Allocator::StlAllocator<char>(resource)), keys(Allocator::StlAllocator<Allocator::String>(resource)),
+          curKey(Allocator::StlAllocator<char>(resource)) {
+        Reset();
+    }
+
     /**
      * Push given string into parser input. Method returns true if it was a command parsed out
      * from comulative input. In a such case method Build will return new command
@@ -44,16 +58,36 @@ public:
 
     /**
      * Builds new command from parsed input. In case if it wasn't enough input to prse command out
-     * method return nullptr
+     * method return nullptr. Key list of get is moved into the command, so it lives in the parser resource
+     */
+    std::unique_ptr<Execute::Command> Build(uint32_t &body_size);
+
+    /**
+     * Same as above, but fills command variant of the compile time composed pipeline. Hot commands are built
+     * inline, parsed keys are copied into strings of the variant that keep their capacity. Returns false if it wasn't enough input to parse command
+     * out
      */
-    std::unique_ptr<Execute::Command> Build(uint32_t &body_size) const;
+    bool Build(Execute::StaticCommand &cmd, uint32_t &body_size);
 
     /**
-     * Reset parse so that it could be used to parse out new command
+     * Reset parse so that it could be used to parse out new command. Memory of the previous command is
+     * released, so resource could be reset once commands built are gone
      */
     void Reset();
 
-    inline const std::string &Name() const { return name; }
+    /**
+     * Resets the arena used as the parser resource. Parser could be in the middle of the next command at that
+     * moment, the part parsed so far is carried over into the fresh arena
+     */
+    void Rebase(Allocator::Bump &arena);
+
+    inline const Allocator::String &Name() const { return name; }
+
+    /**
+     * True if client asked not to reply to the parsed command by the trailing noreply, server must execute
+     * command and drop its output
+     */
+    inline bool NoReply() const { return noreply; }
 
 private:
     /**
@@ -62,14 +96,14 @@ private:
      * - sp: for PUT commands only
      * - sg: for GET commands only
      */
-    enum State : uint16_t { sCR, sLF, sName, spKey, spFlags, spExprTimeStart, spExprTime, spBytes, sgKey };
+    enum State : uint16_t { sCR, sLF, sName, spKey, spFlags, spExprTimeStart, spExprTime, spBytes, spToken, sgKey };
 
     // Current parser state
     State state;
 
     // vrious fields of the command
-    std::string name;
-    std::vector<std::string> keys;
+    Allocator::String name;
+    Allocator::Vector<Allocator::String> keys;
 
     // <flags> is an arbitrary 16-bit unsigned integer (written out in decimal) that the server stores along with
     // the data and sends back when the item is retrieved. Clients may use this as a bit field to store data-specific
@@ -88,8 +122,12 @@ private:
     // it's followed by an empty data block).
     uint32_t bytes;
 
+    // <token> is lease token of lset command
+    uint64_t token;
+
     bool negative;
-    std::string curKey;
+    bool noreply;
+    Allocator::String curKey;
     bool parse_complete;
 };
 
@@ -0,0 +1,209 @@
+#include "ARCPolicy.h"
+
+#include <algorithm>
+
+namespace Afina {
+namespace Backend {
+
+// See ARCPolicy.h
+void ARCPolicy::Ghosts::Add(bool frequent, size_t hash, size_t size) {
+    bool was;
+    Take(hash, was);
+    if (2 * (_live + 1) > _table.size()) {
+        Grow();
+    }
+
+    hash = hash == 0 ? 1 : hash;
+    Ghost &ghost = _table[Find(hash)];
+    ghost = {hash, ++_seq, size, frequent};
+    _live++;
+
+    _queue[frequent].emplace_back(hash, ghost.seq);
+    _size[frequent] += size;
+    _count[frequent]++;
+    if (_queue[frequent].size() > 2 * _count[frequent] + 64) {
+        Compact(frequent);
+    }
+}
+
+// See ARCPolicy.h
+bool ARCPolicy::Ghosts::Take(size_t hash, bool &frequent) {
+    if (_live == 0) {
+        return false;
+    }
+
+    size_t slot = Find(hash == 0 ? 1 : hash);
+    if (_table[slot].hash == 0) {
+        return false;
+    }
+
+    frequent = _table[slot].frequent;
+    Erase(slot);
+    return true;
+}
+
+// See ARCPolicy.h
+void ARCPolicy::Ghosts::Pop(bool frequent) {
+    std::deque<std::pair<size_t, uint64_t>> &queue = _queue[frequent];
+    while (!queue.empty()) {
+        size_t slot = Find(queue.front().first);
+        bool live = _table[slot].hash != 0 && _table[slot].seq == queue.front().second;
+        queue.pop_front();
+        if (live) {
+            Erase(slot);
+            return;
+        }
+    }
+}
+
+// See ARCPolicy.h
+size_t ARCPolicy::Ghosts::Find(size_t hash) const {
+    size_t mask = _table.size() - 1;
+    size_t slot = hash & mask;
+    while (_table[slot].hash != 0 && _table[slot].hash != hash) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+// See ARCPolicy.h
+void ARCPolicy::Ghosts::Erase(size_t slot) {
+    bool frequent = _table[slot].frequent;
+    _size[frequent] -= _table[slot].size;
+    _count[frequent]--;
+    _live--;
+
+    // Backward shift: move up every following ghost whose home slot is not between hole and itself
+    size_t mask = _table.size() - 1;
+    size_t hole = slot;
+    for (size_t next = (hole + 1) & mask; _table[next].hash != 0; next = (next + 1) & mask) {
+        size_t home = _table[next].hash & mask;
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            _table[hole] = _table[next];
+            hole = next;
+        }
+    }
+    _table[hole].hash = 0;
+}
+
+// See ARCPolicy.h
+void ARCPolicy::Ghosts::Grow() {
+    std::vector<Ghost> old(std::max<size_t>(64, 2 * _table.size()));
+    old.swap(_table);
+    for (auto &ghost : old) {
+        if (ghost.hash != 0) {
+            _table[Find(ghost.hash)] = ghost;
+        }
+    }
+}
+
+// See ARCPolicy.h
+void ARCPolicy::Ghosts::Compact(bool frequent) {
+    std::deque<std::pair<size_t, uint64_t>> live;
+    for (auto &item : _queue[frequent]) {
+        const Ghost &ghost = _table[Find(item.first)];
+        if (ghost.hash != 0 && ghost.seq == item.second) {
+            live.push_back(item);
+        }
+    }
+    _queue[frequent].swap(live);
+}
+
+// See ARCPolicy.h
+void ARCPolicy::Insert(Entry *entry) {
+    size_t size = SizeOf(entry);
+    size_t b1 = _ghosts.Size(false), b2 = _ghosts.Size(true);
+
+    // Miss on recently evicted key tells which list should have been larger
+    bool frequent;
+    entry->frequent = _ghosts.Take(entry->hash, frequent);
+    if (entry->frequent && !frequent) {
+        size_t delta = b1 >= b2 ? size : size * (b2 / b1);
+        _target = std::min(_capacity, _target + delta);
+    } else if (entry->frequent) {
+        size_t delta = b2 >= b1 ? size : size * (b1 / b2);
+        _target = _target > delta ? _target - delta : 0;
+    }
+
+    if (entry->frequent) {
+        _t2.AddNode(entry);
+        _t2_size += size;
+    } else {
+        _t1.AddNode(entry);
+        _t1_size += size;
+    }
+    TrimGhosts();
+}
+
+// See ARCPolicy.h
+void ARCPolicy::Touch(Entry *entry) {
+    if (entry->frequent) {
+        _t2.MakeTop(entry);
+        return;
+    }
+
+    size_t size = SizeOf(entry);
+    _t1.Unlink(entry);
+    _t1_size -= size;
+    entry->frequent = true;
+    _t2.AddNode(entry);
+    _t2_size += size;
+}
+
+// See ARCPolicy.h
+void ARCPolicy::Update(Entry *entry, size_t old_size) {
+    size_t &list_size = entry->frequent ? _t2_size : _t1_size;
+    list_size = list_size - old_size + SizeOf(entry);
+    Touch(entry);
+}
+
+// See ARCPolicy.h
+void ARCPolicy::Remove(Entry *entry, bool evicted) {
+    size_t size = SizeOf(entry);
+    if (entry->frequent) {
+        _t2_size -= size;
+        if (evicted) {
+            _ghosts.Add(true, entry->hash, size);
+        }
+        _t2.DeleteNode(entry);
+    } else {
+        _t1_size -= size;
+        if (evicted) {
+            _ghosts.Add(false, entry->hash, size);
+        }
+        _t1.DeleteNode(entry);
+    }
+    TrimGhosts();
+}
+
+// See ARCPolicy.h
+Entry *ARCPolicy::Victim() const {
+    Entry *t1 = _t1.GetTail();
+    Entry *t2 = _t2.GetTail();
+    if (t1 != nullptr && (_t1_size > _target || t2 == nullptr)) {
+        return t1;
+    }
+    return t2;
+}
+
+// See ARCPolicy.h
+void ARCPolicy::TrimGhosts() {
+    while (_ghosts.Size(false) != 0 && _t1_size + _ghosts.Size(false) > _capacity) {
+        _ghosts.Pop(false);
+    }
+    while (_ghosts.Size(true) != 0 && _t1_size + _t2_size + _ghosts.Size(false) + _ghosts.Size(true) > 2 * _capacity) {
+        _ghosts.Pop(true);
+    }
+}
+
+// See ARCPolicy.h
+void ARCPolicy::GetStats(Storage::StatsList &stats) const {
+    stats.emplace_back("arc_target", std::to_string(_target));
+    stats.emplace_back("arc_t1_bytes", std::to_string(_t1_size));
+    stats.emplace_back("arc_t2_bytes", std::to_string(_t2_size));
+    stats.emplace_back("arc_b1_bytes", std::to_string(_ghosts.Size(false)));
+    stats.emplace_back("arc_b2_bytes", std::to_string(_ghosts.Size(true)));
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,122 @@
+#ifndef AFINA_STORAGE_ARC_POLICY_H
+#define AFINA_STORAGE_ARC_POLICY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "EvictionPolicy.h"
+#include "LRUList.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Adaptive replacement cache
+ * See Megiddo, Modha "ARC: A Self-Tuning, Low Overhead Replacement Cache". Entries seen once live in
+ * T1, entries accessed again are moved to T2, both lists are ordered by recency. Hashes of entries
+ * evicted from T1 and T2 are kept in ghost lists B1 and B2.
+ *
+ * Target size of T1 adapts: insertion of a key found in B1 means T1 was too small and grows the target,
+ * key found in B2 shrinks it. Victim is taken from T1 while it is above the target. So the policy
+ * behaves like LRU for recency heavy load and protects frequently used entries from scans.
+ *
+ * All sizes are in bytes rather than in entries, ghost lists hold up to capacity bytes together with
+ * the live lists, as in the original algorithm
+ */
+class ARCPolicy : public EvictionPolicy {
+public:
+    ARCPolicy(size_t capacity) : _capacity(capacity), _target(0), _t1_size(0), _t2_size(0) {}
+
+    // Implements EvictionPolicy interface
+    void Insert(Entry *entry) override;
+
+    // Implements EvictionPolicy interface
+    void Touch(Entry *entry) override;
+
+    // Implements EvictionPolicy interface
+    void Update(Entry *entry, size_t old_size) override;
+
+    // Implements EvictionPolicy interface
+    void Remove(Entry *entry, bool evicted) override;
+
+    // Implements EvictionPolicy interface
+    Entry *Victim() const override;
+
+    // Implements EvictionPolicy interface
+    void GetStats(Storage::StatsList &stats) const override;
+
+private:
+    // Hashes of entries evicted from T1 and T2 (B1 and B2), in eviction order. Both lists share
+    // a single open addressing table, so insertion costs one lookup and no allocation in steady state
+    class Ghosts {
+    public:
+        Ghosts() : _live(0), _seq(0) {
+            _size[0] = _size[1] = 0;
+            _count[0] = _count[1] = 0;
+        }
+
+        void Add(bool frequent, size_t hash, size_t size);
+
+        // Removes ghost, returns false if there is no such. Otherwise tells which list it was in
+        bool Take(size_t hash, bool &frequent);
+
+        // Drops the oldest ghost of the list, list must not be empty
+        void Pop(bool frequent);
+
+        size_t Size(bool frequent) const { return _size[frequent]; }
+
+    private:
+        // Slot is empty if hash is 0, zero hashes of entries are stored as 1
+        struct Ghost {
+            size_t hash;
+            uint64_t seq;
+            size_t size;
+            bool frequent;
+        };
+
+        // Returns slot holding the hash or the empty slot where it should be inserted
+        size_t Find(size_t hash) const;
+
+        // Removes ghost from the slot, shifting following slots of the probe sequence back
+        void Erase(size_t slot);
+
+        // Doubles the table
+        void Grow();
+
+        // Drops taken ghosts from the queue once they outnumber live ones
+        void Compact(bool frequent);
+
+        // Queues of hash and seq, taken ghosts are left until popped or compacted
+        std::deque<std::pair<size_t, uint64_t>> _queue[2];
+
+        // Linear probing table, size is a power of two and at most half full
+        std::vector<Ghost> _table;
+        size_t _live;
+
+        size_t _size[2];
+        size_t _count[2];
+        uint64_t _seq;
+    };
+
+    static size_t SizeOf(const Entry *entry) { return entry->key.size() + entry->value.size(); }
+
+    // Keeps ghost lists within capacity
+    void TrimGhosts();
+
+    const size_t _capacity;
+
+    // Target size of T1
+    size_t _target;
+
+    LRUList _t1, _t2;
+    size_t _t1_size, _t2_size;
+    Ghosts _ghosts;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_ARC_POLICY_H
@@ -0,0 +1,136 @@
+#include "Dump.h"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+const char Magic[] = "AFNDUMP1";
+const size_t MagicSize = sizeof(Magic) - 1;
+
+// key length, flags, exptime, value length
+const size_t HeaderSize = 4 * sizeof(uint32_t);
+
+} // namespace
+
+// See Dump.h
+DumpWriter::DumpWriter(const std::string &path) {
+    _file = std::fopen(path.c_str(), "wb");
+    if (_file == nullptr) {
+        throw std::runtime_error("Failed to create dump " + path + ": " + std::strerror(errno));
+    }
+    if (std::fwrite(Magic, MagicSize, 1, _file) != 1) {
+        std::fclose(_file);
+        throw std::runtime_error("Failed to write dump " + path);
+    }
+}
+
+// See Dump.h
+DumpWriter::~DumpWriter() {
+    if (_file != nullptr) {
+        std::fclose(_file);
+    }
+}
+
+// See Dump.h
+void DumpWriter::Write(const std::string &key, uint32_t flags, int32_t exptime, const std::string &value) {
+    uint32_t header[4] = {uint32_t(key.size()), flags, uint32_t(exptime), uint32_t(value.size())};
+    if (std::fwrite(header, sizeof(header), 1, _file) != 1 ||
+        std::fwrite(key.data(), 1, key.size(), _file) != key.size() ||
+        std::fwrite(value.data(), 1, value.size(), _file) != value.size()) {
+        throw std::runtime_error("Failed to write dump record");
+    }
+}
+
+// See Dump.h
+void DumpWriter::Close() {
+    int rc = std::fclose(_file);
+    _file = nullptr;
+    if (rc != 0) {
+        throw std::runtime_error("Failed to close dump");
+    }
+}
+
+// See Dump.h
+DumpReader::DumpReader(const std::string &path) : _data(nullptr), _size(0) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open dump " + path + ": " + std::strerror(errno));
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error("Failed to stat dump " + path);
+    }
+    _size = st.st_size;
+    if (_size < MagicSize) {
+        close(fd);
+        throw std::runtime_error("File " + path + " isn't a dump");
+    }
+
+    void *data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        throw std::runtime_error("Failed to map dump " + path + ": " + std::strerror(errno));
+    }
+    _data = static_cast<const char *>(data);
+    if (std::memcmp(_data, Magic, MagicSize) != 0) {
+        munmap(data, _size);
+        throw std::runtime_error("File " + path + " isn't a dump");
+    }
+
+    // Records are read mostly sequentially
+    madvise(data, _size, MADV_WILLNEED);
+}
+
+// See Dump.h
+DumpReader::~DumpReader() { munmap(const_cast<char *>(_data), _size); }
+
+// See Dump.h
+std::vector<size_t> DumpReader::Offsets() const {
+    std::vector<size_t> offsets;
+    size_t pos = MagicSize;
+    while (pos < _size) {
+        if (_size - pos < HeaderSize) {
+            throw std::runtime_error("Dump is truncated");
+        }
+
+        DumpRecord record = Read(pos);
+        size_t length = HeaderSize + size_t(record.key_len) + record.value_len;
+        if (_size - pos < length) {
+            throw std::runtime_error("Dump is truncated");
+        }
+
+        offsets.push_back(pos);
+        pos += length;
+    }
+    return offsets;
+}
+
+// See Dump.h
+DumpRecord DumpReader::Read(size_t offset) const {
+    uint32_t header[4];
+    std::memcpy(header, _data + offset, sizeof(header));
+
+    DumpRecord record;
+    record.key_len = header[0];
+    record.flags = header[1];
+    record.exptime = int32_t(header[2]);
+    record.value_len = header[3];
+    record.key = _data + offset + HeaderSize;
+    record.value = record.key + record.key_len;
+    return record;
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,85 @@
+#ifndef AFINA_STORAGE_DUMP_H
+#define AFINA_STORAGE_DUMP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Binary dump of storage items
+ * File starts with 8 bytes magic "AFNDUMP1" followed by records:
+ *
+ * [u32 key length][u32 flags][i32 exptime][u32 value length][key bytes][value bytes]
+ *
+ * Integers are in the host byte order, records are not aligned. Later records take precedence
+ * over earlier ones with the same key and are treated as more recently used
+ */
+struct DumpRecord {
+    const char *key;
+    uint32_t key_len;
+    uint32_t flags;
+    int32_t exptime;
+    const char *value;
+    uint32_t value_len;
+};
+
+/**
+ * Writes dump file record by record. All methods throw std::runtime_error on IO errors
+ */
+class DumpWriter {
+public:
+    DumpWriter(const std::string &path);
+    ~DumpWriter();
+
+    DumpWriter(const DumpWriter &) = delete;
+    DumpWriter &operator=(const DumpWriter &) = delete;
+
+    void Write(const std::string &key, uint32_t flags, int32_t exptime, const std::string &value);
+
+    /**
+     * Flushes and closes file, no writes are allowed after that
+     */
+    void Close();
+
+private:
+    FILE *_file;
+};
+
+/**
+ * Read only view of the dump file mapped into memory. Constructor throws std::runtime_error if
+ * file can't be mapped or it isn't a dump
+ */
+class DumpReader {
+public:
+    DumpReader(const std::string &path);
+    ~DumpReader();
+
+    DumpReader(const DumpReader &) = delete;
+    DumpReader &operator=(const DumpReader &) = delete;
+
+    /**
+     * Scans file sequentially and returns offsets of all records. Only headers are touched, so
+     * that is cheap comparing to reading records. Throws std::runtime_error if dump is truncated
+     */
+    std::vector<size_t> Offsets() const;
+
+    /**
+     * Returns record at the given offset, key and value point into mapped file. Could be called
+     * concurrently
+     */
+    DumpRecord Read(size_t offset) const;
+
+private:
+    const char *_data;
+    size_t _size;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_DUMP_H
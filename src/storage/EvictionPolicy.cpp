@@ -0,0 +1,21 @@
+#include "EvictionPolicy.h"
+
+#include <stdexcept>
+
+#include "ARCPolicy.h"
+
+namespace Afina {
+namespace Backend {
+
+// See EvictionPolicy.h
+std::unique_ptr<EvictionPolicy> MakeEvictionPolicy(const std::string &name, size_t capacity) {
+    if (name == "lru") {
+        return std::unique_ptr<EvictionPolicy>(new LRUPolicy());
+    } else if (name == "arc") {
+        return std::unique_ptr<EvictionPolicy>(new ARCPolicy(capacity));
+    }
+    throw std::runtime_error("Unknown eviction policy: " + name);
+}
+
+} // namespace Backend
+} // namespace Afina
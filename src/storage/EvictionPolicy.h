@@ -0,0 +1,87 @@
+#ifndef AFINA_STORAGE_EVICTION_POLICY_H
+#define AFINA_STORAGE_EVICTION_POLICY_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include <afina/Storage.h>
+#include "LRUList.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Order entries are evicted in
+ * Policy owns entries of the storage and decides which one goes away once memory is needed. Entry size
+ * is the size of its key and value. Not thread safe
+ */
+class EvictionPolicy {
+public:
+    virtual ~EvictionPolicy() {}
+
+    /**
+     * Takes ownership of the new entry
+     */
+    virtual void Insert(Entry *entry) = 0;
+
+    /**
+     * Entry has been read
+     */
+    virtual void Touch(Entry *entry) = 0;
+
+    /**
+     * Entry value has been replaced, old_size is the entry size before that
+     */
+    virtual void Update(Entry *entry, size_t old_size) = 0;
+
+    /**
+     * Releases entry, evicted is true if entry is removed to free memory rather than deleted
+     */
+    virtual void Remove(Entry *entry, bool evicted) = 0;
+
+    /**
+     * Returns entry to be evicted next, nullptr if there are no entries
+     */
+    virtual Entry *Victim() const = 0;
+
+    /**
+     * Appends policy specific statistics
+     */
+    virtual void GetStats(Storage::StatsList &stats) const {}
+};
+
+/**
+ * # Least recently used entry is evicted
+ */
+class LRUPolicy : public EvictionPolicy {
+public:
+    // Implements EvictionPolicy interface
+    void Insert(Entry *entry) override { _list.AddNode(entry); }
+
+    // Implements EvictionPolicy interface
+    void Touch(Entry *entry) override { _list.MakeTop(entry); }
+
+    // Implements EvictionPolicy interface
+    void Update(Entry *entry, size_t old_size) override { _list.MakeTop(entry); }
+
+    // Implements EvictionPolicy interface
+    void Remove(Entry *entry, bool evicted) override { _list.DeleteNode(entry); }
+
+    // Implements EvictionPolicy interface
+    Entry *Victim() const override { return _list.GetTail(); }
+
+private:
+    LRUList _list;
+};
+
+/**
+ * Creates policy by name: "lru" or "arc". Capacity is the storage max size in bytes.
+ * Throws std::runtime_error for unknown name
+ */
+std::unique_ptr<EvictionPolicy> MakeEvictionPolicy(const std::string &name, size_t capacity);
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_EVICTION_POLICY_H
@@ -0,0 +1,47 @@
+#include "GhostList.h"
+
+namespace Afina {
+namespace Backend {
+
+// See GhostList.h
+void GhostList::Add(size_t hash, size_t size) {
+    Ghost ghost = {hash, _evicted};
+    _evicted += size;
+    if (!Sampled(hash)) {
+        return;
+    }
+    _queue.push_back(ghost);
+    _offsets[hash] = ghost.offset;
+    Trim();
+}
+
+// See GhostList.h
+size_t GhostList::Take(size_t hash) {
+    if (!Sampled(hash)) {
+        return 0;
+    }
+
+    auto it = _offsets.find(hash);
+    if (it == _offsets.end()) {
+        return 0;
+    }
+
+    size_t distance = _evicted - it->second;
+    _offsets.erase(it);
+    return distance;
+}
+
+// See GhostList.h
+void GhostList::Trim() {
+    while (!_queue.empty() && _evicted - _queue.front().offset > _capacity) {
+        // Key could be taken or evicted again since then
+        auto it = _offsets.find(_queue.front().hash);
+        if (it != _offsets.end() && it->second == _queue.front().offset) {
+            _offsets.erase(it);
+        }
+        _queue.pop_front();
+    }
+}
+
+} // namespace Backend
+} // namespace Afina
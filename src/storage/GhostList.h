@@ -0,0 +1,71 @@
+#ifndef AFINA_STORAGE_GHOST_LIST_H
+#define AFINA_STORAGE_GHOST_LIST_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # History of evicted keys
+ * Remembers hashes of recently evicted entries in eviction order together with the number of bytes
+ * evicted up to each of them. For a key that misses, that allows to tell how much larger cache should
+ * have been to still hold it: the number of bytes evicted since the key itself.
+ *
+ * Only ghosts within given capacity in bytes are kept. To make it cheaper, list could remember just a
+ * sample of keys selected by hash: one of 2^sample_shift keys. Distances stay exact for the sampled keys,
+ * so number of hits found for them should be scaled by the sampling rate. Not thread safe
+ */
+class GhostList {
+public:
+    GhostList(size_t capacity, size_t sample_shift = 0)
+        : _capacity(capacity), _sample_mask((size_t(1) << sample_shift) - 1), _evicted(0) {}
+
+    /**
+     * Registers eviction of the entry with the given hash and size
+     */
+    void Add(size_t hash, size_t size);
+
+    /**
+     * Forgets key with the given hash. Returns number of bytes evicted since that key inclusive,
+     * or 0 if key is unknown or not sampled
+     */
+    size_t Take(size_t hash);
+
+    // True if key with the given hash is tracked by the list
+    bool Sampled(size_t hash) const { return ((hash >> 48) & _sample_mask) == 0; }
+
+    // Number of remembered keys
+    size_t Size() const { return _offsets.size(); }
+
+private:
+    struct Ghost {
+        size_t hash;
+
+        // Value of _evicted before key has been evicted
+        uint64_t offset;
+    };
+
+    // Drops ghosts that are further than capacity from the latest eviction
+    void Trim();
+
+    const size_t _capacity;
+    const size_t _sample_mask;
+
+    // Total number of bytes evicted
+    uint64_t _evicted;
+
+    // Ghosts in the eviction order, taken ones are left here until trimmed
+    std::deque<Ghost> _queue;
+
+    // Offset of each remembered key
+    std::unordered_map<size_t, uint64_t> _offsets;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_GHOST_LIST_H
@@ -0,0 +1,294 @@
+#include "HashIndex.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <utility>
+
+#include "HugePages.h"
+#include "KeyHash.h"
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+// Minimal number of buckets in the table
+const size_t MinBuckets = 16;
+
+// Rounds up to the power of two, table size must be power of two to use mask instead of modulo
+size_t RoundUp(size_t n) {
+    size_t size = MinBuckets;
+    while (size < n) {
+        size <<= 1;
+    }
+    return size;
+}
+
+// Reverses bits of the cursor, see HashIndex::Scan
+uint64_t ReverseBits(uint64_t v) {
+    v = ((v >> 1) & 0x5555555555555555ULL) | ((v & 0x5555555555555555ULL) << 1);
+    v = ((v >> 2) & 0x3333333333333333ULL) | ((v & 0x3333333333333333ULL) << 2);
+    v = ((v >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((v & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    v = ((v >> 8) & 0x00FF00FF00FF00FFULL) | ((v & 0x00FF00FF00FF00FFULL) << 8);
+    v = ((v >> 16) & 0x0000FFFF0000FFFFULL) | ((v & 0x0000FFFF0000FFFFULL) << 16);
+    return (v >> 32) | (v << 32);
+}
+
+} // namespace
+
+// See HashIndex.h
+HashIndex::HashIndex(size_t expected) : _migrate_pos(0), _size(0) {
+    _old.buckets = nullptr;
+    _old.mask = 0;
+    _old.huge = false;
+    Allocate(_main, RoundUp(expected));
+}
+
+// See HashIndex.h
+HashIndex::~HashIndex() {
+    Release(_main);
+    Release(_old);
+}
+
+// See HashIndex.h
+size_t HashIndex::Hash(const std::string &key) { return KeyHash(key); }
+
+// See HashIndex.h
+Entry *HashIndex::Find(const std::string &key, size_t hash) {
+    Migrate(MigrateStep);
+
+    if (_old.buckets != nullptr) {
+        for (Entry *e = _old.buckets[hash & _old.mask]; e != nullptr; e = e->hnext) {
+            if (e->hash == hash && e->key == key) {
+                return e;
+            }
+        }
+    }
+
+    for (Entry *e = _main.buckets[hash & _main.mask]; e != nullptr; e = e->hnext) {
+        if (e->hash == hash && e->key == key) {
+            return e;
+        }
+    }
+    return nullptr;
+}
+
+// See HashIndex.h
+void HashIndex::Insert(Entry *entry) {
+    assert(entry);
+    Migrate(MigrateStep);
+
+    // Load factor 1 is fine for chained table
+    if (_size + 1 > _main.mask + 1) {
+        Grow(2 * (_main.mask + 1));
+    }
+
+    Entry *&bucket = _main.buckets[entry->hash & _main.mask];
+    entry->hnext = bucket;
+    bucket = entry;
+    _size++;
+}
+
+// See HashIndex.h
+void HashIndex::Remove(Entry *entry) {
+    assert(entry);
+    Migrate(MigrateStep);
+
+    Table *tables[] = {&_old, &_main};
+    for (Table *table : tables) {
+        if (table->buckets == nullptr) {
+            continue;
+        }
+
+        for (Entry **pe = &table->buckets[entry->hash & table->mask]; *pe != nullptr; pe = &(*pe)->hnext) {
+            if (*pe == entry) {
+                *pe = entry->hnext;
+                entry->hnext = nullptr;
+                _size--;
+                return;
+            }
+        }
+    }
+
+    assert(false && "Entry is not in the index");
+}
+
+// See HashIndex.h
+size_t HashIndex::Scan(size_t cursor, size_t count, const std::function<void(const Entry *)> &visit) const {
+    uint64_t v = cursor;
+    for (size_t i = 0; i < count; i++) {
+        size_t pos = v & _main.mask;
+        for (Entry *e = _main.buckets[pos]; e != nullptr; e = e->hnext) {
+            visit(e);
+        }
+
+        // Old table is smaller, its bucket is shared by several buckets of the main one
+        if (_old.buckets != nullptr) {
+            for (Entry *e = _old.buckets[pos & _old.mask]; e != nullptr; e = e->hnext) {
+                if ((e->hash & _main.mask) == pos) {
+                    visit(e);
+                }
+            }
+        }
+
+        // Increment high bits first: buckets visited so far stay visited once table is doubled
+        v |= ~uint64_t(_main.mask);
+        v = ReverseBits(ReverseBits(v) + 1);
+        if (v == 0) {
+            break;
+        }
+    }
+    return v;
+}
+
+// See HashIndex.h
+double HashIndex::ScanProgress(size_t cursor) { return std::ldexp(double(ReverseBits(cursor)), -64); }
+
+// See HashIndex.h
+void HashIndex::Reserve(size_t expected) {
+    size_t buckets = RoundUp(expected);
+    if (buckets > _main.mask + 1) {
+        Grow(buckets);
+    }
+}
+
+// See HashIndex.h
+std::vector<Entry *> HashIndex::BulkInsert(const std::vector<Entry *> &entries, size_t threads) {
+    assert(_size == 0);
+    Reserve(entries.size());
+    Migrate(_old.mask + 1);
+
+    size_t buckets = _main.mask + 1;
+    threads = std::max<size_t>(1, std::min(threads, buckets / MinBuckets));
+
+    std::vector<std::vector<Entry *>> duplicates(threads);
+    std::vector<size_t> inserted(threads, 0);
+    auto fill = [this, &entries, &duplicates, &inserted, buckets, threads](size_t part) {
+        size_t from = buckets / threads * part;
+        size_t to = part + 1 == threads ? buckets : buckets / threads * (part + 1);
+
+        for (Entry *entry : entries) {
+            size_t pos = entry->hash & _main.mask;
+            if (pos < from || pos >= to) {
+                continue;
+            }
+
+            // Later entry replaces the earlier one with the same key
+            Entry **pe = &_main.buckets[pos];
+            while (*pe != nullptr && ((*pe)->hash != entry->hash || (*pe)->key != entry->key)) {
+                pe = &(*pe)->hnext;
+            }
+            if (*pe != nullptr) {
+                duplicates[part].push_back(*pe);
+                entry->hnext = (*pe)->hnext;
+                *pe = entry;
+            } else {
+                entry->hnext = _main.buckets[pos];
+                _main.buckets[pos] = entry;
+                inserted[part]++;
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < threads; i++) {
+        workers.emplace_back(fill, i);
+    }
+    fill(0);
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    std::vector<Entry *> result;
+    for (size_t i = 0; i < threads; i++) {
+        _size += inserted[i];
+        result.insert(result.end(), duplicates[i].begin(), duplicates[i].end());
+    }
+    return result;
+}
+
+// See HashIndex.h
+void HashIndex::Swap(HashIndex &other) {
+    std::swap(_main, other._main);
+    std::swap(_old, other._old);
+    std::swap(_migrate_pos, other._migrate_pos);
+    std::swap(_size, other._size);
+}
+
+// See HashIndex.h
+void HashIndex::Allocate(Table &table, size_t buckets) {
+    // Tables smaller than a huge page aren't worth it
+    table.huge = HugePagesEnabled() && buckets * sizeof(Entry *) >= HugePageSize;
+    if (table.huge) {
+        table.buckets = static_cast<Entry **>(HugeAlloc(buckets * sizeof(Entry *)));
+    } else {
+        // Grow runs under the storage lock, so table must not be zero filled at once. Large blocks are mapped
+        // by calloc with pages zeroed by the kernel on the first touch, that is by Insert and Migrate
+        table.buckets = static_cast<Entry **>(std::calloc(buckets, sizeof(Entry *)));
+        if (table.buckets == nullptr) {
+            throw std::bad_alloc();
+        }
+    }
+    table.mask = buckets - 1;
+}
+
+// See HashIndex.h
+void HashIndex::Release(Table &table) {
+    if (table.huge) {
+        HugeFree(table.buckets, (table.mask + 1) * sizeof(Entry *));
+    } else {
+        std::free(table.buckets);
+    }
+    table.buckets = nullptr;
+    table.mask = 0;
+    table.huge = false;
+}
+
+// See HashIndex.h
+void HashIndex::Migrate(size_t n) {
+    if (_old.buckets == nullptr) {
+        return;
+    }
+
+    size_t end = _migrate_pos + n;
+    if (end > _old.mask + 1) {
+        end = _old.mask + 1;
+    }
+
+    for (; _migrate_pos < end; _migrate_pos++) {
+        Entry *e = _old.buckets[_migrate_pos];
+        while (e != nullptr) {
+            Entry *next = e->hnext;
+            Entry *&bucket = _main.buckets[e->hash & _main.mask];
+            e->hnext = bucket;
+            bucket = e;
+            e = next;
+        }
+        _old.buckets[_migrate_pos] = nullptr;
+    }
+
+    if (_migrate_pos > _old.mask) {
+        Release(_old);
+        _migrate_pos = 0;
+    }
+}
+
+// See HashIndex.h
+void HashIndex::Grow(size_t buckets) {
+    // Should never happen as table doubles on growth, but if previous migration isn't complete
+    // yet it has to be finished before the next one
+    if (_old.buckets != nullptr) {
+        Migrate(_old.mask + 1);
+    }
+
+    _old = _main;
+    _migrate_pos = 0;
+    Allocate(_main, buckets);
+}
+
+} // namespace Backend
+} // namespace Afina
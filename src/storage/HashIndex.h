@@ -0,0 +1,137 @@
+#ifndef AFINA_STORAGE_HASH_INDEX_H
+#define AFINA_STORAGE_HASH_INDEX_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "LRUList.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Hash index over storage entries with incremental resize
+ * Chained hash table, chains are linked through Entry::hnext so index doesn't allocate anything per entry.
+ *
+ * Once table gets full, new table of the double size is allocated, but entries are not moved at once.
+ * Instead each operation migrates a bounded number of buckets from the old table, lookups check both
+ * tables until migration is finished. That way cost of resize is spread over many operations instead of
+ * a single long pause. New table is not zero filled upfront either, its pages are zeroed lazily by the kernel.
+ *
+ * Index doesn't own entries and is not thread safe
+ */
+class HashIndex {
+public:
+    /**
+     * @param expected number of entries to presize index for, no resize happens until it is reached
+     */
+    HashIndex(size_t expected = 0);
+    ~HashIndex();
+
+    HashIndex(const HashIndex &) = delete;
+    HashIndex &operator=(const HashIndex &) = delete;
+
+    /**
+     * Hash function used by the index, Entry::hash must be computed with it
+     */
+    static size_t Hash(const std::string &key);
+
+    /**
+     * Returns entry for the given key or nullptr if there is no such
+     */
+    Entry *Find(const std::string &key, size_t hash);
+    Entry *Find(const std::string &key) { return Find(key, Hash(key)); }
+
+    /**
+     * Adds entry into index, key must not be present yet and entry hash must be computed already
+     */
+    void Insert(Entry *entry);
+
+    /**
+     * Removes entry from index, entry must be present in the index
+     */
+    void Remove(Entry *entry);
+
+    /**
+     * Grows index to hold given number of entries without resize
+     */
+    void Reserve(size_t expected);
+
+    /**
+     * Fills empty index with the given entries using several threads, each thread owns a range of
+     * buckets so no synchronization is required. Entry hashes must be computed already.
+     *
+     * If several entries have the same key, the last one in the vector gets into the index. Others are
+     * returned to the caller
+     */
+    std::vector<Entry *> BulkInsert(const std::vector<Entry *> &entries, size_t threads);
+
+    /**
+     * Visits entries of up to `count` buckets starting from the cursor and returns cursor to continue
+     * from, 0 once the whole index is visited. Scan starts with cursor 0.
+     *
+     * Buckets are walked in the reversed bits order, so entries present during the whole scan are visited
+     * even if the index grows between the calls. Entries could be visited twice in that case
+     */
+    size_t Scan(size_t cursor, size_t count, const std::function<void(const Entry *)> &visit) const;
+
+    /**
+     * Share of the index visited by the scan started with cursor 0 once it returned the given cursor. Doesn't
+     * depend on the table size, so progress between two cursors is valid even if index grows in between
+     */
+    static double ScanProgress(size_t cursor);
+
+    /**
+     * Exchanges content with other index
+     */
+    void Swap(HashIndex &other);
+
+    // Number of entries in the index
+    size_t Size() const { return _size; }
+
+    // Number of buckets in the active table
+    size_t Buckets() const { return _main.mask + 1; }
+
+    // True if entries are migrating from the old table
+    bool Rehashing() const { return _old.buckets != nullptr; }
+
+private:
+    struct Table {
+        Entry **buckets;
+        size_t mask;
+
+        // Buckets are mapped by HugeAlloc, otherwise taken by calloc
+        bool huge;
+    };
+
+    // Buckets migrated per operation. Table is doubled on growth, so migration is always
+    // finished before next growth required
+    static const size_t MigrateStep = 16;
+
+    static void Allocate(Table &table, size_t buckets);
+    static void Release(Table &table);
+
+    // Moves up to n buckets from old table into the main one
+    void Migrate(size_t n);
+
+    // Starts migration to a table with the given number of buckets
+    void Grow(size_t buckets);
+
+    // Table new entries are inserted into
+    Table _main;
+
+    // Table being migrated, buckets is nullptr if there is no migration
+    Table _old;
+
+    // Buckets of the old table below that position are migrated already
+    size_t _migrate_pos;
+
+    size_t _size;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_HASH_INDEX_H
@@ -0,0 +1,178 @@
+#include "HugePages.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <new>
+
+#include <sys/mman.h>
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+std::atomic<bool> huge_pages_enabled(false);
+
+struct Region {
+    size_t size;
+    bool hugetlb;
+};
+
+// All regions mapped by HugeAlloc by start address
+std::mutex regions_m;
+std::map<uintptr_t, Region> regions;
+
+size_t RoundUp(size_t size) { return (size + HugePageSize - 1) / HugePageSize * HugePageSize; }
+
+} // namespace
+
+// See HugePages.h
+void EnableHugePages(bool enabled) { huge_pages_enabled.store(enabled); }
+
+// See HugePages.h
+bool HugePagesEnabled() { return huge_pages_enabled.load(std::memory_order_relaxed); }
+
+// See HugePages.h
+void *HugeAlloc(size_t size) {
+    size = RoundUp(size);
+
+    bool hugetlb = true;
+    void *addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (addr == MAP_FAILED) {
+        // No reserved huge pages, fallback to transparent ones. Region is over-allocated by a page
+        // to align it, otherwise the first and the last pages can't be huge
+        hugetlb = false;
+        char *raw = static_cast<char *>(
+            mmap(nullptr, size + HugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        if (raw == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+
+        char *aligned = reinterpret_cast<char *>(RoundUp(reinterpret_cast<uintptr_t>(raw)));
+        if (aligned != raw) {
+            munmap(raw, aligned - raw);
+        }
+        munmap(aligned + size, raw + HugePageSize - aligned);
+
+        madvise(aligned, size, MADV_HUGEPAGE);
+        addr = aligned;
+    }
+
+    std::lock_guard<std::mutex> lock(regions_m);
+    regions[reinterpret_cast<uintptr_t>(addr)] = {size, hugetlb};
+    return addr;
+}
+
+// See HugePages.h
+void HugeFree(void *addr, size_t size) {
+    {
+        std::lock_guard<std::mutex> lock(regions_m);
+        regions.erase(reinterpret_cast<uintptr_t>(addr));
+    }
+    munmap(addr, RoundUp(size));
+}
+
+// See HugePages.h
+HugePageUsage GetHugePageUsage() {
+    HugePageUsage usage = {0, 0, 0};
+
+    std::map<uintptr_t, Region> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(regions_m);
+        snapshot = regions;
+    }
+    for (auto &region : snapshot) {
+        usage.mapped += region.second.size;
+        if (region.second.hugetlb) {
+            usage.hugetlb += region.second.size;
+        }
+    }
+    if (snapshot.empty()) {
+        return usage;
+    }
+
+    FILE *smaps = std::fopen("/proc/self/smaps", "r");
+    if (smaps == nullptr) {
+        return usage;
+    }
+
+    // Kernel could merge adjacent mappings, so count huge pages of the mapping up to its overlap
+    // with our regions
+    char line[512];
+    size_t overlap = 0;
+    while (std::fgets(line, sizeof(line), smaps) != nullptr) {
+        unsigned long start, end;
+        size_t kb;
+        if (std::sscanf(line, "%lx-%lx ", &start, &end) == 2) {
+            overlap = 0;
+            for (auto it = snapshot.upper_bound(end); it != snapshot.begin();) {
+                --it;
+                uintptr_t from = std::max<uintptr_t>(it->first, start);
+                uintptr_t to = std::min<uintptr_t>(it->first + it->second.size, end);
+                if (to <= start) {
+                    break;
+                }
+                if (from < to && !it->second.hugetlb) {
+                    overlap += to - from;
+                }
+            }
+        } else if (overlap > 0 && std::sscanf(line, "AnonHugePages: %zu kB", &kb) == 1) {
+            usage.transparent += std::min(overlap, kb * 1024);
+        }
+    }
+    std::fclose(smaps);
+    return usage;
+}
+
+// See HugePages.h
+HugePagePool::HugePagePool(size_t object_size)
+    : _object_size((std::max(object_size, sizeof(void *)) + 15) / 16 * 16), _free(nullptr), _next(nullptr),
+      _end(nullptr), _nchunks(0) {}
+
+// See HugePages.h
+void *HugePagePool::Allocate() {
+    std::lock_guard<std::mutex> lock(_m);
+    if (_free != nullptr) {
+        void *p = _free;
+        _free = *static_cast<void **>(p);
+        return p;
+    }
+
+    if (_next + _object_size > _end) {
+        char *chunk = static_cast<char *>(HugeAlloc(HugePageSize));
+        _chunks.insert(std::upper_bound(_chunks.begin(), _chunks.end(), std::make_pair(chunk, chunk)),
+                       std::make_pair(chunk, chunk + HugePageSize));
+        _nchunks.store(_chunks.size(), std::memory_order_release);
+
+        _next = chunk;
+        _end = chunk + HugePageSize;
+    }
+
+    void *p = _next;
+    _next += _object_size;
+    return p;
+}
+
+// See HugePages.h
+bool HugePagePool::Free(void *p) {
+    if (_nchunks.load(std::memory_order_acquire) == 0) {
+        return false;
+    }
+
+    char *ptr = static_cast<char *>(p);
+    std::lock_guard<std::mutex> lock(_m);
+    auto it = std::upper_bound(_chunks.begin(), _chunks.end(), ptr,
+                               [](char *p, const std::pair<char *, char *> &chunk) { return p < chunk.first; });
+    if (it == _chunks.begin() || (--it)->second <= ptr) {
+        return false;
+    }
+
+    *static_cast<void **>(p) = _free;
+    _free = p;
+    return true;
+}
+
+} // namespace Backend
+} // namespace Afina
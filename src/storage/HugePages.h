@@ -0,0 +1,96 @@
+#ifndef AFINA_STORAGE_HUGE_PAGES_H
+#define AFINA_STORAGE_HUGE_PAGES_H
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Huge page backed memory
+ * Index buckets and entries are accessed randomly, so with large data set almost every Get misses TLB a few
+ * times. Backing that memory by 2MB pages cuts number of TLB entries needed to cover it by 512 times.
+ *
+ * Regions are mapped with MAP_HUGETLB first, that requires pages reserved via vm.nr_hugepages. If there are
+ * no free ones, region is mapped as usual and marked by madvise(MADV_HUGEPAGE), so kernel could back it by
+ * transparent huge pages. How much memory actually got huge pages is seen in /proc/self/smaps only, see
+ * GetHugePageUsage.
+ *
+ * Huge pages are disabled by default, switch affects allocations made after it
+ */
+void EnableHugePages(bool enabled);
+bool HugePagesEnabled();
+
+const size_t HugePageSize = 2 << 20;
+
+/**
+ * Maps zero filled region, size is rounded up to the huge page. Throws std::bad_alloc if there is
+ * no memory
+ */
+void *HugeAlloc(size_t size);
+
+/**
+ * Unmaps region returned by HugeAlloc, size must be the same as requested
+ */
+void HugeFree(void *addr, size_t size);
+
+struct HugePageUsage {
+    // Bytes mapped by HugeAlloc
+    size_t mapped;
+
+    // Part of mapped bytes backed by reserved huge pages
+    size_t hugetlb;
+
+    // Part of mapped bytes backed by transparent huge pages
+    size_t transparent;
+};
+
+/**
+ * Reports usage of all regions mapped by HugeAlloc, parses /proc/self/smaps so isn't cheap
+ */
+HugePageUsage GetHugePageUsage();
+
+/**
+ * # Pool of fixed size objects carved from huge page regions
+ * Memory is never returned to the system, freed objects are reused by later allocations. Thread safe
+ */
+class HugePagePool {
+public:
+    HugePagePool(size_t object_size);
+
+    HugePagePool(const HugePagePool &) = delete;
+    HugePagePool &operator=(const HugePagePool &) = delete;
+
+    void *Allocate();
+
+    /**
+     * Returns object to the pool. If pointer wasn't allocated by the pool method does nothing
+     * and returns false
+     */
+    bool Free(void *p);
+
+private:
+    const size_t _object_size;
+    std::mutex _m;
+
+    // Freed objects linked through their first word
+    void *_free;
+
+    // Unused tail of the last chunk
+    char *_next;
+    char *_end;
+
+    // Chunks sorted by address, number of chunks is kept separately so Free could quickly reject
+    // foreign pointers while pool is unused
+    std::vector<std::pair<char *, char *>> _chunks;
+    std::atomic<size_t> _nchunks;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_HUGE_PAGES_H
@@ -0,0 +1,101 @@
+#include "KeyHash.h"
+
+#include <cstring>
+#include <random>
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+// Odd constants with balanced bits, borrowed from wyhash
+const uint64_t P0 = 0xa0761d6478bd642full;
+const uint64_t P1 = 0xe7037ed1a0b428dbull;
+const uint64_t P2 = 0x8ebc6af09c88c6e3ull;
+const uint64_t P3 = 0x589965cc75374cc3ull;
+
+// 64x64->128 multiplication folded back to 64 bits
+inline uint64_t Mix(uint64_t a, uint64_t b) {
+    __uint128_t r = static_cast<__uint128_t>(a) * b;
+    return static_cast<uint64_t>(r) ^ static_cast<uint64_t>(r >> 64);
+}
+
+inline uint64_t Read8(const uint8_t *p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint64_t Read4(const uint8_t *p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// Reads 1..3 bytes
+inline uint64_t Read3(const uint8_t *p, size_t len) {
+    return (static_cast<uint64_t>(p[0]) << 16) | (static_cast<uint64_t>(p[len >> 1]) << 8) | p[len - 1];
+}
+
+uint64_t RandomSeed() {
+    std::random_device rd;
+    uint64_t seed = (static_cast<uint64_t>(rd()) << 32) ^ rd();
+    return Mix(seed ^ P0, P1);
+}
+
+// Chosen once per process, before main
+const uint64_t Seed = RandomSeed();
+
+} // namespace
+
+// See KeyHash.h
+uint64_t KeyHash(const char *data, size_t len) {
+    const uint8_t *p = reinterpret_cast<const uint8_t *>(data);
+    uint64_t seed = Seed;
+    uint64_t a, b;
+
+    if (len <= 16) {
+        if (len >= 4) {
+            size_t shift = (len >> 3) << 2;
+            a = (Read4(p) << 32) | Read4(p + shift);
+            b = (Read4(p + len - 4) << 32) | Read4(p + len - 4 - shift);
+        } else if (len > 0) {
+            a = Read3(p, len);
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t i = len;
+        if (i > 48) {
+            // Three independent lanes to keep multipliers busy on long keys
+            uint64_t lane1 = seed, lane2 = seed;
+            do {
+                seed = Mix(Read8(p) ^ P1, Read8(p + 8) ^ seed);
+                lane1 = Mix(Read8(p + 16) ^ P2, Read8(p + 24) ^ lane1);
+                lane2 = Mix(Read8(p + 32) ^ P3, Read8(p + 40) ^ lane2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= lane1 ^ lane2;
+        }
+
+        while (i > 16) {
+            seed = Mix(Read8(p) ^ P1, Read8(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+
+        // Last 16 bytes, possibly overlapping with already consumed ones
+        a = Read8(p + i - 16);
+        b = Read8(p + i - 8);
+    }
+
+    return Mix(P1 ^ len, Mix(a ^ P1, b ^ seed));
+}
+
+// See KeyHash.h
+uint64_t KeyHashSeed() { return Seed; }
+
+} // namespace Backend
+} // namespace Afina
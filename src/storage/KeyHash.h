@@ -0,0 +1,48 @@
+#ifndef AFINA_STORAGE_KEY_HASH_H
+#define AFINA_STORAGE_KEY_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Seeded hash function for storage keys
+ * Multiply-mix function of the wyhash family: consumes 8 bytes per multiplication and needs
+ * no tables, so it is fast on short and long keys alike.
+ *
+ * Function is keyed by a secret seed chosen randomly once per process. Without knowing seed client can't
+ * build a set of colliding keys offline, so hostile client isn't able to degrade index to linked list
+ * (hash flooding). Note that hardware crc32c doesn't help here: crc is linear and keys of the same length
+ * colliding for one seed collide for any seed.
+ *
+ * Hash values aren't stable between process restarts and must never be persisted.
+ */
+uint64_t KeyHash(const char *data, size_t len);
+
+inline uint64_t KeyHash(const std::string &key) { return KeyHash(key.data(), key.size()); }
+
+/**
+ * KeyHash as a hasher of standard unordered containers
+ */
+struct KeyHasher {
+    size_t operator()(const std::string &key) const { return KeyHash(key); }
+};
+
+/**
+ * Seed used by the current process
+ */
+uint64_t KeyHashSeed();
+
+/**
+ * Maps hash onto one of n shards. Upper bits are used for that, so shards and hash tables indexed by lower
+ * bits stay independent
+ */
+inline size_t KeyHashShard(uint64_t hash, size_t n) { return ((hash >> 32) * n) >> 32; }
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_KEY_HASH_H
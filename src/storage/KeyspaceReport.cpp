@@ -0,0 +1,116 @@
+#include "KeyspaceReport.h"
+
+#include <algorithm>
+#include <functional>
+#include <time.h>
+
+namespace Afina {
+namespace Backend {
+
+const uint32_t KeyspaceReport::IdleBounds[] = {60, 600, 3600, 6 * 3600, 24 * 3600};
+
+// See KeyspaceReport.h
+uint32_t CoarseNow() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return ts.tv_sec;
+}
+
+// See KeyspaceReport.h
+KeyspaceReport::KeyspaceReport(size_t bigkeys, size_t prefixes)
+    : _bigkeys(bigkeys), _prefixes(prefixes), _items(0), _bytes(0), _other_prefixes(0, 0) {
+    std::fill(_idle, _idle + IdleBuckets, 0);
+}
+
+// See KeyspaceReport.h
+void KeyspaceReport::Add(const std::string &key, size_t value_size, uint32_t idle) {
+    size_t bytes = key.size() + value_size;
+    _items++;
+    _bytes += bytes;
+
+    size_t bucket = 0;
+    while ((size_t(1) << bucket) < value_size) {
+        bucket++;
+    }
+    if (_sizes.size() <= bucket) {
+        _sizes.resize(bucket + 1, 0);
+    }
+    _sizes[bucket]++;
+
+    // Keys are copied only if value gets into the current top
+    auto greater = std::greater<std::pair<size_t, std::string>>();
+    if (_big.size() < _bigkeys) {
+        _big.emplace_back(value_size, key);
+        std::push_heap(_big.begin(), _big.end(), greater);
+    } else if (_bigkeys > 0 && value_size > _big.front().first) {
+        std::pop_heap(_big.begin(), _big.end(), greater);
+        _big.back() = std::make_pair(value_size, key);
+        std::push_heap(_big.begin(), _big.end(), greater);
+    }
+
+    _prefix.assign(key, 0, key.find(':'));
+    auto it = _prefix_usage.find(_prefix);
+    if (it == _prefix_usage.end() && _prefix_usage.size() < MaxPrefixes) {
+        it = _prefix_usage.emplace(_prefix, std::make_pair(0, 0)).first;
+    }
+    std::pair<size_t, size_t> &usage = it == _prefix_usage.end() ? _other_prefixes : it->second;
+    usage.first++;
+    usage.second += bytes;
+
+    size_t idle_bucket = 0;
+    while (idle_bucket < IdleBuckets - 1 && idle > IdleBounds[idle_bucket]) {
+        idle_bucket++;
+    }
+    _idle[idle_bucket]++;
+}
+
+// See KeyspaceReport.h
+void KeyspaceReport::Report(Storage::StatsList &stats) const {
+    stats.emplace_back("keyspace_items", std::to_string(_items));
+    stats.emplace_back("keyspace_bytes", std::to_string(_bytes));
+
+    for (size_t i = 0; i < _sizes.size(); i++) {
+        if (_sizes[i] != 0) {
+            stats.emplace_back("value_size_le_" + std::to_string(size_t(1) << i), std::to_string(_sizes[i]));
+        }
+    }
+
+    std::vector<std::pair<size_t, std::string>> big(_big);
+    std::sort(big.begin(), big.end(), std::greater<std::pair<size_t, std::string>>());
+    for (auto &item : big) {
+        stats.emplace_back("bigkey:" + item.second, std::to_string(item.first));
+    }
+
+    std::vector<std::pair<std::string, std::pair<size_t, size_t>>> prefixes(_prefix_usage.begin(),
+                                                                             _prefix_usage.end());
+    std::sort(prefixes.begin(), prefixes.end(),
+              [](const std::pair<std::string, std::pair<size_t, size_t>> &a,
+                 const std::pair<std::string, std::pair<size_t, size_t>> &b) {
+                  return a.second.second > b.second.second;
+              });
+
+    // Prefixes that didn't get into report are summed up with untracked ones
+    std::pair<size_t, size_t> other = _other_prefixes;
+    for (size_t i = 0; i < prefixes.size(); i++) {
+        if (i < _prefixes) {
+            const std::pair<size_t, size_t> &usage = prefixes[i].second;
+            stats.emplace_back("prefix:" + prefixes[i].first,
+                               std::to_string(usage.first) + " " + std::to_string(usage.second));
+        } else {
+            other.first += prefixes[i].second.first;
+            other.second += prefixes[i].second.second;
+        }
+    }
+    if (other.first != 0) {
+        stats.emplace_back("prefix_other", std::to_string(other.first) + " " + std::to_string(other.second));
+    }
+
+    for (size_t i = 0; i < IdleBuckets - 1; i++) {
+        stats.emplace_back("idle_le_" + std::to_string(IdleBounds[i]) + "s", std::to_string(_idle[i]));
+    }
+    stats.emplace_back("idle_gt_" + std::to_string(IdleBounds[IdleBuckets - 2]) + "s",
+                       std::to_string(_idle[IdleBuckets - 1]));
+}
+
+} // namespace Backend
+} // namespace Afina
@@ -0,0 +1,87 @@
+#ifndef AFINA_STORAGE_KEYSPACE_REPORT_H
+#define AFINA_STORAGE_KEYSPACE_REPORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <afina/Storage.h>
+#include "KeyHash.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * Seconds of the coarse monotonic clock, cheap enough to be read on every access
+ */
+uint32_t CoarseNow();
+
+/**
+ * # Keyspace analysis
+ * Accumulates entries visited by the keyspace scan:
+ *  - histogram of value sizes by powers of two
+ *  - largest values, key and size for each of them
+ *  - memory taken by key prefixes, prefix is a part of the key up to the first ':'
+ *  - histogram of time since the last access
+ *
+ * Memory is bounded: only limited number of distinct prefixes is tracked, the rest is accounted as
+ * "other". Not thread safe
+ */
+class KeyspaceReport {
+public:
+    /**
+     * @param bigkeys number of the largest values to report
+     * @param prefixes number of prefixes to report, by memory taken
+     */
+    KeyspaceReport(size_t bigkeys, size_t prefixes);
+
+    /**
+     * Accounts one entry, idle is number of seconds since the last access
+     */
+    void Add(const std::string &key, size_t value_size, uint32_t idle);
+
+    /**
+     * Appends report to the stats
+     */
+    void Report(Storage::StatsList &stats) const;
+
+    // Number of entries accounted
+    size_t Items() const { return _items; }
+
+private:
+    // Maximum number of distinct prefixes tracked
+    static const size_t MaxPrefixes = 1024;
+
+    // Upper bounds of idle time histogram buckets in seconds, the last bucket is unbounded
+    static const size_t IdleBuckets = 6;
+    static const uint32_t IdleBounds[IdleBuckets - 1];
+
+    const size_t _bigkeys;
+    const size_t _prefixes;
+
+    size_t _items;
+    size_t _bytes;
+
+    // Number of values of size in (2^(i-1), 2^i]
+    std::vector<size_t> _sizes;
+
+    // Min-heap by value size, holds up to _bigkeys largest values
+    std::vector<std::pair<size_t, std::string>> _big;
+
+    // Prefix => (items, bytes), prefixes come from clients so hash is seeded
+    std::unordered_map<std::string, std::pair<size_t, size_t>, KeyHasher> _prefix_usage;
+    std::pair<size_t, size_t> _other_prefixes;
+
+    // Prefix of the key being added, buffer keeps its capacity so lookup doesn't allocate
+    std::string _prefix;
+
+    size_t _idle[IdleBuckets];
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_KEYSPACE_REPORT_H
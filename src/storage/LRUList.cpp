@@ -1,7 +1,31 @@
 #include "LRUList.h"
 
+#include <afina/allocator/Slab.h>
+
+#include "HugePages.h"
+
 namespace Afina {
 namespace Backend {
+    namespace {
+        HugePagePool& EntryPool() {
+            static HugePagePool pool(sizeof(Entry));
+            return pool;
+        }
+    } // namespace
+
+    void* Entry::operator new(size_t size) {
+        if (HugePagesEnabled()) {
+            return EntryPool().Allocate();
+        }
+        return Allocator::SlabAllocated<Entry>::operator new(size);
+    }
+
+    void Entry::operator delete(void* p) {
+        if (p != nullptr && !EntryPool().Free(p)) {
+            Allocator::SlabAllocated<Entry>::operator delete(p);
+        }
+    }
+
     LRUList::~LRUList() {
         auto tmp = _head;
         while (tmp != nullptr) {
@@ -26,6 +50,11 @@ namespace Backend {
     }
 
     void LRUList::DeleteNode(Entry* node) {
+        Unlink(node);
+        delete node;
+    }
+
+    void LRUList::Unlink(Entry* node) {
         assert(node);
 
         if (node == _head) {
@@ -39,8 +68,6 @@ namespace Backend {
         } else {
             node->next->prev = node->prev;
         }
-
-        delete node;
     }
 
     void LRUList::MakeTop(Entry* node) {
@@ -4,6 +4,11 @@
 #include <memory>
 #include <iostream>
 #include <cassert>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include <afina/allocator/Resource.h>
 
 namespace Afina {
 namespace Backend {
@@ -11,9 +16,41 @@ namespace Backend {
 struct Entry
 {
     std::string key;
-    std::string value;
+
+    // Large values are placed into the buddy region of the storage, see MapBasedGlobalLockImpl.h
+    Allocator::String value;
     Entry* next;
     Entry* prev;
+
+    // Next entry in the hash index bucket, see HashIndex.h
+    Entry* hnext;
+    size_t hash;
+
+    // Key is detected as hot and could be replicated, see MapBasedGlobalLockImpl.h
+    bool hot;
+
+    // Entry has been accessed since insertion, used by ARC policy, see ARCPolicy.h
+    bool frequent;
+
+    // Entry is invalidated, its value could be served only as a stale one while key is refilled under
+    // lease. Placeholder is an invalidated entry without value that just holds lease for the missing key
+    bool invalid;
+    bool placeholder;
+
+    // Storage generation entry is written in, entries of older generations are flushed
+    uint32_t generation;
+
+    // Time of the last access by CoarseNow, see KeyspaceReport.h
+    uint32_t atime;
+
+    // Token of the lease granted for the key refill and time it has been granted, 0 if there is no lease
+    uint32_t lease;
+    uint32_t lease_time;
+
+    // Entries are taken from huge page pool once huge pages are enabled, see HugePages.h, and from the
+    // slab pool otherwise, see afina/allocator/Slab.h
+    static void* operator new(size_t size);
+    static void operator delete(void* p);
 };
 
 class LRUList {
@@ -24,10 +61,18 @@ public:
     void AddNode(Entry* node);
     void DeleteNode(Entry* node);
 
+    // Detaches node from the list without releasing it
+    void Unlink(Entry* node);
+
     void MakeTop(Entry* node);
 
     Entry* GetTail() const { return _tail;}
 
+    void Swap(LRUList& other) {
+        std::swap(_head, other._head);
+        std::swap(_tail, other._tail);
+    }
+
 private:
     Entry* _head;
     Entry* _tail;
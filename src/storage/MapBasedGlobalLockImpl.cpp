@@ -1,48 +1,355 @@
 #include "MapBasedGlobalLockImpl.h"
 
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "Dump.h"
+#include "HugePages.h"
+#include "KeyspaceReport.h"
+
 namespace Afina {
 namespace Backend {
+
+constexpr std::chrono::milliseconds MapBasedGlobalLockImpl::MaintainerPeriod;
+
+namespace {
+
+// Read-only copy of hot values owned by a thread, valid for a single storage instance and epoch
+struct HotReplica {
+    struct Value {
+        std::string value;
+
+        // Gets served since the last fold
+        size_t hits;
+    };
+
+    uint64_t owner = 0;
+    uint64_t epoch = 0;
+    std::unordered_map<std::string, Value, KeyHasher> values;
+
+    // Gets served since the last fold, for all values
+    size_t hits = 0;
+};
+
+thread_local HotReplica hot_replica;
+
+std::atomic<uint64_t> instances(0);
+
+// Cache sizes ghost hits are reported for, in percents of the max size and as named in stats
+const size_t GhostSizes[] = {125, 150, 200};
+const char *GhostSizeNames[] = {"1.25x", "1.5x", "2x"};
+
+} // namespace
+
+// See MapBasedGlobalLockImpl.h
+MapBasedGlobalLockImpl::MapBasedGlobalLockImpl(size_t max_size, bool use_lock, size_t expected_items,
+                                               const std::string &policy)
+    : _max_size(max_size), _curr_size(0), _backend(expected_items),
+      _region(max_size >= LargeValue * LargeValueRegions ? new char[max_size] : nullptr),
+      _buddy(_region.get(), _region ? max_size : 0, Allocator::Buddy::DefaultPageSize, LargeValueRelease),
+      _values("storage.values", _buddy, LargeValue),
+      _policy_name(policy), _policy(MakeEvictionPolicy(policy, max_size)), _m(use_lock),
+      _low_watermark(max_size / 10 * 8), _high_watermark(max_size / 10 * 9), _inline_evictions(0),
+      _maintainer_cycles(0), _maintainer_evictions(0), _id(++instances), _sketch(HotSketchSize), _hot_ticks(0),
+      _hot_invalidations(0), _hot_epoch(0), _generation(0), _stale_items(0), _flush_pending(false),
+      _lease_counter(0), _lease_grants(0), _lease_stale(0), _lease_waits(0), _lease_rejects(0), _invalidations(0),
+      _ghost_sample_shift(0), _ghost_misses(0), _keyspace_cursor(0), _maintainer_stop(false) {
+    std::fill(_ghost_hits, _ghost_hits + 3, 0);
+}
+
+// See MapBasedGlobalLockImpl.h
+MapBasedGlobalLockImpl::~MapBasedGlobalLockImpl() { Stop(); }
+
+// See MapBasedGlobalLockImpl.h
+void MapBasedGlobalLockImpl::Start() {
+    if (!_m.enabled() || _maintainer.joinable()) {
+        return;
+    }
+
+    _maintainer_stop = false;
+    _maintainer = std::thread(&MapBasedGlobalLockImpl::Maintain, this);
+}
+
+// See MapBasedGlobalLockImpl.h
+void MapBasedGlobalLockImpl::Stop() {
+    if (!_maintainer.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_maintainer_m);
+        _maintainer_stop = true;
+    }
+    _maintainer_cv.notify_one();
+    _maintainer.join();
+}
+
+// See MapBasedGlobalLockImpl.h
+void MapBasedGlobalLockImpl::SetWatermarks(size_t low, size_t high) {
+    std::lock_guard<OptionalMutex> lock(_m);
+    _low_watermark = low;
+    _high_watermark = high;
+}
+
+// See MapBasedGlobalLockImpl.h
+void MapBasedGlobalLockImpl::EnableGhosts(bool enabled, size_t sample_shift) {
+    std::lock_guard<OptionalMutex> lock(_m);
+    _ghosts.reset(enabled ? new GhostList(_max_size * (GhostSizes[2] - 100) / 100, sample_shift) : nullptr);
+    _ghost_sample_shift = sample_shift;
+    _ghost_misses = 0;
+    std::fill(_ghost_hits, _ghost_hits + 3, 0);
+}
+
+// See MapBasedGlobalLockImpl.h
+void MapBasedGlobalLockImpl::Evict() {
+    auto tail = _policy->Victim();
+    for (size_t i = 0; i < HotKeys && tail->hot && !Stale(tail); i++) {
+        _policy->Touch(tail);
+        tail = _policy->Victim();
+    }
+
+    InvalidateHot(tail);
+    if (_ghosts && !Stale(tail)) {
+        _ghosts->Add(tail->hash, tail->key.size() + tail->value.size());
+    }
+    Remove(tail, true);
+}
+
+// See MapBasedGlobalLockImpl.h
+void MapBasedGlobalLockImpl::Remove(Entry *entry, bool evicted) {
+    if (Stale(entry)) {
+        _stale_items--;
+    }
+    _curr_size -= entry->key.size() + entry->value.size();
+    _backend.Remove(entry);
+    _policy->Remove(entry, evicted);
+}
+
+// See MapBasedGlobalLockImpl.h
+Entry *MapBasedGlobalLockImpl::FindLive(const std::string &key, size_t hash) {
+    Entry *entry = _backend.Find(key, hash);
+    if (entry != nullptr && Stale(entry)) {
+        Remove(entry);
+        return nullptr;
+    }
+    return entry;
+}
+
+// See MapBasedGlobalLockImpl.h
+void MapBasedGlobalLockImpl::CheckFlush() const {
+    if (_flush_pending.load(std::memory_order_relaxed) && std::chrono::steady_clock::now() >= _flush_at) {
+        ApplyFlush();
+    }
+}
+
+// See MapBasedGlobalLockImpl.h
+void MapBasedGlobalLockImpl::ApplyFlush() const {
+    _generation++;
+    _stale_items = _backend.Size();
+    _flush_pending.store(false, std::memory_order_release);
+
+    // Replicas hold values of the previous generation
+    _hot_keys.clear();
+    _hot_epoch.fetch_add(1, std::memory_order_release);
+}
+
+// See MapBasedGlobalLockImpl.h
+void MapBasedGlobalLockImpl::SampleHot(const std::string &key, size_t reads) const {
+    size_t ticks = _hot_ticks;
+    _hot_ticks += reads;
+
+    size_t samples = _hot_ticks / HotSampleRate - ticks / HotSampleRate;
+    if (samples == 0) {
+        return;
+    }
+
+    _sketch.Add(key, samples);
+    if (_hot_ticks / (HotSampleRate * HotRefresh) != ticks / (HotSampleRate * HotRefresh)) {
+        RefreshHot();
+    }
+}
+
+// See MapBasedGlobalLockImpl.h
+void MapBasedGlobalLockImpl::RefreshHot() const {
+    uint64_t threshold = _sketch.Total() / HotShare;
+    if (threshold < HotMinCount) {
+        threshold = HotMinCount;
+    }
+
+    std::vector<std::string> keys;
+    for (auto &counter : _sketch.Top(HotKeys)) {
+        if (counter.count - counter.error >= threshold) {
+            keys.push_back(counter.key);
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+
+    // Let sketch follow changes of the workload
+    _sketch.Decay();
+    if (keys == _hot_keys) {
+        return;
+    }
+
+    for (auto &key : _hot_keys) {
+        Entry *entry = _backend.Find(key);
+        if (entry != nullptr) {
+            entry->hot = false;
+        }
+    }
+    for (auto &key : keys) {
+        Entry *entry = _backend.Find(key);
+        if (entry != nullptr) {
+            entry->hot = true;
+        }
+    }
+    _hot_keys.swap(keys);
+
+    // Drop replicas of keys that aren't hot anymore
+    _hot_epoch.fetch_add(1, std::memory_order_release);
+}
+
+// See MapBasedGlobalLockImpl.h
+void MapBasedGlobalLockImpl::Replicate(const std::string &key, const std::string &value) const {
+    HotReplica &replica = hot_replica;
+    uint64_t epoch = _hot_epoch.load(std::memory_order_relaxed);
+    if (replica.owner != _id || replica.epoch != epoch) {
+        replica.values.clear();
+        replica.owner = _id;
+        replica.epoch = epoch;
+        replica.hits = 0;
+    }
+
+    if (replica.values.size() < HotKeys) {
+        HotReplica::Value &hot = replica.values[key];
+        hot.value = value;
+        hot.hits = 0;
+    }
+}
+
+// See MapBasedGlobalLockImpl.h
+void MapBasedGlobalLockImpl::FoldReplicaHits() const {
+    HotReplica &replica = hot_replica;
+    if (replica.owner != _id || replica.hits == 0) {
+        return;
+    }
+
+    uint32_t now = CoarseNow();
+    for (auto &it : replica.values) {
+        if (it.second.hits == 0) {
+            continue;
+        }
+
+        Entry *entry = _backend.Find(it.first);
+        if (entry != nullptr && !Stale(entry)) {
+            entry->atime = now;
+            _policy->Touch(entry);
+        }
+        SampleHot(it.first, it.second.hits);
+        it.second.hits = 0;
+    }
+    replica.hits = 0;
+}
+
+// See MapBasedGlobalLockImpl.h
+void MapBasedGlobalLockImpl::InvalidateHot(const Entry *entry) {
+    if (entry->hot) {
+        _hot_epoch.fetch_add(1, std::memory_order_release);
+        _hot_invalidations++;
+    }
+}
+
+// See MapBasedGlobalLockImpl.h
+void MapBasedGlobalLockImpl::Maintain() {
+    std::unique_lock<std::mutex> lock(_maintainer_m);
+    while (!_maintainer_stop) {
+        // Notifications are sent without maintainer lock so could be lost, periodic wake up covers that
+        _maintainer_cv.wait_for(lock, MaintainerPeriod);
+        if (_maintainer_stop) {
+            break;
+        }
+        lock.unlock();
+
+        bool run;
+        {
+            std::lock_guard<OptionalMutex> guard(_m);
+            run = _curr_size > _high_watermark;
+            if (run) {
+                _maintainer_cycles++;
+            }
+        }
+
+        // Release storage lock between batches to let requests go
+        while (run) {
+            std::lock_guard<OptionalMutex> guard(_m);
+            for (size_t i = 0; i < MaintainerBatch && _curr_size > _low_watermark; i++) {
+                Evict();
+                _maintainer_evictions++;
+            }
+            run = _curr_size > _low_watermark;
+        }
+
+        lock.lock();
+    }
+}
+
 // See MapBasedGlobalLockImpl.h
 bool MapBasedGlobalLockImpl::SimplePut(const std::string &key, const std::string &value) {
-    auto it = _backend.find(key);
+    size_t hash = HashIndex::Hash(key);
+    Entry *entry = FindLive(key, hash);
 
-    if (it != _backend.end()) {
-        auto new_size = _curr_size - it->second.value.size() + value.size();
+    bool hot = false;
+    if (entry != nullptr) {
+        auto new_size = _curr_size - entry->value.size() + value.size();
 
+        InvalidateHot(entry);
+        hot = entry->hot;
         if (new_size <= _max_size) {
-            it->second.value = value;
-            _list.MakeTop(&it->second);
+            size_t old_size = entry->key.size() + entry->value.size();
+            entry->value.assign(value.data(), value.size());
+            entry->atime = CoarseNow();
+            _policy->Update(entry, old_size);
 
             _curr_size = new_size;
             return true;
         }
-        _curr_size -= key.size() + it->second.value.size();
-        _list.DeleteNode(&it->second);
-        _backend.erase(it);
+        Remove(entry);
     }
 
+    // Fallback in case if maintainer doesn't keep up
     while (_curr_size + key.size() + value.size() > _max_size) {
-        auto tail = _list.GetTail();
-        _curr_size -= tail->key.size() + tail->value.size();
-        _backend.erase(tail->key);
-        _list.DeleteNode(tail);
+        Evict();
+        _inline_evictions++;
+    }
+
+    // Key is back, its ghost would count the next miss wrong
+    if (_ghosts) {
+        _ghosts->Take(hash);
     }
 
     auto node = new Entry();
     node->key = key;
-    node->value = value;
+    node->value = Allocator::String(value.data(), value.size(), _values);
+    node->hash = hash;
+    node->hot = hot;
+    node->generation = _generation;
+    node->atime = CoarseNow();
 
-    _list.AddNode(node);
-    _backend.insert(std::make_pair(std::cref(node->key), std::ref(*node)));
+    _policy->Insert(node);
+    _backend.Insert(node);
 
     _curr_size += key.size() + value.size();
+    if (_curr_size > _high_watermark) {
+        _maintainer_cv.notify_one();
+    }
     return true;
 }
 
 // See MapBasedGlobalLockImpl.h
 bool MapBasedGlobalLockImpl::Put(const std::string &key, const std::string &value) {
     if (key.size() + value.size() > _max_size) return false;
-    std::lock_guard<std::mutex> lock(_m);
+    std::lock_guard<OptionalMutex> lock(_m);
+    CheckFlush();
 
     return SimplePut(key, value);
 }
@@ -50,51 +357,449 @@ bool MapBasedGlobalLockImpl::Put(const std::string &key, const std::string &valu
 // See MapBasedGlobalLockImpl.h
 bool MapBasedGlobalLockImpl::PutIfAbsent(const std::string &key, const std::string &value) {
     if (key.size() + value.size() > _max_size) return false;
-    std::lock_guard<std::mutex> lock(_m);
+    std::lock_guard<OptionalMutex> lock(_m);
+    CheckFlush();
 
-    if (_backend.find(key) != _backend.end()) return false;
+    if (FindLive(key, HashIndex::Hash(key)) != nullptr) return false;
     return SimplePut(key, value);
 }
 
 // See MapBasedGlobalLockImpl.h
 bool MapBasedGlobalLockImpl::Set(const std::string &key, const std::string &value) {
     if (key.size() + value.size() > _max_size) return false;
-    std::lock_guard<std::mutex> lock(_m);
+    std::lock_guard<OptionalMutex> lock(_m);
+    CheckFlush();
 
-    auto it = _backend.find(key);
-    if (it == _backend.end()) {
+    Entry *entry = FindLive(key, HashIndex::Hash(key));
+    if (entry == nullptr) {
         return false;
     }
 
-    _curr_size = _curr_size - it->second.value.size() + value.size();
-    it->second.value = value;
+    InvalidateHot(entry);
+    size_t old_size = entry->key.size() + entry->value.size();
+    _curr_size = _curr_size - entry->value.size() + value.size();
+    entry->value.assign(value.data(), value.size());
+    entry->atime = CoarseNow();
+    _policy->Update(entry, old_size);
+    return true;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool MapBasedGlobalLockImpl::Append(const std::string &key, const std::string &data) {
+    std::lock_guard<OptionalMutex> lock(_m);
+    CheckFlush();
+
+    Entry *entry = FindLive(key, HashIndex::Hash(key));
+    if (entry == nullptr || entry->key.size() + entry->value.size() + data.size() > _max_size) {
+        return false;
+    }
+
+    // Others have to be evicted, which put does without taking the entry itself
+    if (_curr_size + data.size() > _max_size) {
+        std::string value(entry->value.data(), entry->value.size());
+        return SimplePut(key, value.append(data));
+    }
+
+    InvalidateHot(entry);
+    size_t old_size = entry->key.size() + entry->value.size();
+    entry->value.append(data.data(), data.size());
+    entry->atime = CoarseNow();
+    _policy->Update(entry, old_size);
+
+    _curr_size += data.size();
+    if (_curr_size > _high_watermark) {
+        _maintainer_cv.notify_one();
+    }
     return true;
 }
 
 // See MapBasedGlobalLockImpl.h
 bool MapBasedGlobalLockImpl::Delete(const std::string &key) {
-    std::lock_guard<std::mutex> lock(_m);
+    std::lock_guard<OptionalMutex> lock(_m);
+    CheckFlush();
 
-    auto it = _backend.find(key);
-    if (it == _backend.end()) return false;
+    Entry *entry = FindLive(key, HashIndex::Hash(key));
+    if (entry == nullptr) return false;
 
-    _curr_size -= key.size() + it->second.value.size();
-    _list.DeleteNode(&it->second);
-    _backend.erase(it);
+    InvalidateHot(entry);
+    Remove(entry);
     return true;
 }
 
 // See MapBasedGlobalLockImpl.h
 bool MapBasedGlobalLockImpl::Get(const std::string &key, std::string &value) const {
-    std::lock_guard<std::mutex> lock(_m);
+    if (_m.enabled() && !_flush_pending.load(std::memory_order_acquire)) {
+        HotReplica &replica = hot_replica;
+        if (replica.owner == _id && replica.epoch == _hot_epoch.load(std::memory_order_acquire) &&
+            replica.hits < HotFoldHits) {
+            auto it = replica.values.find(key);
+            if (it != replica.values.end()) {
+                it->second.hits++;
+                replica.hits++;
+                value = it->second.value;
+                return true;
+            }
+        }
+    }
+
+    std::lock_guard<OptionalMutex> lock(_m);
+    CheckFlush();
+    FoldReplicaHits();
+
+    // Stale entry is left for writers or eviction to reclaim
+    size_t hash = HashIndex::Hash(key);
+    Entry *entry = _backend.Find(key, hash);
+    if (entry == nullptr || Stale(entry)) {
+        if (_ghosts) {
+            _ghost_misses++;
+            size_t distance = _ghosts->Take(hash);
+            for (size_t i = 0; i < 3 && distance != 0; i++) {
+                _ghost_hits[i] += distance <= _max_size * (GhostSizes[i] - 100) / 100;
+            }
+        }
+        return false;
+    }
+
+    value.assign(entry->value.data(), entry->value.size());
+    entry->atime = CoarseNow();
+    _policy->Touch(entry);
+
+    SampleHot(key);
+    if (entry->hot && _m.enabled() && value.size() <= HotValueLimit) {
+        Replicate(key, value);
+    }
+    return true;
+}
+
+// See MapBasedGlobalLockImpl.h
+Storage::LeaseStatus MapBasedGlobalLockImpl::LeaseGet(const std::string &key, std::string &value, uint64_t &token) {
+    if (key.size() > _max_size) {
+        throw std::runtime_error("Key doesn't fit into storage");
+    }
+    std::lock_guard<OptionalMutex> lock(_m);
+    CheckFlush();
+
+    size_t hash = HashIndex::Hash(key);
+    uint32_t now = CoarseNow();
+    Entry *entry = _backend.Find(key, hash);
+    if (entry != nullptr && !Stale(entry)) {
+        value.assign(entry->value.data(), entry->value.size());
+        entry->atime = now;
+        _policy->Touch(entry);
+        return LeaseStatus::Hit;
+    }
+
+    // Flushed entry carries neither lease nor value that could be served
+    if (entry != nullptr && entry->generation != _generation) {
+        Remove(entry);
+        entry = nullptr;
+    }
+
+    if (entry != nullptr && entry->lease != 0 && now - entry->lease_time < LeaseTimeout) {
+        if (!entry->placeholder && now - entry->atime <= LeaseGrace) {
+            value.assign(entry->value.data(), entry->value.size());
+            _lease_stale++;
+            return LeaseStatus::Stale;
+        }
+        _lease_waits++;
+        return LeaseStatus::Wait;
+    }
+
+    if (entry == nullptr) {
+        while (_curr_size + key.size() > _max_size) {
+            Evict();
+            _inline_evictions++;
+        }
+
+        entry = new Entry();
+        entry->key = key;
+        entry->value = Allocator::String(_values);
+        entry->hash = hash;
+        entry->invalid = true;
+        entry->placeholder = true;
+        entry->generation = _generation;
+        entry->atime = now;
+
+        _policy->Insert(entry);
+        _backend.Insert(entry);
+        _curr_size += key.size();
+        _stale_items++;
+    }
+
+    if (++_lease_counter == 0) {
+        _lease_counter++;
+    }
+    entry->lease = _lease_counter;
+    entry->lease_time = now;
+    token = entry->lease;
+    _lease_grants++;
+    return LeaseStatus::Granted;
+}
+
+// See MapBasedGlobalLockImpl.h
+bool MapBasedGlobalLockImpl::LeaseSet(const std::string &key, const std::string &value, uint64_t token) {
+    if (key.size() + value.size() > _max_size) return false;
+    std::lock_guard<OptionalMutex> lock(_m);
+    CheckFlush();
+
+    // Any write or flush since the grant has replaced the entry holding lease
+    Entry *entry = _backend.Find(key);
+    if (entry == nullptr || entry->generation != _generation || !entry->invalid || token == 0 ||
+        entry->lease != token) {
+        _lease_rejects++;
+        return false;
+    }
 
-    auto it = _backend.find(key);
-    if (it == _backend.end()) return false;
+    Remove(entry);
+    return SimplePut(key, value);
+}
+
+// See MapBasedGlobalLockImpl.h
+bool MapBasedGlobalLockImpl::Invalidate(const std::string &key) {
+    std::lock_guard<OptionalMutex> lock(_m);
+    CheckFlush();
+
+    Entry *entry = _backend.Find(key);
+    if (entry == nullptr) return false;
+    if (entry->generation != _generation) {
+        Remove(entry);
+        return false;
+    }
 
-    value = it->second.value;
-    _list.MakeTop(&it->second);
+    // Already invalidated entry keeps its stale value and lease
+    if (entry->invalid) return false;
+
+    InvalidateHot(entry);
+    entry->invalid = true;
+    entry->lease = 0;
+    entry->atime = CoarseNow();
+    _stale_items++;
+    _invalidations++;
     return true;
 }
 
+// See MapBasedGlobalLockImpl.h
+void MapBasedGlobalLockImpl::GetStats(const std::string &group, StatsList &stats) const {
+    if (group == "hotkeys") {
+        std::lock_guard<OptionalMutex> lock(_m);
+        stats.emplace_back("hot_samples", std::to_string(_sketch.Total()));
+        stats.emplace_back("hot_epoch", std::to_string(_hot_epoch.load(std::memory_order_relaxed)));
+        stats.emplace_back("hot_invalidations", std::to_string(_hot_invalidations));
+        for (auto &counter : _sketch.Top(HotKeys)) {
+            bool hot = std::binary_search(_hot_keys.begin(), _hot_keys.end(), counter.key);
+            stats.emplace_back("hotkey:" + counter.key, std::to_string(counter.count) + " " +
+                                                            std::to_string(counter.error) + (hot ? " hot" : ""));
+        }
+        return;
+    }
+    if (group == "keyspace") {
+        KeyspaceReport report(KeyspaceBigKeys, KeyspacePrefixes);
+        auto start = std::chrono::steady_clock::now();
+        size_t cursor = 0;
+        size_t steps = 0;
+        double sampled = 0;
+        do {
+            {
+                std::lock_guard<OptionalMutex> lock(_m);
+                CheckFlush();
+                uint32_t now = CoarseNow();
+                double from = HashIndex::ScanProgress(_keyspace_cursor);
+                cursor = _backend.Scan(_keyspace_cursor, KeyspaceStep, [this, &report, now](const Entry *entry) {
+                    if (!Stale(entry)) {
+                        report.Add(entry->key, entry->value.size(), now - entry->atime);
+                    }
+                });
+                _keyspace_cursor = cursor;
+
+                // Cursor goes back to 0 once the whole index is walked
+                sampled += (cursor == 0 ? 1.0 : HashIndex::ScanProgress(cursor)) - from;
+            }
+            steps++;
+            std::this_thread::yield();
+        } while (cursor != 0 && steps < KeyspaceSteps);
+
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        stats.emplace_back("keyspace_scan_steps", std::to_string(steps));
+        stats.emplace_back("keyspace_sample_ratio", std::to_string(sampled));
+        stats.emplace_back("keyspace_scan_usec",
+                           std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()));
+        report.Report(stats);
+        return;
+    }
+    if (!group.empty()) {
+        return;
+    }
+
+    {
+        std::lock_guard<OptionalMutex> lock(_m);
+        CheckFlush();
+        stats.emplace_back("curr_items", std::to_string(_backend.Size() - _stale_items));
+        stats.emplace_back("stale_items", std::to_string(_stale_items));
+        stats.emplace_back("flush_generation", std::to_string(_generation));
+        stats.emplace_back("bytes", std::to_string(_curr_size));
+        stats.emplace_back("index_buckets", std::to_string(_backend.Buckets()));
+        stats.emplace_back("eviction_policy", _policy_name);
+        _policy->GetStats(stats);
+        stats.emplace_back("limit_maxbytes", std::to_string(_max_size));
+        stats.emplace_back("low_watermark", std::to_string(_low_watermark));
+        stats.emplace_back("high_watermark", std::to_string(_high_watermark));
+        stats.emplace_back("maintainer_cycles", std::to_string(_maintainer_cycles));
+        stats.emplace_back("maintainer_evictions", std::to_string(_maintainer_evictions));
+        stats.emplace_back("inline_evictions", std::to_string(_inline_evictions));
+        _values.inspect([&stats](const Allocator::Buddy &buddy) {
+            stats.emplace_back("values_region", std::to_string(buddy.capacity()));
+            stats.emplace_back("values_region_allocated", std::to_string(buddy.allocated()));
+            stats.emplace_back("values_region_requested", std::to_string(buddy.requested()));
+            stats.emplace_back("values_region_largest_free", std::to_string(buddy.largest_free()));
+            stats.emplace_back("values_region_released", std::to_string(buddy.released()));
+            stats.emplace_back("values_internal_fragmentation", std::to_string(buddy.internal_fragmentation()));
+            stats.emplace_back("values_external_fragmentation", std::to_string(buddy.external_fragmentation()));
+        });
+        stats.emplace_back("values_region_overflows", std::to_string(_values.overflows()));
+        if (_ghosts) {
+            stats.emplace_back("ghost_items", std::to_string(_ghosts->Size()));
+            stats.emplace_back("ghost_sample_rate", std::to_string(size_t(1) << _ghost_sample_shift));
+            stats.emplace_back("ghost_misses", std::to_string(_ghost_misses));
+            for (size_t i = 0; i < 3; i++) {
+                stats.emplace_back(std::string("ghost_hits_") + GhostSizeNames[i],
+                                   std::to_string(_ghost_hits[i] << _ghost_sample_shift));
+            }
+        }
+        stats.emplace_back("invalidations", std::to_string(_invalidations));
+        stats.emplace_back("lease_grants", std::to_string(_lease_grants));
+        stats.emplace_back("lease_stale", std::to_string(_lease_stale));
+        stats.emplace_back("lease_waits", std::to_string(_lease_waits));
+        stats.emplace_back("lease_rejects", std::to_string(_lease_rejects));
+    }
+
+    if (HugePagesEnabled()) {
+        // Process wide and parses smaps, so collected without lock
+        HugePageUsage usage = GetHugePageUsage();
+        stats.emplace_back("huge_pages_mapped", std::to_string(usage.mapped));
+        stats.emplace_back("huge_pages_hugetlb", std::to_string(usage.hugetlb));
+        stats.emplace_back("huge_pages_transparent", std::to_string(usage.transparent));
+    }
+}
+
+// See MapBasedGlobalLockImpl.h
+void MapBasedGlobalLockImpl::FlushAll(uint32_t delay) {
+    std::lock_guard<OptionalMutex> lock(_m);
+    if (delay == 0) {
+        ApplyFlush();
+    } else {
+        _flush_at = std::chrono::steady_clock::now() + std::chrono::seconds(delay);
+        _flush_pending.store(true, std::memory_order_release);
+    }
+}
+
+// See MapBasedGlobalLockImpl.h
+size_t MapBasedGlobalLockImpl::Load(const std::string &path,
+                                    const std::function<bool(const std::string &)> &accept) {
+    DumpReader reader(path);
+    std::vector<size_t> offsets = reader.Offsets();
+
+    uint32_t generation;
+    {
+        std::lock_guard<OptionalMutex> lock(_m);
+        CheckFlush();
+        generation = _generation;
+    }
+
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min(threads, offsets.size() / LoadChunk + 1);
+    uint32_t now = CoarseNow();
+
+    // Build entries in parallel, skipped records are left null
+    std::vector<Entry *> entries(offsets.size(), nullptr);
+    auto build = [this, &reader, &offsets, &entries, &accept, threads, generation, now](size_t part) {
+        size_t from = offsets.size() / threads * part;
+        size_t to = part + 1 == threads ? offsets.size() : offsets.size() / threads * (part + 1);
+        for (size_t i = from; i < to; i++) {
+            DumpRecord record = reader.Read(offsets[i]);
+            if (record.exptime < 0 || size_t(record.key_len) + record.value_len > _max_size) {
+                continue;
+            }
+
+            Entry *entry = new Entry();
+            entry->key.assign(record.key, record.key_len);
+            if (accept && !accept(entry->key)) {
+                delete entry;
+                continue;
+            }
+            entry->value = Allocator::String(record.value, record.value_len, _values);
+            entry->hash = HashIndex::Hash(entry->key);
+            entry->generation = generation;
+            entry->atime = now;
+            entries[i] = entry;
+        }
+    };
+
+    std::vector<std::thread> builders;
+    for (size_t i = 1; i < threads; i++) {
+        builders.emplace_back(build, i);
+    }
+    build(0);
+    for (auto &builder : builders) {
+        builder.join();
+    }
+    entries.erase(std::remove(entries.begin(), entries.end(), nullptr), entries.end());
+
+    HashIndex index;
+    std::vector<Entry *> duplicates = index.BulkInsert(entries, threads);
+    std::unordered_set<Entry *> dropped(duplicates.begin(), duplicates.end());
+
+    // Records are in the order of use, so if dump doesn't fit the oldest ones are dropped
+    size_t size = 0;
+    size_t first = entries.size();
+    for (; first > 0; first--) {
+        Entry *entry = entries[first - 1];
+        if (dropped.count(entry) == 0) {
+            if (size + entry->key.size() + entry->value.size() > _max_size) {
+                break;
+            }
+            size += entry->key.size() + entry->value.size();
+        }
+    }
+    for (size_t i = 0; i < first; i++) {
+        if (dropped.count(entries[i]) == 0) {
+            index.Remove(entries[i]);
+        }
+        delete entries[i];
+    }
+
+    std::unique_ptr<EvictionPolicy> policy = MakeEvictionPolicy(_policy_name, _max_size);
+    for (size_t i = first; i < entries.size(); i++) {
+        if (dropped.count(entries[i]) == 0) {
+            policy->Insert(entries[i]);
+        } else {
+            delete entries[i];
+        }
+    }
+
+    // Make new content live, old one is released after the lock
+    size_t loaded;
+    bool notify;
+    {
+        std::lock_guard<OptionalMutex> lock(_m);
+        _backend.Swap(index);
+        _policy.swap(policy);
+        _curr_size = size;
+        loaded = _backend.Size();
+        notify = _curr_size > _high_watermark;
+
+        // Flush that happened during load applies to loaded entries as well
+        CheckFlush();
+        _stale_items = generation == _generation ? 0 : loaded;
+
+        _hot_keys.clear();
+        _hot_epoch.fetch_add(1, std::memory_order_release);
+    }
+
+    if (notify) {
+        _maintainer_cv.notify_one();
+    }
+    return loaded;
+}
+
 } // namespace Backend
 } // namespace Afina
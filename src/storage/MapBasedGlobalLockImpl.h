@@ -1,32 +1,96 @@
 #ifndef AFINA_STORAGE_MAP_BASED_GLOBAL_LOCK_IMPL_H
 #define AFINA_STORAGE_MAP_BASED_GLOBAL_LOCK_IMPL_H
 
-#include <unordered_map>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
 #include <mutex>
 #include <string>
-#include <functional>
+#include <thread>
+#include <vector>
 
 #include <afina/Storage.h>
+#include <afina/allocator/Buddy.h>
+#include <afina/allocator/Resource.h>
+#include "EvictionPolicy.h"
+#include "GhostList.h"
+#include "HashIndex.h"
 #include "LRUList.h"
+#include "OptionalMutex.h"
+#include "SpaceSaving.h"
 
 namespace Afina {
 namespace Backend {
 
 /**
  * # Map based implementation with global lock
+ * Lock could be disabled in case if instance is owned by a single thread, for example
+ * by the network worker in the shared-nothing mode
  *
+ * Index could be presized for the expected number of items, otherwise it grows incrementally,
+ * see HashIndex.h. Eviction policy is chosen per instance: "lru" or "arc", see EvictionPolicy.h
  *
+ * Once started, storage runs background maintainer: as soon as used memory goes above high watermark
+ * maintainer evicts least recently used entries in small batches until usage drops below low watermark.
+ * That way Put usually finds free room and inline eviction is only a fallback for bursts. Maintainer
+ * is not started for storage without lock
+ *
+ * Every HotSampleRate-th successful Get feeds the key into space-saving sketch. Keys taking a noticeable
+ * share of the sampled reads are marked hot: their values are copied into a small thread local replica on
+ * the next locked Get, and subsequent Gets from the same thread are served from the replica without taking
+ * the lock. Any write to a hot key bumps hot epoch which invalidates all replicas at once. Replica counts
+ * Gets it served, the next locked Get of the thread folds them into the sketch and into eviction policy,
+ * so replicated keys neither cool down nor age out. Replica serves HotFoldHits Gets at most in a row. Hot
+ * entries are also skipped by eviction as their replica reads refresh LRU position that late. Replicas are
+ * used only by storage with lock, see `stats hotkeys` for the current hot set
+ *
+ * FlushAll takes constant time: each entry is stamped with the storage generation it was written in and
+ * flush just increments generation. Entries of older generations are invisible, they are reclaimed once
+ * touched by a write or evicted as usual. Delayed flush is applied by the first operation after deadline,
+ * until then hot key replicas are bypassed.
+ *
+ * Load builds new index and list aside without lock, using several threads, and then swaps them with
+ * the current ones. If dump doesn't fit into max size, the most recent records are kept
+ *
+ * Leases are kept in the entry itself. The first LeaseGet that misses inserts a placeholder entry holding the
+ * lease token, concurrent misses find the lease and wait. Invalidate doesn't remove the entry, it keeps
+ * value as stale one for LeaseGrace seconds to be returned to clients waiting for refill. Invalidated
+ * entries and placeholders are invisible to everything but leases and are reclaimed like flushed ones.
+ *
+ * Optional ghost list remembers keys evicted within the last max size bytes. A miss on such key would have
+ * been a hit in a cache larger by the number of bytes evicted since that key, so stats report how many
+ * misses larger caches would have avoided, which gives miss ratio curve up to the double size.
+ *
+ * `stats keyspace` walks the index in small steps, releasing lock in between, so writers are delayed by one
+ * step at most. Each call walks KeyspaceSteps steps at most and the next one resumes from the same point, so
+ * large index is reported by samples and the share of the index walked is reported as well. Reads served
+ * from hot key replicas refresh access time of the entry once folded
  */
+class MapBasedGlobalLockImpl final : public Afina::Storage {
+public:
+    MapBasedGlobalLockImpl(size_t max_size = 1024, bool use_lock = true, size_t expected_items = 0,
+                           const std::string &policy = "lru");
+    ~MapBasedGlobalLockImpl();
 
-using BackendMap = std::unordered_map<std::reference_wrapper<const std::string>,
-        Entry&,
-        std::hash<std::string>,
-        std::equal_to<std::string>>;
+    // Implements Afina::Storage interface
+    void Start() override;
 
-class MapBasedGlobalLockImpl : public Afina::Storage {
-public:
-    MapBasedGlobalLockImpl(size_t max_size = 1024) : _max_size(max_size), _curr_size(0) {}
-    ~MapBasedGlobalLockImpl() {}
+    // Implements Afina::Storage interface
+    void Stop() override;
+
+    /**
+     * Configures maintainer watermarks in bytes, by default they are 80% and 90% of the
+     * max size
+     */
+    void SetWatermarks(size_t low, size_t high);
+
+    /**
+     * Turns on ghost list of evicted keys, so that misses which would have been hits in a larger cache
+     * are reported in stats. Only one of 2^sample_shift keys is tracked, hits are scaled accordingly
+     */
+    void EnableGhosts(bool enabled, size_t sample_shift = GhostSampleShift);
 
     // Implements Afina::Storage interface
     bool Put(const std::string &key, const std::string &value) override;
@@ -40,18 +104,195 @@ public:
     // Implements Afina::Storage interface
     bool Set(const std::string &key, const std::string &value) override;
 
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &data) override;
+
     // Implements Afina::Storage interface
     bool Delete(const std::string &key) override;
 
     // Implements Afina::Storage interface
     bool Get(const std::string &key, std::string &value) const override;
 
+    // Implements Afina::Storage interface
+    void GetStats(const std::string &group, StatsList &stats) const override;
+
+    // Implements Afina::Storage interface
+    void FlushAll(uint32_t delay) override;
+
+    // Implements Afina::Storage interface
+    LeaseStatus LeaseGet(const std::string &key, std::string &value, uint64_t &token) override;
+
+    // Implements Afina::Storage interface
+    bool LeaseSet(const std::string &key, const std::string &value, uint64_t token) override;
+
+    // Implements Afina::Storage interface
+    bool Invalidate(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    size_t Load(const std::string &path, const std::function<bool(const std::string &)> &accept) override;
+
 private:
+    // How often maintainer checks memory usage without being notified
+    static constexpr std::chrono::milliseconds MaintainerPeriod{100};
+
+    // Maximum number of entries maintainer evicts per lock acquisition
+    static const size_t MaintainerBatch = 64;
+
+    // One of that many successful Gets is sampled by hot keys sketch
+    static const size_t HotSampleRate = 8;
+
+    // Number of counters in hot keys sketch
+    static const size_t HotSketchSize = 64;
+
+    // Maximum number of hot keys, also limits size of each replica
+    static const size_t HotKeys = 8;
+
+    // Hot set is recomputed each that many samples
+    static const size_t HotRefresh = 256;
+
+    // Key is hot if it takes at least 1/HotShare of sampled Gets, but no less than HotMinCount samples
+    static const size_t HotShare = 20;
+    static const size_t HotMinCount = 16;
+
+    // Values larger than that are never replicated
+    static const size_t HotValueLimit = 4096;
+
+    // Replica of a thread serves that many Gets at most before they are folded into the storage
+    static const size_t HotFoldHits = 256;
+
+    // Minimal number of records per Load thread
+    static const size_t LoadChunk = 4096;
+
+    // Lease is considered abandoned after that many seconds and could be granted again
+    static const uint32_t LeaseTimeout = 10;
+
+    // Invalidated value is served as stale one for that many seconds
+    static const uint32_t LeaseGrace = 10;
+
+    // Ghost list tracks one of 2^GhostSampleShift keys by default
+    static const size_t GhostSampleShift = 3;
+
+    // Values of that many bytes and larger are placed into the buddy region, storage smaller than
+    // LargeValueRegions of them has no region and keeps all values in the heap
+    static const size_t LargeValue = 64 * 1024;
+    static const size_t LargeValueRegions = 4;
+
+    // Free blocks of the buddy region that merge into that many bytes give their pages back to the system
+    static const size_t LargeValueRelease = 16 * LargeValue;
+
+    // Keyspace scan visits that many index buckets per lock acquisition, and does that many steps per call
+    static const size_t KeyspaceStep = 256;
+    static const size_t KeyspaceSteps = 64;
+
+    // Number of the largest values and of the top prefixes in keyspace report
+    static const size_t KeyspaceBigKeys = 10;
+    static const size_t KeyspacePrefixes = 10;
+
+    // Removes least recently used entry, lock must be held
+    void Evict();
+
+    // Removes entry from index and eviction policy and releases it, lock must be held
+    void Remove(Entry *entry, bool evicted = false);
+
+    // Returns entry for the key unless it is absent or stale, stale one is reclaimed. Lock must be held
+    Entry *FindLive(const std::string &key, size_t hash);
+
+    // True if entry is invalidated by flush or by Invalidate, lock must be held
+    bool Stale(const Entry *entry) const { return entry->generation != _generation || entry->invalid; }
+
+    // Applies delayed flush once its deadline passes, lock must be held
+    void CheckFlush() const;
+
+    // Makes all existing entries stale, lock must be held
+    void ApplyFlush() const;
+
+    // Registers key of the given number of successful Gets in hot keys sketch, lock must be held
+    void SampleHot(const std::string &key, size_t reads = 1) const;
+
+    // Recomputes hot set from the sketch, lock must be held
+    void RefreshHot() const;
+
+    // Copies value of hot key into replica of the calling thread, lock must be held
+    void Replicate(const std::string &key, const std::string &value) const;
+
+    // Registers Gets served by replica of the calling thread as if they were done under lock: samples them
+    // and refreshes entries in eviction policy. Lock must be held
+    void FoldReplicaHits() const;
+
+    // Invalidates all replicas if entry is hot, must be called on every change of entry, lock must be held
+    void InvalidateHot(const Entry *entry);
+
+    // Maintainer thread body
+    void Maintain();
+
     size_t _max_size;
     size_t _curr_size;
-    BackendMap _backend;
-    mutable LRUList _list;
-    mutable std::mutex _m;
+    mutable HashIndex _backend;
+
+    // Region of large values sized as the storage, pages are committed once they hold a value and given back
+    // once free blocks merge up to LargeValueRelease. Values are released by entries, so the region must
+    // outlive policy
+    std::unique_ptr<char[]> _region;
+    Allocator::Buddy _buddy;
+    Allocator::BuddyResource _values;
+
+    // Policy owns entries, name is kept to create the new one on load
+    const std::string _policy_name;
+    mutable std::unique_ptr<EvictionPolicy> _policy;
+
+    mutable OptionalMutex _m;
+
+    // Maintainer configuration, protected by _m
+    size_t _low_watermark;
+    size_t _high_watermark;
+
+    // Eviction statistics, protected by _m
+    size_t _inline_evictions;
+    size_t _maintainer_cycles;
+    size_t _maintainer_evictions;
+
+    // Unique instance id, replicas are bound to it rather than to the address
+    const uint64_t _id;
+
+    // Hot keys detection state, protected by _m
+    mutable SpaceSaving _sketch;
+    mutable size_t _hot_ticks;
+    mutable std::vector<std::string> _hot_keys;
+    size_t _hot_invalidations;
+
+    // Replica is valid only while epoch it was filled at is current. Changed under _m only,
+    // but read without lock
+    mutable std::atomic<uint64_t> _hot_epoch;
+
+    // Flush state, protected by _m. Pending flag is read without lock to bypass replicas
+    mutable uint32_t _generation;
+    mutable size_t _stale_items;
+    mutable std::atomic<bool> _flush_pending;
+    mutable std::chrono::steady_clock::time_point _flush_at;
+
+    // Leases state and statistics, protected by _m
+    uint32_t _lease_counter;
+    size_t _lease_grants;
+    size_t _lease_stale;
+    size_t _lease_waits;
+    size_t _lease_rejects;
+    size_t _invalidations;
+
+    // Ghost list and statistics of Get misses, protected by _m. No ghost list if disabled. Hits are
+    // counted for each of cache sizes reported
+    std::unique_ptr<GhostList> _ghosts;
+    size_t _ghost_sample_shift;
+    mutable size_t _ghost_misses;
+    mutable size_t _ghost_hits[3];
+
+    // Position keyspace scan continues from, protected by _m
+    mutable size_t _keyspace_cursor;
+
+    // Maintainer thread and its wake up infrastructure
+    std::thread _maintainer;
+    std::mutex _maintainer_m;
+    std::condition_variable _maintainer_cv;
+    bool _maintainer_stop;
 };
 
 } // namespace Backend
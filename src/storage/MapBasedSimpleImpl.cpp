@@ -0,0 +1,318 @@
+#include "MapBasedSimpleImpl.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <afina/allocator/Error.h>
+
+namespace Afina {
+namespace Backend {
+
+namespace {
+
+// Upper bound of the allocator overhead per value: block header, alignment and descriptor
+const size_t BlockOverhead = 64;
+
+// Share of free memory in holes that makes writes compact the region
+const double CompactThreshold = 0.25;
+
+// Bounds of a single compaction step
+const size_t CompactStepBytes = 64 * 1024;
+const std::chrono::microseconds CompactStepTime(100);
+
+// Values of this size and larger are copied out without holding the lock
+const size_t PinSize = 16 * 1024;
+
+} // namespace
+
+// See MapBasedSimpleImpl.h
+MapBasedSimpleImpl::MapBasedSimpleImpl(size_t max_size, bool use_lock)
+    : _max_size(max_size), _region(new char[max_size]), _m(use_lock), _allocator(_region.get(), max_size),
+      _pool("map_simple"), _index(Index::allocator_type(_pool)), _lru(LRU::allocator_type(_pool)), _curr_size(0),
+      _generation(0), _stale_items(0), _flush_pending(false), _evictions(0), _defrags(0) {}
+
+// See MapBasedSimpleImpl.h
+MapBasedSimpleImpl::~MapBasedSimpleImpl() {}
+
+// See MapBasedSimpleImpl.h
+bool MapBasedSimpleImpl::Put(const std::string &key, const std::string &value) {
+    std::lock_guard<OptionalMutex> lock(_m);
+    CheckFlush();
+
+    auto it = FindLive(key);
+    return it == _index.end() ? Insert(key, value) : Update(it, value);
+}
+
+// See MapBasedSimpleImpl.h
+bool MapBasedSimpleImpl::PutIfAbsent(const std::string &key, const std::string &value) {
+    std::lock_guard<OptionalMutex> lock(_m);
+    CheckFlush();
+    return FindLive(key) == _index.end() && Insert(key, value);
+}
+
+// See MapBasedSimpleImpl.h
+bool MapBasedSimpleImpl::Set(const std::string &key, const std::string &value) {
+    std::lock_guard<OptionalMutex> lock(_m);
+    CheckFlush();
+
+    auto it = FindLive(key);
+    return it != _index.end() && Update(it, value);
+}
+
+// See MapBasedSimpleImpl.h
+bool MapBasedSimpleImpl::Append(const std::string &key, const std::string &data) {
+    std::lock_guard<OptionalMutex> lock(_m);
+    CheckFlush();
+
+    auto it = FindLive(key);
+    if (it == _index.end()) {
+        return false;
+    }
+
+    Item &item = it->second;
+    size_t size = item.size + data.size();
+    if (size + BlockOverhead > _max_size) {
+        return false;
+    }
+
+    if (size > item.capacity) {
+        size_t capacity = std::min(std::max(size, item.capacity * 2), _max_size - BlockOverhead);
+        if (!Reserve(it, capacity, item.size) && !Reserve(it, size, item.size)) {
+            return false;
+        }
+    }
+
+    // Pinned value is read up to its size at the time of pin, so the rest of the block could be written
+    std::memcpy(static_cast<char *>(item.value.get()) + item.size, data.data(), data.size());
+    _curr_size += data.size();
+    item.size = size;
+    _lru.splice(_lru.begin(), _lru, item.lru);
+    Compact();
+    return true;
+}
+
+// See MapBasedSimpleImpl.h
+bool MapBasedSimpleImpl::Delete(const std::string &key) {
+    std::lock_guard<OptionalMutex> lock(_m);
+    CheckFlush();
+
+    auto it = FindLive(key);
+    if (it == _index.end()) {
+        return false;
+    }
+    Remove(it);
+    Compact();
+    return true;
+}
+
+// See MapBasedSimpleImpl.h
+bool MapBasedSimpleImpl::Get(const std::string &key, std::string &value) const {
+    std::unique_lock<OptionalMutex> lock(_m);
+    CheckFlush();
+
+    auto it = FindLive(key);
+    if (it == _index.end()) {
+        return false;
+    }
+
+    const Item &item = it->second;
+    _lru.splice(_lru.begin(), _lru, item.lru);
+    if (item.size < PinSize || !_m.enabled()) {
+        value.assign(static_cast<const char *>(item.value.get()), item.size);
+        return true;
+    }
+
+    // Block stays in place and keeps its content until unpin, even if item is updated or removed meanwhile
+    Allocator::Pointer pinned = item.value;
+    size_t size = item.size;
+    _allocator.pin(pinned);
+    const char *data = static_cast<const char *>(pinned.get());
+    lock.unlock();
+
+    value.assign(data, size);
+
+    lock.lock();
+    _allocator.unpin(pinned);
+    return true;
+}
+
+// See MapBasedSimpleImpl.h
+void MapBasedSimpleImpl::GetStats(const std::string &group, StatsList &stats) const {
+    if (group == "allocator") {
+        std::lock_guard<OptionalMutex> lock(_m);
+        _allocator.stats().report("map_simple.region", stats);
+        return;
+    }
+    if (!group.empty()) {
+        return;
+    }
+
+    std::lock_guard<OptionalMutex> lock(_m);
+    CheckFlush();
+    stats.emplace_back("curr_items", std::to_string(_index.size() - _stale_items));
+    stats.emplace_back("stale_items", std::to_string(_stale_items));
+    stats.emplace_back("bytes", std::to_string(_curr_size));
+    stats.emplace_back("limit_maxbytes", std::to_string(_max_size));
+    stats.emplace_back("evictions", std::to_string(_evictions));
+    stats.emplace_back("index_bytes", std::to_string(_pool.bytes()));
+    stats.emplace_back("region_used", std::to_string(_allocator.used()));
+    stats.emplace_back("region_available", std::to_string(_allocator.available()));
+    stats.emplace_back("region_defrags", std::to_string(_defrags));
+    stats.emplace_back("region_fragmentation", std::to_string(_allocator.fragmentation()));
+    stats.emplace_back("region_moved_bytes", std::to_string(_allocator.moved()));
+    stats.emplace_back("region_defrag_steps", std::to_string(_allocator.steps()));
+    stats.emplace_back("region_pause_max_us", std::to_string(_allocator.pause_max()));
+    stats.emplace_back("region_pause_total_us", std::to_string(_allocator.pause_total()));
+}
+
+// See MapBasedSimpleImpl.h
+void MapBasedSimpleImpl::FlushAll(uint32_t delay) {
+    std::lock_guard<OptionalMutex> lock(_m);
+    if (delay == 0) {
+        ApplyFlush();
+    } else {
+        _flush_pending = true;
+        _flush_at = std::chrono::steady_clock::now() + std::chrono::seconds(delay);
+    }
+}
+
+// See MapBasedSimpleImpl.h
+bool MapBasedSimpleImpl::Insert(const std::string &key, const std::string &value) {
+    if (value.size() + BlockOverhead > _max_size) {
+        return false;
+    }
+
+    auto it = _index.emplace(key, Item()).first;
+    it->second.size = 0;
+    it->second.capacity = 0;
+    it->second.generation = _generation;
+    if (!Store(it, value)) {
+        _index.erase(it);
+        return false;
+    }
+
+    it->second.lru = _lru.insert(_lru.begin(), &it->first);
+    _curr_size += key.size();
+    return true;
+}
+
+// See MapBasedSimpleImpl.h
+bool MapBasedSimpleImpl::Update(Index::iterator it, const std::string &value) {
+    if (value.size() + BlockOverhead > _max_size || !Store(it, value)) {
+        return false;
+    }
+    _lru.splice(_lru.begin(), _lru, it->second.lru);
+    return true;
+}
+
+// See MapBasedSimpleImpl.h
+bool MapBasedSimpleImpl::Store(Index::iterator it, const std::string &value) {
+    if (!Reserve(it, value.size(), 0)) {
+        return false;
+    }
+
+    Item &item = it->second;
+    std::memcpy(item.value.get(), value.data(), value.size());
+    _curr_size = _curr_size - item.size + value.size();
+    item.size = value.size();
+    Compact();
+    return true;
+}
+
+// See MapBasedSimpleImpl.h
+bool MapBasedSimpleImpl::Reserve(Index::iterator it, size_t capacity, size_t keep) {
+    Item &item = it->second;
+
+    // Pinned value is being read, new one goes to a separate block
+    Allocator::Pointer block = item.value;
+    bool replace = _allocator.pinned(block);
+    if (replace) {
+        block = Allocator::Pointer();
+    }
+
+    bool defragged = false;
+    for (;;) {
+        try {
+            _allocator.realloc(block, capacity);
+            break;
+        } catch (Allocator::AllocError &) {
+        }
+
+        // Enough memory in total, it is just fragmented
+        if (!defragged && _allocator.available() >= capacity + BlockOverhead) {
+            _allocator.defrag();
+            _defrags++;
+            defragged = true;
+            continue;
+        }
+
+        // Evict the least recently used value, but not the one being stored
+        auto victim = _lru.rbegin();
+        if (victim != _lru.rend() && *victim == &it->first) {
+            victim++;
+        }
+        if (victim == _lru.rend()) {
+            if (replace) {
+                _allocator.free(block);
+            }
+            return false;
+        }
+        auto evicted = _index.find(**victim);
+        _evictions += evicted->second.generation == _generation;
+        Remove(evicted);
+        defragged = false;
+    }
+
+    if (replace) {
+        std::memcpy(block.get(), item.value.get(), keep);
+        _allocator.free(item.value);
+    }
+    item.value = block;
+    item.capacity = capacity;
+    return true;
+}
+
+// See MapBasedSimpleImpl.h
+MapBasedSimpleImpl::Index::iterator MapBasedSimpleImpl::FindLive(const std::string &key) const {
+    auto it = _index.find(key);
+    if (it != _index.end() && it->second.generation != _generation) {
+        Remove(it);
+        return _index.end();
+    }
+    return it;
+}
+
+// See MapBasedSimpleImpl.h
+void MapBasedSimpleImpl::Remove(Index::iterator it) const {
+    if (it->second.generation != _generation) {
+        _stale_items--;
+    }
+    _allocator.free(it->second.value);
+    _curr_size -= it->first.size() + it->second.size;
+    _lru.erase(it->second.lru);
+    _index.erase(it);
+}
+
+// See MapBasedSimpleImpl.h
+void MapBasedSimpleImpl::Compact() {
+    if (_allocator.fragmentation() > CompactThreshold) {
+        _allocator.defrag_step(CompactStepBytes, CompactStepTime);
+    }
+}
+
+// See MapBasedSimpleImpl.h
+void MapBasedSimpleImpl::CheckFlush() const {
+    if (_flush_pending && std::chrono::steady_clock::now() >= _flush_at) {
+        ApplyFlush();
+    }
+}
+
+// See MapBasedSimpleImpl.h
+void MapBasedSimpleImpl::ApplyFlush() const {
+    _generation++;
+    _stale_items = _index.size();
+    _flush_pending = false;
+}
+
+} // namespace Backend
+} // namespace Afina
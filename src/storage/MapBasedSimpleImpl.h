@@ -0,0 +1,153 @@
+#ifndef AFINA_STORAGE_MAP_BASED_SIMPLE_IMPL_H
+#define AFINA_STORAGE_MAP_BASED_SIMPLE_IMPL_H
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <afina/Storage.h>
+#include <afina/allocator/Pointer.h>
+#include <afina/allocator/Resource.h>
+#include <afina/allocator/Simple.h>
+#include "KeyHash.h"
+#include "OptionalMutex.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Map based implementation with values in a fixed region
+ * Values are kept in a single region of max size bytes allocated once at construction and managed by
+ * Allocator::Simple, so memory taken by values is bounded by the region and never fragments. Index and keys
+ * live in the slab pool of the storage, which is shown as "map_simple" in "stats pools". Index is hashed by
+ * the seeded KeyHash, so client can't flood it with colliding keys.
+ *
+ * Once new value doesn't fit, storage compacts the region if free memory is enough in total, otherwise evicts
+ * least recently used values until it is. Existing values are resized in place by realloc where possible.
+ * Append reserves twice the room the value needs, so that value appended to over and over again is moved
+ * once per doubling of its size at most.
+ *
+ * Compaction of the whole region is a long pause, so it is mostly done incrementally: every write or delete
+ * that leaves region fragmented enough moves a bounded number of bytes. Large values are copied out by Get
+ * without holding the lock, value is pinned meanwhile so compaction doesn't move it and writers replace it
+ * with a new block instead of overwriting.
+ *
+ * FlushAll takes constant time: items are stamped with the generation they were written in and flush just
+ * increments generation. Items of older generations are invisible, they are reclaimed once touched or evicted
+ * as usual.
+ *
+ * Global lock that could be disabled for storage owned by a single thread
+ */
+class MapBasedSimpleImpl : public Afina::Storage {
+public:
+    MapBasedSimpleImpl(size_t max_size = 1024, bool use_lock = true);
+    ~MapBasedSimpleImpl();
+
+    // Implements Afina::Storage interface
+    bool Put(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool PutIfAbsent(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Set(const std::string &key, const std::string &value) override;
+
+    // Implements Afina::Storage interface
+    bool Append(const std::string &key, const std::string &data) override;
+
+    // Implements Afina::Storage interface
+    bool Delete(const std::string &key) override;
+
+    // Implements Afina::Storage interface
+    bool Get(const std::string &key, std::string &value) const override;
+
+    // Implements Afina::Storage interface
+    void GetStats(const std::string &group, StatsList &stats) const override;
+
+    // Implements Afina::Storage interface
+    void FlushAll(uint32_t delay) override;
+
+private:
+    typedef std::list<const std::string *, Allocator::StlAllocator<const std::string *>> LRU;
+
+    struct Item {
+        Allocator::Pointer value;
+        size_t size;
+
+        // Number of bytes block could hold, more than size once room is reserved by Append
+        size_t capacity;
+
+        // Position in the recency list, which points to the key in the index
+        LRU::iterator lru;
+
+        // Storage generation item was written in, item of the older one is flushed
+        uint32_t generation;
+    };
+
+    typedef std::unordered_map<std::string, Item, KeyHasher, std::equal_to<std::string>,
+                               Allocator::StlAllocator<std::pair<const std::string, Item>>>
+        Index;
+
+    // Adds new key, evicting others if needed
+    bool Insert(const std::string &key, const std::string &value);
+
+    // Replaces value of the existing key
+    bool Update(Index::iterator it, const std::string &value);
+
+    // Stores value into the item, which could be a new one with empty pointer. Returns false if value
+    // couldn't fit even into the empty region, in a such case item is left untouched
+    bool Store(Index::iterator it, const std::string &value);
+
+    // Resizes block of the item to hold capacity bytes keeping the first keep bytes of the value, compacting
+    // the region or evicting others if needed. Returns false if block couldn't fit even into the empty
+    // region, in a such case item is left untouched
+    bool Reserve(Index::iterator it, size_t capacity, size_t keep);
+
+    // Returns item for the key unless it is absent or flushed, flushed one is reclaimed
+    Index::iterator FindLive(const std::string &key) const;
+
+    // Removes item from the index and releases its value
+    void Remove(Index::iterator it) const;
+
+    // Makes a bounded compaction step if region is fragmented
+    void Compact();
+
+    // Applies pending delayed flush once its deadline passed
+    void CheckFlush() const;
+
+    // Makes all existing items flushed
+    void ApplyFlush() const;
+
+    const size_t _max_size;
+    std::unique_ptr<char[]> _region;
+
+    mutable OptionalMutex _m;
+    mutable Allocator::Simple _allocator;
+
+    // Nodes of the index and the recency list
+    Allocator::SlabResource _pool;
+
+    mutable Index _index;
+    mutable LRU _lru;
+
+    // Size of keys and values stored
+    mutable size_t _curr_size;
+
+    // Flush state, items of older generations are flushed but not reclaimed yet
+    mutable uint32_t _generation;
+    mutable size_t _stale_items;
+    mutable bool _flush_pending;
+    mutable std::chrono::steady_clock::time_point _flush_at;
+
+    size_t _evictions;
+    size_t _defrags;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_MAP_BASED_SIMPLE_IMPL_H
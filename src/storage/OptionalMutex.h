@@ -0,0 +1,40 @@
+#ifndef AFINA_STORAGE_OPTIONAL_MUTEX_H
+#define AFINA_STORAGE_OPTIONAL_MUTEX_H
+
+#include <mutex>
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Mutex that could be switched off
+ * Satisfies BasicLockable, so could be used with std::lock_guard. Once disabled all operations
+ * are noop, that is used by storages owned by a single thread, such as per worker partitions
+ */
+class OptionalMutex {
+public:
+    OptionalMutex(bool enabled = true) : _enabled(enabled) {}
+
+    void lock() {
+        if (_enabled) {
+            _m.lock();
+        }
+    }
+
+    void unlock() {
+        if (_enabled) {
+            _m.unlock();
+        }
+    }
+
+    bool enabled() const { return _enabled; }
+
+private:
+    const bool _enabled;
+    std::mutex _m;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_OPTIONAL_MUTEX_H
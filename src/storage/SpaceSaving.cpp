@@ -0,0 +1,96 @@
+#include "SpaceSaving.h"
+
+#include <algorithm>
+
+namespace Afina {
+namespace Backend {
+
+// See SpaceSaving.h
+void SpaceSaving::Add(const std::string &key, uint64_t count) {
+    _total += count;
+
+    auto it = _positions.find(key);
+    if (it != _positions.end()) {
+        _heap[it->second].count += count;
+        SiftDown(it->second);
+        return;
+    }
+
+    if (_heap.size() < _capacity) {
+        Counter counter = {key, count, 0};
+        _heap.push_back(counter);
+        _positions[key] = _heap.size() - 1;
+        SiftUp(_heap.size() - 1);
+        return;
+    }
+
+    // Replace the least frequent key
+    Counter &min = _heap[0];
+    _positions.erase(min.key);
+    min.key = key;
+    min.error = min.count;
+    min.count += count;
+    _positions[key] = 0;
+    SiftDown(0);
+}
+
+// See SpaceSaving.h
+std::vector<SpaceSaving::Counter> SpaceSaving::Top(size_t n) const {
+    std::vector<Counter> result(_heap);
+    std::sort(result.begin(), result.end(), [](const Counter &a, const Counter &b) { return a.count > b.count; });
+    if (result.size() > n) {
+        result.resize(n);
+    }
+    return result;
+}
+
+// See SpaceSaving.h
+void SpaceSaving::Decay() {
+    // Monotone transformation, heap order is preserved
+    for (auto &counter : _heap) {
+        counter.count /= 2;
+        counter.error /= 2;
+    }
+    _total /= 2;
+}
+
+// See SpaceSaving.h
+void SpaceSaving::SiftUp(size_t pos) {
+    while (pos > 0) {
+        size_t parent = (pos - 1) / 2;
+        if (_heap[parent].count <= _heap[pos].count) {
+            break;
+        }
+        Swap(parent, pos);
+        pos = parent;
+    }
+}
+
+// See SpaceSaving.h
+void SpaceSaving::SiftDown(size_t pos) {
+    while (true) {
+        size_t min = pos;
+        size_t left = 2 * pos + 1, right = 2 * pos + 2;
+        if (left < _heap.size() && _heap[left].count < _heap[min].count) {
+            min = left;
+        }
+        if (right < _heap.size() && _heap[right].count < _heap[min].count) {
+            min = right;
+        }
+        if (min == pos) {
+            break;
+        }
+        Swap(min, pos);
+        pos = min;
+    }
+}
+
+// See SpaceSaving.h
+void SpaceSaving::Swap(size_t a, size_t b) {
+    std::swap(_heap[a], _heap[b]);
+    _positions[_heap[a].key] = a;
+    _positions[_heap[b].key] = b;
+}
+
+} // namespace Backend
+} // namespace Afina
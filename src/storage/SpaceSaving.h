@@ -0,0 +1,74 @@
+#ifndef AFINA_STORAGE_SPACE_SAVING_H
+#define AFINA_STORAGE_SPACE_SAVING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "KeyHash.h"
+
+namespace Afina {
+namespace Backend {
+
+/**
+ * # Space-saving sketch
+ * Streaming top-k estimator that uses fixed number of counters. Once all counters are taken, a new
+ * key replaces the one with the minimal count and inherits that count as possible overestimation.
+ * Any key whose real frequency is above total/capacity is guaranteed to be tracked.
+ *
+ * Counters are kept in a min-heap so each update costs O(log capacity). Not thread safe
+ */
+class SpaceSaving {
+public:
+    struct Counter {
+        std::string key;
+
+        // Estimated number of occurrences, never less than real one
+        uint64_t count;
+
+        // Maximum overestimation of the count
+        uint64_t error;
+    };
+
+    SpaceSaving(size_t capacity) : _capacity(capacity), _total(0) {}
+
+    /**
+     * Registers count more occurrences of the key
+     */
+    void Add(const std::string &key, uint64_t count = 1);
+
+    /**
+     * Returns up to n keys with the highest counts, most frequent first
+     */
+    std::vector<Counter> Top(size_t n) const;
+
+    /**
+     * Halves all counters, so sketch follows changes of the stream instead of
+     * accumulating the whole history
+     */
+    void Decay();
+
+    // Number of occurrences registered since last decay (halved on decay too)
+    uint64_t Total() const { return _total; }
+
+private:
+    void SiftUp(size_t pos);
+    void SiftDown(size_t pos);
+    void Swap(size_t a, size_t b);
+
+    const size_t _capacity;
+    uint64_t _total;
+
+    // Min-heap by count
+    std::vector<Counter> _heap;
+
+    // Position of each tracked key in the heap, keys come from clients so hash is seeded
+    std::unordered_map<std::string, size_t, KeyHasher> _positions;
+};
+
+} // namespace Backend
+} // namespace Afina
+
+#endif // AFINA_STORAGE_SPACE_SAVING_H
@@ -0,0 +1,236 @@
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <afina/allocator/Buddy.h>
+#include <afina/allocator/Error.h>
+#include <afina/allocator/Resource.h>
+
+using namespace std;
+using namespace Afina::Allocator;
+
+namespace {
+
+// Region of 64 pages of 4K and room for the page table
+const size_t RegionSize = 64 * 4096 + 64 * 16 + 4096;
+
+} // namespace
+
+TEST(BuddyTest, SplitMerge) {
+    static char region[RegionSize];
+    Buddy buddy(region, sizeof(region));
+    ASSERT_EQ(buddy.capacity(), 64 * 4096u);
+    EXPECT_EQ(buddy.largest_free(), 64 * 4096u);
+
+    char *a = static_cast<char *>(buddy.alloc(1));
+    char *b = static_cast<char *>(buddy.alloc(4096));
+    char *c = static_cast<char *>(buddy.alloc(5000));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(a) % 4096, 0u);
+    EXPECT_EQ(b, a + 4096);
+    EXPECT_EQ(c, a + 2 * 4096);
+    EXPECT_EQ(buddy.allocated(), 4 * 4096u);
+    EXPECT_EQ(buddy.requested(), 1 + 4096 + 5000u);
+    EXPECT_EQ(buddy.live(), 3u);
+    EXPECT_EQ(buddy.largest_free(), 32 * 4096u);
+
+    // Block merges with its buddy only
+    buddy.free(b);
+    buddy.free(c);
+    EXPECT_EQ(buddy.largest_free(), 32 * 4096u);
+    EXPECT_EQ(buddy.alloc(2 * 4096), c);
+    buddy.free(c);
+    buddy.free(a);
+    EXPECT_EQ(buddy.live(), 0u);
+    EXPECT_EQ(buddy.largest_free(), 64 * 4096u);
+    EXPECT_EQ(buddy.alloc(64 * 4096), a);
+}
+
+TEST(BuddyTest, Release) {
+    static char region[RegionSize];
+    Buddy buddy(region, sizeof(region), 4096, 8 * 4096);
+
+    char *d = static_cast<char *>(buddy.alloc(32 * 4096));
+    char *e = static_cast<char *>(buddy.alloc(4 * 4096));
+    char *a = static_cast<char *>(buddy.alloc(4096));
+    std::memset(e, 'x', 4 * 4096);
+    std::memset(a, 'x', 4096);
+
+    // Block merges up to 4 pages only, pages stay
+    buddy.free(a);
+    EXPECT_EQ(buddy.released(), 0u);
+
+    // Second half of the area merges and is released, then the whole area
+    buddy.free(e);
+    EXPECT_EQ(buddy.released(), 32 * 4096u);
+    buddy.free(d);
+    EXPECT_EQ(buddy.released(), 96 * 4096u);
+
+    // Released pages are zero filled once committed again
+    char *b = static_cast<char *>(buddy.alloc(64 * 4096));
+    EXPECT_EQ(b + 32 * 4096, e);
+    EXPECT_EQ(e[0], 0);
+    EXPECT_EQ(e[4 * 4096 - 1], 0);
+    buddy.free(b);
+}
+
+TEST(BuddyTest, Exhaustion) {
+    static char region[RegionSize];
+    Buddy buddy(region, sizeof(region));
+
+    vector<void *> blocks;
+    for (int i = 0; i < 8; i++) {
+        blocks.push_back(buddy.alloc(8 * 4096));
+    }
+    EXPECT_EQ(buddy.available(), 0u);
+    try {
+        buddy.alloc(1);
+        FAIL() << "Allocation must fail";
+    } catch (AllocError &e) {
+        EXPECT_EQ(e.getType(), AllocErrorType::NoMemory);
+    }
+    EXPECT_THROW(buddy.alloc(65 * 4096), AllocError);
+
+    for (void *p : blocks) {
+        buddy.free(p);
+    }
+    EXPECT_EQ(buddy.available(), 64 * 4096u);
+}
+
+TEST(BuddyTest, InvalidFree) {
+    static char region[RegionSize];
+    Buddy buddy(region, sizeof(region));
+
+    char *p = static_cast<char *>(buddy.alloc(3 * 4096));
+    EXPECT_THROW(buddy.free(p + 1), AllocError);
+    EXPECT_THROW(buddy.free(p + 4096), AllocError);
+    EXPECT_THROW(buddy.free(region), AllocError);
+    buddy.free(nullptr);
+    buddy.free(p);
+    try {
+        buddy.free(p);
+        FAIL() << "Double free must fail";
+    } catch (AllocError &e) {
+        EXPECT_EQ(e.getType(), AllocErrorType::InvalidFree);
+    }
+}
+
+TEST(BuddyTest, Fragmentation) {
+    static char region[RegionSize];
+    Buddy buddy(region, sizeof(region));
+    EXPECT_EQ(buddy.internal_fragmentation(), 0);
+    EXPECT_EQ(buddy.external_fragmentation(), 0);
+
+    // Every other block of 4 pages stays, so no free block is larger than 4 pages
+    vector<void *> blocks;
+    for (int i = 0; i < 16; i++) {
+        blocks.push_back(buddy.alloc(3 * 4096));
+    }
+    for (int i = 0; i < 16; i += 2) {
+        buddy.free(blocks[i]);
+    }
+    EXPECT_DOUBLE_EQ(buddy.internal_fragmentation(), 0.25);
+    EXPECT_EQ(buddy.largest_free(), 4 * 4096u);
+    EXPECT_DOUBLE_EQ(buddy.external_fragmentation(), 1 - 1.0 / 8);
+
+    string dump = buddy.dump();
+    EXPECT_NE(dump.find("live 8\n"), string::npos);
+    EXPECT_NE(dump.find("free_blocks_16384 8\n"), string::npos);
+}
+
+TEST(BuddyTest, Churn) {
+    const size_t size = 1024 * 4096;
+    vector<char> region(size + 1024 * 16 + 4096);
+    Buddy buddy(region.data(), region.size());
+    ASSERT_EQ(buddy.capacity(), size);
+
+    mt19937 gen(42);
+    uniform_int_distribution<size_t> sizes(1, 64 * 4096);
+    map<char *, size_t> live;
+    for (int i = 0; i < 20000; i++) {
+        if (live.empty() || gen() % 2 == 0) {
+            size_t n = sizes(gen);
+            char *p;
+            try {
+                p = static_cast<char *>(buddy.alloc(n));
+            } catch (AllocError &) {
+                continue;
+            }
+            ASSERT_TRUE(buddy.contains(p));
+            memset(p, n & 0xff, n);
+            auto next = live.lower_bound(p);
+            if (next != live.end()) {
+                ASSERT_GE(next->first, p + n);
+            }
+            if (next != live.begin()) {
+                auto prev = std::prev(next);
+                ASSERT_LE(prev->first + prev->second, p);
+            }
+            live[p] = n;
+        } else {
+            auto it = live.begin();
+            advance(it, gen() % live.size());
+            ASSERT_EQ(it->first[it->second - 1], char(it->second & 0xff));
+            buddy.free(it->first);
+            live.erase(it);
+        }
+    }
+
+    for (auto &block : live) {
+        buddy.free(block.first);
+    }
+    EXPECT_EQ(buddy.allocated(), 0u);
+    EXPECT_EQ(buddy.largest_free(), size);
+}
+
+TEST(BuddyTest, Resource) {
+    static char region[RegionSize];
+    Buddy buddy(region, sizeof(region));
+    BuddyResource resource("test.buddy", buddy, 4096);
+    StlAllocator<char> alloc(resource);
+
+    String small("small", alloc);
+    String large(10000, 'x', alloc);
+    EXPECT_FALSE(buddy.contains(small.data()));
+    EXPECT_TRUE(buddy.contains(large.data()));
+
+    // Empty container takes resource by move assignment
+    String value;
+    value = String(alloc);
+    value.assign(large.data(), large.size());
+    EXPECT_TRUE(buddy.contains(value.data()));
+
+    String huge(100 * 4096, 'x', alloc);
+    EXPECT_FALSE(buddy.contains(huge.data()));
+    EXPECT_EQ(resource.overflows(), 1u);
+
+    size_t live = 0;
+    resource.inspect([&live](const Buddy &allocator) { live = allocator.live(); });
+    EXPECT_EQ(live, 2u);
+}
+
+TEST(BuddyTest, Stats) {
+    static char region[RegionSize];
+    Buddy buddy(region, sizeof(region));
+
+    vector<void *> blocks;
+    for (int i = 0; i < 16; i++) {
+        blocks.push_back(buddy.alloc(3 * 4096));
+    }
+    for (int i = 0; i < 16; i += 2) {
+        buddy.free(blocks[i]);
+    }
+
+    Stats stats = buddy.stats();
+    EXPECT_EQ(stats.reserved, 64 * 4096u);
+    EXPECT_EQ(stats.used, 8 * 4 * 4096u);
+    EXPECT_EQ(stats.free, 8 * 4 * 4096u);
+    EXPECT_EQ(stats.live, 8u);
+    EXPECT_EQ(stats.largest_free, 4 * 4096u);
+    EXPECT_DOUBLE_EQ(stats.fragmentation, buddy.external_fragmentation());
+    ASSERT_EQ(stats.free_blocks.size(), 1u);
+    EXPECT_EQ(stats.free_blocks[0], make_pair(size_t(4 * 4096), size_t(8)));
+}
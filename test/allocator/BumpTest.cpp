@@ -0,0 +1,96 @@
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <cstring>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <afina/allocator/Bump.h>
+
+using namespace std;
+using namespace Afina::Allocator;
+
+TEST(BumpTest, Blocks) {
+    Bump arena("test.bump", 4096);
+
+    set<char *> blocks;
+    char *prev = nullptr;
+    for (int i = 0; i < 1000; i++) {
+        char *p = static_cast<char *>(arena.allocate(24));
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % 16, 0u);
+        memset(p, i, 24);
+        if (prev != nullptr && p > prev && p < prev + 4096) {
+            EXPECT_GE(p, prev + 24);
+        }
+        blocks.insert(p);
+        prev = p;
+    }
+    EXPECT_EQ(blocks.size(), 1000u);
+    EXPECT_EQ(arena.bytes(), 24000u);
+    size_t chunks = arena.chunks();
+    EXPECT_GE(chunks, 1000 * 32 / 4096u);
+
+    // Reset takes all chunks back for the next round
+    for (char *p : blocks) {
+        arena.deallocate(p, 24);
+    }
+    arena.reset();
+    EXPECT_EQ(arena.bytes(), 0u);
+    for (int i = 0; i < 1000; i++) {
+        char *p = static_cast<char *>(arena.allocate(24));
+        EXPECT_EQ(blocks.count(p), 1u);
+    }
+    EXPECT_EQ(arena.chunks(), chunks);
+    EXPECT_EQ(arena.resets(), 1u);
+}
+
+TEST(BumpTest, LastBlockReturns) {
+    Bump arena("test.bump", 4096);
+
+    void *p1 = arena.allocate(100);
+    void *p2 = arena.allocate(100);
+    arena.deallocate(p2, 100);
+    EXPECT_EQ(arena.allocate(200), p2);
+
+    // Blocks other than the last one are kept until reset
+    arena.deallocate(p1, 100);
+    EXPECT_NE(arena.allocate(100), p1);
+}
+
+TEST(BumpTest, LargeBlocks) {
+    Bump arena("test.bump", 4096);
+
+    char *small = static_cast<char *>(arena.allocate(100));
+    char *large = static_cast<char *>(arena.allocate(100000));
+    memset(large, 1, 100000);
+    char *next = static_cast<char *>(arena.allocate(100));
+    EXPECT_EQ(next, small + 112);
+
+    arena.deallocate(large, 100000);
+    arena.allocate(200000);
+    EXPECT_EQ(arena.blocks(), 3u);
+    arena.reset();
+    EXPECT_EQ(arena.chunks(), 1u);
+}
+
+TEST(BumpTest, Containers) {
+    Bump arena("test.bump");
+    for (int round = 0; round < 10; round++) {
+        {
+            StlAllocator<char> alloc(arena);
+            String s(alloc);
+            Vector<String> v(alloc);
+            for (int i = 0; i < 100; i++) {
+                s.append("0123456789");
+                v.emplace_back(String(to_string(i).c_str(), alloc));
+            }
+            EXPECT_EQ(s.size(), 1000u);
+            for (int i = 0; i < 100; i++) {
+                EXPECT_EQ(v[i], String(to_string(i).c_str(), alloc));
+            }
+        }
+        EXPECT_EQ(arena.bytes(), 0u);
+        arena.reset();
+    }
+    EXPECT_LE(arena.chunks(), 4u);
+}
@@ -0,0 +1,215 @@
+#include "gtest/gtest.h"
+#include <deque>
+#include <list>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <afina/allocator/Pointer.h>
+#include <afina/allocator/Resource.h>
+#include <afina/allocator/Simple.h>
+
+using namespace std;
+using namespace Afina::Allocator;
+
+TEST(ResourceTest, Containers) {
+    SlabResource pool("test.containers");
+    {
+        StlAllocator<int> alloc(pool);
+        vector<int, StlAllocator<int>> v(alloc);
+        list<String, StlAllocator<String>> l(alloc);
+        unordered_map<int, int, hash<int>, equal_to<int>, StlAllocator<pair<const int, int>>> m(alloc);
+
+        for (int i = 0; i < 1000; i++) {
+            v.push_back(i);
+            l.emplace_back(String(100, 'a' + i % 26, StlAllocator<char>(pool)));
+            m[i] = -i;
+        }
+        EXPECT_GT(pool.blocks(), 2000u);
+        EXPECT_GT(pool.bytes(), 100 * 1000u);
+
+        for (int i = 0; i < 1000; i++) {
+            EXPECT_EQ(v[i], i);
+            EXPECT_EQ(m[i], -i);
+        }
+        for (auto &s : l) {
+            EXPECT_EQ(s.size(), 100u);
+        }
+        EXPECT_EQ(l.get_allocator(), v.get_allocator());
+        EXPECT_NE(l.get_allocator(), StlAllocator<int>());
+    }
+
+    EXPECT_EQ(pool.bytes(), 0u);
+    EXPECT_EQ(pool.blocks(), 0u);
+    EXPECT_GT(pool.peak(), 100 * 1000u);
+    EXPECT_EQ(pool.failures(), 0u);
+}
+
+TEST(ResourceTest, Registry) {
+    size_t found = 0;
+    {
+        SlabResource pool("test.registry");
+        vector<char, StlAllocator<char>> v(4096, 'x', StlAllocator<char>(pool));
+
+        Resource::ForEach([&found](const Resource &resource) {
+            if (resource.name() == "test.registry") {
+                EXPECT_EQ(resource.bytes(), 4096u);
+                found++;
+            }
+        });
+    }
+    EXPECT_EQ(found, 1u);
+
+    Resource::ForEach([](const Resource &resource) { EXPECT_NE(resource.name(), "test.registry"); });
+}
+
+TEST(ResourceTest, Threads) {
+    SlabResource pool("test.threads");
+    vector<void *> blocks(1000);
+
+    // Blocks are allocated and freed by different threads, counters of both add up
+    thread producer([&pool, &blocks]() {
+        for (auto &block : blocks) {
+            block = pool.allocate(100);
+        }
+    });
+    producer.join();
+    EXPECT_EQ(pool.bytes(), 100 * 1000u);
+    EXPECT_EQ(pool.blocks(), 1000u);
+
+    thread consumer([&pool, &blocks]() {
+        for (auto block : blocks) {
+            pool.deallocate(block, 100);
+        }
+    });
+    consumer.join();
+    EXPECT_EQ(pool.bytes(), 0u);
+    EXPECT_EQ(pool.blocks(), 0u);
+    EXPECT_EQ(pool.peak(), 100 * 1000u);
+    EXPECT_EQ(pool.allocations(), 1000u);
+
+    // Resources of threads that are gone stay registered
+    unique_ptr<SlabResource> owned;
+    thread([&owned]() { owned.reset(new SlabResource("test.threads.owned")); }).join();
+    size_t found = 0;
+    Resource::ForEach([&found](const Resource &resource) { found += resource.name() == "test.threads.owned"; });
+    EXPECT_EQ(found, 1u);
+}
+
+TEST(ResourceTest, SimpleResource) {
+    static char region[65536];
+    Simple simple(region, sizeof(region));
+    SimpleResource resource("test.simple", simple);
+
+    Pointer movable = simple.alloc(1000);
+    StlAllocator<int> alloc(resource);
+    list<int, StlAllocator<int>> l(alloc);
+    for (int i = 0; i < 100; i++) {
+        l.push_back(i);
+    }
+    EXPECT_EQ(simple.fixed(), 100u);
+
+    // Nodes survive compaction of the region
+    simple.free(movable);
+    simple.defrag();
+    int i = 0;
+    for (int v : l) {
+        EXPECT_EQ(v, i++);
+    }
+
+    // Region is exhausted
+    vector<char, StlAllocator<char>> v(alloc);
+    EXPECT_THROW(v.reserve(100000), bad_alloc);
+    EXPECT_EQ(resource.failures(), 1u);
+    EXPECT_EQ(l.size(), 100u);
+
+    l.clear();
+    EXPECT_EQ(simple.fixed(), 0u);
+    EXPECT_EQ(resource.bytes(), 0u);
+}
+
+TEST(ResourceTest, SlabResourceThreads) {
+    SlabResource pool("test.threads");
+    vector<thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&pool, t]() {
+            for (int round = 0; round < 100; round++) {
+                StlAllocator<int> alloc(pool);
+                deque<int, StlAllocator<int>> q(alloc);
+                list<int, StlAllocator<int>> l(alloc);
+                for (int i = 0; i < 1000; i++) {
+                    q.push_back(i + t);
+                    l.push_back(i);
+                }
+                for (int i = 0; i < 1000; i++) {
+                    EXPECT_EQ(q.front(), i + t);
+                    q.pop_front();
+                }
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    EXPECT_EQ(pool.bytes(), 0u);
+    EXPECT_EQ(pool.blocks(), 0u);
+}
+
+TEST(ResourceTest, Stats) {
+    Arena arena(64 << 20);
+    SlabCache cache(arena);
+    SlabResource pool("test.stats", cache);
+
+    vector<void *> objects;
+    for (int i = 0; i < 10; i++) {
+        objects.push_back(pool.allocate(100));
+    }
+    for (int i = 0; i < 3; i++) {
+        pool.deallocate(objects[i], 100);
+    }
+
+    // Objects of 100 bytes take 112 each
+    size_t capacity = Arena::DefaultSlabSize / 112;
+    Stats stats = pool.stats();
+    EXPECT_EQ(stats.reserved, Arena::DefaultSlabSize);
+    EXPECT_EQ(stats.used, 7 * 112u);
+    EXPECT_EQ(stats.free, (capacity - 7) * 112);
+    EXPECT_EQ(stats.live, 7u);
+    EXPECT_EQ(stats.largest_free, 112u);
+    EXPECT_EQ(stats.fragmentation, 0);
+    ASSERT_EQ(stats.free_blocks.size(), 1u);
+    EXPECT_EQ(stats.free_blocks[0], make_pair(size_t(112), capacity - 7));
+
+    Stats arena_stats = cache.stats();
+    EXPECT_EQ(arena_stats.reserved, 64u << 20);
+    EXPECT_EQ(arena_stats.live, 1u);
+    EXPECT_EQ(arena_stats.free_blocks[0], make_pair(Arena::DefaultSlabSize, size_t(63)));
+
+    // Pools of the same name sum up, free blocks of the same class too
+    stats.merge(pool.stats());
+    EXPECT_EQ(stats.live, 14u);
+    EXPECT_EQ(stats.free_blocks[0].second, 2 * (capacity - 7));
+
+    vector<pair<string, string>> report;
+    stats.report("test", report);
+    EXPECT_EQ(report[3], make_pair(string("test:live"), string("14")));
+    EXPECT_EQ(report.back().first, "test:free_blocks_112");
+
+    for (int i = 3; i < 10; i++) {
+        pool.deallocate(objects[i], 100);
+    }
+
+    // Pool keeps slabs it doesn't need anymore
+    objects.clear();
+    for (size_t i = 0; i < 4 * capacity; i++) {
+        objects.push_back(pool.allocate(100));
+    }
+    for (void *p : objects) {
+        pool.deallocate(p, 100);
+    }
+    EXPECT_DOUBLE_EQ(pool.stats().fragmentation,
+                     (4 * capacity * 112.0 - Arena::DefaultSlabSize) / (4 * Arena::DefaultSlabSize));
+}
@@ -1,4 +1,5 @@
 #include "gtest/gtest.h"
+#include <cstring>
 #include <iostream>
 #include <set>
 #include <vector>
@@ -28,7 +29,7 @@ TEST(SimpleTest, AllocInRange) {
 static void writeTo(Pointer &p, size_t size) {
     char *v = reinterpret_cast<char *>(p.get());
 
-    for (int i = 0; i < size; i++) {
+    for (size_t i = 0; i < size; i++) {
         v[i] = i % 31;
     }
 }
@@ -36,8 +37,8 @@ static void writeTo(Pointer &p, size_t size) {
 static bool isDataOk(Pointer &p, size_t size) {
     char *v = reinterpret_cast<char *>(p.get());
 
-    for (int i = 0; i < size; i++) {
-        if (v[i] != i % 31) {
+    for (size_t i = 0; i < size; i++) {
+        if (v[i] != char(i % 31)) {
             return false;
         }
     }
@@ -322,3 +323,277 @@ TEST(SimpleTest, ReallocGrow) {
     a.free(p);
     a.free(p2);
 }
+
+TEST(SimpleTest, ReallocGrowIntoFree) {
+    Simple a(buf, sizeof(buf));
+
+    int size = 135;
+    Pointer p = a.alloc(size);
+    Pointer p2 = a.alloc(size);
+    Pointer p3 = a.alloc(size);
+    Pointer p4 = a.alloc(size);
+    writeTo(p, size);
+    writeTo(p4, size);
+
+    // Block takes free neighbours following it
+    void *ptr = p.get();
+    a.free(p2);
+    a.free(p3);
+    a.realloc(p, size * 3);
+    EXPECT_EQ(p.get(), ptr);
+    EXPECT_TRUE(isDataOk(p, size));
+    EXPECT_TRUE(isDataOk(p4, size));
+
+    // and the gap behind them
+    size_t available = a.available();
+    a.free(p4);
+    a.realloc(p, size * 10);
+    EXPECT_EQ(p.get(), ptr);
+    EXPECT_TRUE(isDataOk(p, size));
+    EXPECT_EQ(a.live(), 1u);
+    EXPECT_LT(a.available(), available);
+
+    a.free(p);
+}
+
+TEST(SimpleTest, ReallocGrowAfterDefrag) {
+    Simple a(buf, sizeof(buf));
+
+    vector<Pointer> blocks;
+    for (int i = 0; i < 10; i++) {
+        blocks.push_back(a.alloc(100));
+        writeTo(blocks.back(), 100);
+    }
+    a.free(blocks[0]);
+    a.defrag();
+
+    // Compaction position must not be left in the middle of the grown block
+    a.realloc(blocks[9], 1000);
+    memset(blocks[9].get(), 0, 1000);
+    size_t available = a.available();
+    EXPECT_TRUE(a.defrag_step(1 << 20, std::chrono::microseconds(1000)));
+    EXPECT_EQ(a.available(), available);
+    EXPECT_EQ(a.fragmentation(), 0);
+
+    a.free(blocks[8]);
+    a.realloc(blocks[7], 300);
+    a.free(blocks[2]);
+    EXPECT_TRUE(a.defrag_step(1 << 20, std::chrono::microseconds(1000)));
+    EXPECT_EQ(a.fragmentation(), 0);
+    for (int i : {1, 3, 4, 5, 6, 7}) {
+        EXPECT_TRUE(isDataOk(blocks[i], 100));
+    }
+}
+
+TEST(SimpleTest, InvalidFree) {
+    Simple a(buf, sizeof(buf));
+
+    Pointer p = a.alloc(100);
+    Pointer copy = p;
+    a.free(p);
+    EXPECT_EQ(p.get(), nullptr);
+
+    try {
+        a.free(copy);
+        EXPECT_TRUE(false);
+    } catch (AllocError &e) {
+        EXPECT_EQ(e.getType(), AllocErrorType::InvalidFree);
+    }
+
+    // Freeing an empty pointer is noop
+    a.free(p);
+}
+
+TEST(SimpleTest, RandomChurn) {
+    Simple a(buf, sizeof(buf));
+
+    // Each block is filled with its own byte
+    vector<pair<Pointer, size_t>> live;
+    srand(1);
+    for (int i = 0; i < 20000; i++) {
+        int op = rand() % 8;
+        if (op < 4) {
+            size_t size = 1 + rand() % 700;
+            try {
+                live.emplace_back(a.alloc(size), size);
+                memset(live.back().first.get(), live.size() % 251, size);
+            } catch (AllocError &) {
+                a.defrag();
+            }
+        } else if (op < 6 && !live.empty()) {
+            size_t j = rand() % live.size();
+            a.free(live[j].first);
+            live.erase(live.begin() + j);
+        } else if (op < 7 && !live.empty()) {
+            size_t j = rand() % live.size();
+            size_t size = 1 + rand() % 700;
+            try {
+                a.realloc(live[j].first, size);
+                memset(live[j].first.get(), (j + 1) % 251, size);
+                live[j].second = size;
+            } catch (AllocError &) {
+            }
+        } else if (op == 7) {
+            a.defrag_step(256, std::chrono::microseconds(1000));
+        }
+
+        // Content of moved blocks is preserved
+        for (size_t j = 0; i % 100 == 0 && j < live.size(); j++) {
+            char *v = reinterpret_cast<char *>(live[j].first.get());
+            char expected = v[0];
+            for (size_t k = 0; k < live[j].second; k++) {
+                ASSERT_EQ(expected, v[k]);
+            }
+            ASSERT_TRUE(isValidMemory(live[j].first, live[j].second));
+        }
+    }
+
+    size_t used = 0;
+    for (auto &block : live) {
+        used += block.second;
+    }
+    EXPECT_GE(a.used(), used);
+    EXPECT_EQ(a.live(), live.size());
+}
+
+TEST(SimpleTest, DefragStep) {
+    Simple a(buf, sizeof(buf));
+
+    vector<Pointer> blocks;
+    for (int i = 0; i < 100; i++) {
+        blocks.push_back(a.alloc(64 + i));
+        writeTo(blocks.back(), 64 + i);
+    }
+    for (int i = 0; i < 100; i += 2) {
+        a.free(blocks[i]);
+    }
+    EXPECT_GT(a.fragmentation(), 0);
+
+    // Each step moves a single block at most
+    int steps = 0;
+    while (!a.defrag_step(1, std::chrono::microseconds(1000))) {
+        steps++;
+    }
+    EXPECT_GE(steps, 40);
+    EXPECT_EQ(a.fragmentation(), 0);
+    EXPECT_GT(a.moved(), 0u);
+
+    for (int i = 1; i < 100; i += 2) {
+        EXPECT_TRUE(isDataOk(blocks[i], 64 + i));
+    }
+
+    // Single block freed below compacted part is picked up by the next step
+    a.free(blocks[1]);
+    EXPECT_GT(a.fragmentation(), 0);
+    EXPECT_TRUE(a.defrag_step(1 << 20, std::chrono::microseconds(1000)));
+    EXPECT_EQ(a.fragmentation(), 0);
+    for (int i = 3; i < 100; i += 2) {
+        EXPECT_TRUE(isDataOk(blocks[i], 64 + i));
+    }
+}
+
+TEST(SimpleTest, Pin) {
+    Simple a(buf, sizeof(buf));
+
+    Pointer p1 = a.alloc(100);
+    Pointer p2 = a.alloc(100);
+    Pointer p3 = a.alloc(100);
+    writeTo(p2, 100);
+    writeTo(p3, 100);
+
+    a.free(p1);
+    a.pin(p2);
+    void *v2 = p2.get();
+
+    a.defrag();
+    EXPECT_EQ(v2, p2.get());
+    EXPECT_TRUE(isDataOk(p2, 100));
+    EXPECT_TRUE(isDataOk(p3, 100));
+    EXPECT_GT(a.fragmentation(), 0);
+
+    // Pinned block can't move to grow
+    try {
+        a.realloc(p2, 10000);
+        EXPECT_TRUE(false);
+    } catch (AllocError &e) {
+        EXPECT_EQ(e.getType(), AllocErrorType::NoMemory);
+    }
+
+    // Free is deferred while pinned
+    Pointer copy = p2;
+    a.free(p2);
+    EXPECT_EQ(a.live(), 2u);
+    EXPECT_TRUE(isDataOk(copy, 100));
+    EXPECT_THROW(a.free(copy), AllocError);
+
+    a.unpin(copy);
+    EXPECT_EQ(a.live(), 1u);
+    EXPECT_THROW(a.unpin(copy), AllocError);
+
+    a.defrag();
+    EXPECT_EQ(a.fragmentation(), 0);
+    EXPECT_TRUE(isDataOk(p3, 100));
+}
+
+TEST(SimpleTest, FixedBlocks) {
+    Simple a(buf, sizeof(buf));
+
+    Pointer p1 = a.alloc(100);
+    char *f = static_cast<char *>(a.alloc_fixed(100));
+    Pointer p2 = a.alloc(100);
+    for (int i = 0; i < 100; i++) {
+        f[i] = i % 31;
+    }
+    writeTo(p2, 100);
+    EXPECT_EQ(a.live(), 3u);
+    EXPECT_EQ(a.fixed(), 1u);
+
+    // Fixed block stays in place, others slide around it
+    a.free(p1);
+    a.defrag();
+    while (!a.defrag_step(1 << 20, std::chrono::microseconds(1000))) {
+    }
+    EXPECT_TRUE(isDataOk(p2, 100));
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(f[i], i % 31);
+    }
+
+    EXPECT_THROW(a.free_fixed(p2.get()), AllocError);
+    EXPECT_THROW(a.free_fixed(buf), AllocError);
+
+    a.free_fixed(f);
+    EXPECT_EQ(a.fixed(), 0u);
+    EXPECT_THROW(a.free_fixed(f), AllocError);
+    a.free(p2);
+    EXPECT_EQ(a.live(), 0u);
+    EXPECT_EQ(a.used(), 0u);
+}
+
+TEST(SimpleTest, Stats) {
+    Simple a(buf, sizeof(buf));
+
+    Pointer p1 = a.alloc(100);
+    Pointer p2 = a.alloc(100);
+    Pointer p3 = a.alloc(1000);
+    a.free(p2);
+
+    Stats stats = a.stats();
+    EXPECT_EQ(stats.reserved, sizeof(buf));
+    EXPECT_EQ(stats.used, a.used());
+    EXPECT_EQ(stats.free, a.available());
+    EXPECT_EQ(stats.live, 2u);
+    EXPECT_DOUBLE_EQ(stats.fragmentation, a.fragmentation());
+    EXPECT_GT(stats.largest_free, sizeof(buf) / 2);
+    ASSERT_EQ(stats.free_blocks.size(), 1u);
+    EXPECT_EQ(stats.free_blocks[0], make_pair(size_t(128), size_t(1)));
+
+    // Hole is gone, gap is the largest free block
+    a.defrag();
+    stats = a.stats();
+    EXPECT_TRUE(stats.free_blocks.empty());
+    EXPECT_EQ(stats.fragmentation, 0);
+    EXPECT_LT(stats.largest_free, stats.free);
+
+    a.free(p1);
+    a.free(p3);
+}
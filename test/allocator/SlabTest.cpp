@@ -0,0 +1,288 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <afina/allocator/Slab.h>
+
+using namespace std;
+using namespace Afina::Allocator;
+
+TEST(SlabTest, ArenaSlabs) {
+    Arena arena(4 << 20, 1 << 20);
+    SlabCache cache(arena);
+
+    vector<void *> slabs;
+    for (int i = 0; i < 4; i++) {
+        slabs.push_back(cache.get());
+        ASSERT_NE(slabs.back(), nullptr);
+        EXPECT_TRUE(arena.contains(slabs.back()));
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(slabs.back()) % (1 << 20), 0u);
+        memset(slabs.back(), i, 1 << 20);
+    }
+    EXPECT_EQ(cache.get(), nullptr);
+    EXPECT_EQ(arena.mapped(), 4u << 20);
+
+    // Returned slab is reused
+    cache.put(slabs[2]);
+    EXPECT_EQ(cache.cached(), 1u);
+    EXPECT_EQ(cache.get(), slabs[2]);
+    EXPECT_EQ(cache.cached(), 0u);
+}
+
+TEST(SlabTest, MempoolObjects) {
+    Arena arena(4 << 20, 64 << 10);
+    SlabCache cache(arena);
+
+    Mempool pool(cache, 100);
+    EXPECT_EQ(pool.object_size(), 112u);
+
+    set<void *> objects;
+    for (int i = 0; i < 2000; i++) {
+        void *p = pool.alloc();
+        ASSERT_NE(p, nullptr);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % 16, 0u);
+        EXPECT_TRUE(objects.insert(p).second);
+        memset(p, 0xff, 100);
+    }
+    EXPECT_EQ(pool.slabs(), (2000 * 112 + (64u << 10) - 1) / (64u << 10));
+
+    // Freed objects are reused before new slabs are taken
+    size_t slabs = pool.slabs();
+    for (void *p : objects) {
+        pool.free(p);
+    }
+    for (int i = 0; i < 2000; i++) {
+        EXPECT_EQ(objects.count(pool.alloc()), 1u);
+    }
+    EXPECT_EQ(pool.slabs(), slabs);
+}
+
+TEST(SlabTest, MempoolExhausted) {
+    Arena arena(128 << 10, 64 << 10);
+    SlabCache cache(arena);
+
+    {
+        Mempool pool(cache, 32 << 10);
+        for (int i = 0; i < 4; i++) {
+            EXPECT_NE(pool.alloc(), nullptr);
+        }
+        EXPECT_EQ(pool.alloc(), nullptr);
+    }
+
+    // Destroyed pool gives slabs back
+    EXPECT_EQ(cache.cached(), 2u);
+    Mempool pool(cache, 8);
+    EXPECT_NE(pool.alloc(), nullptr);
+    EXPECT_EQ(cache.cached(), 1u);
+}
+
+// Objects are passed between threads and freed by other threads than allocated them
+TEST(SlabTest, MempoolThreads) {
+    Arena arena(256 << 20);
+    SlabCache cache(arena);
+    Mempool pool(cache, 64);
+
+    const int Threads = 8;
+    const int Rounds = 20000;
+    vector<atomic<uint64_t *>> mailbox(Threads);
+    for (auto &box : mailbox) {
+        box = nullptr;
+    }
+
+    atomic<int> broken(0);
+    vector<thread> threads;
+    for (int t = 0; t < Threads; t++) {
+        threads.emplace_back([&, t]() {
+            vector<uint64_t *> own;
+            for (int i = 0; i < Rounds; i++) {
+                uint64_t *p = static_cast<uint64_t *>(pool.alloc());
+                for (int k = 0; k < 8; k++) {
+                    p[k] = uint64_t(t) << 32 | i;
+                }
+                own.push_back(p);
+
+                // Hand object over to the neighbour and free whatever was handed over to us
+                p = mailbox[(t + 1) % Threads].exchange(own.back());
+                own.pop_back();
+                if (p != nullptr) {
+                    for (int k = 1; k < 8; k++) {
+                        broken += p[k] != p[0];
+                    }
+                    pool.free(p);
+                }
+
+                if (i % 3 == 0) {
+                    own.push_back(static_cast<uint64_t *>(pool.alloc()));
+                    own.back()[0] = i;
+                }
+                if (own.size() > 100) {
+                    for (uint64_t *q : own) {
+                        pool.free(q);
+                    }
+                    own.clear();
+                }
+            }
+            for (uint64_t *q : own) {
+                pool.free(q);
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(broken, 0);
+
+    // All objects are back, each of them is handed out once
+    for (auto &box : mailbox) {
+        if (box != nullptr) {
+            pool.free(box);
+        }
+    }
+    set<void *> objects;
+    size_t total = pool.slabs() * (arena.slab_size() / pool.object_size());
+    for (size_t i = 0; i < total; i++) {
+        ASSERT_TRUE(objects.insert(pool.alloc()).second);
+    }
+    EXPECT_EQ(objects.count(nullptr), 0u);
+}
+
+struct Node : SlabAllocated<Node> {
+    char data[40];
+};
+
+struct BigNode : Node {
+    char more[100];
+};
+
+TEST(SlabTest, SlabAllocated) {
+    Node *node = new Node();
+    EXPECT_TRUE(DefaultArena().contains(node));
+    delete node;
+
+    // Derived objects are larger than pool objects
+    Node *big = new BigNode();
+    EXPECT_FALSE(DefaultArena().contains(big));
+    delete static_cast<BigNode *>(big);
+}
+
+TEST(SlabTest, MempoolBatches) {
+    Arena arena(4 << 20, 64 << 10);
+    SlabCache cache(arena);
+    Mempool pool(cache, 64);
+
+    void *batch[Mempool::BatchSize];
+    ASSERT_EQ(pool.alloc_batch(batch), Mempool::BatchSize);
+    EXPECT_EQ(pool.slabs(), 1u);
+
+    // Full batch returned is given out again as a whole
+    set<void *> objects(batch, batch + Mempool::BatchSize);
+    pool.free_batch(batch, Mempool::BatchSize);
+    ASSERT_EQ(pool.alloc_batch(batch), Mempool::BatchSize);
+    EXPECT_EQ(set<void *>(batch, batch + Mempool::BatchSize), objects);
+
+    // Incomplete batch is given out by single objects
+    pool.free_batch(batch, 3);
+    for (int i = 0; i < 3; i++) {
+        EXPECT_EQ(objects.count(pool.alloc()), 1u);
+    }
+}
+
+TEST(SlabTest, Magazine) {
+    Arena arena(4 << 20, 64 << 10);
+    SlabCache cache(arena);
+    Mempool pool(cache, 64);
+
+    vector<void *> objects;
+    {
+        Magazine magazine(pool);
+        for (size_t i = 0; i < 10 * Magazine::Capacity; i++) {
+            objects.push_back(magazine.alloc());
+            ASSERT_NE(objects.back(), nullptr);
+        }
+        EXPECT_EQ(set<void *>(objects.begin(), objects.end()).size(), objects.size());
+
+        // Magazine keeps at most its capacity, the rest goes back to the pool by batches
+        for (void *p : objects) {
+            magazine.free(p);
+            EXPECT_LE(magazine.size(), Magazine::Capacity);
+        }
+        EXPECT_GT(magazine.size(), 0u);
+    }
+
+    // Destroyed magazine gave all objects back
+    set<void *> again;
+    for (size_t i = 0; i < objects.size(); i++) {
+        again.insert(pool.alloc());
+    }
+    EXPECT_EQ(again, set<void *>(objects.begin(), objects.end()));
+}
+
+// Each thread has its own magazine, objects are freed by other threads than allocated them
+TEST(SlabTest, MagazineThreads) {
+    Arena arena(256 << 20);
+    SlabCache cache(arena);
+    Mempool pool(cache, 64);
+
+    const int Threads = 8;
+    vector<atomic<uint64_t *>> mailbox(Threads);
+    for (auto &box : mailbox) {
+        box = nullptr;
+    }
+
+    atomic<int> broken(0);
+    vector<thread> threads;
+    for (int t = 0; t < Threads; t++) {
+        threads.emplace_back([&, t]() {
+            Magazine magazine(pool);
+            for (int i = 0; i < 20000; i++) {
+                uint64_t *p = static_cast<uint64_t *>(magazine.alloc());
+                for (int k = 0; k < 8; k++) {
+                    p[k] = uint64_t(t) << 32 | i;
+                }
+
+                p = mailbox[(t + 1) % Threads].exchange(p);
+                if (p != nullptr) {
+                    for (int k = 1; k < 8; k++) {
+                        broken += p[k] != p[0];
+                    }
+                    magazine.free(p);
+                }
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    EXPECT_EQ(broken, 0);
+
+    for (auto &box : mailbox) {
+        pool.free(box);
+    }
+    set<void *> objects;
+    size_t total = pool.slabs() * (arena.slab_size() / pool.object_size());
+    for (size_t i = 0; i < total; i++) {
+        ASSERT_TRUE(objects.insert(pool.alloc()).second);
+    }
+    EXPECT_EQ(objects.count(nullptr), 0u);
+}
+
+TEST(SlabTest, Buffers) {
+    size_t sizes[] = {1, 64, 65, 1000, 4096, MaxBufferSize, MaxBufferSize + 1};
+    for (size_t size : sizes) {
+        char *buffer = AllocBuffer(size);
+        EXPECT_EQ(DefaultArena().contains(buffer), size <= MaxBufferSize);
+        memset(buffer, 'x', size);
+        FreeBuffer(buffer, size);
+
+        // Freed buffer is reused by the thread for the same size class
+        if (size <= MaxBufferSize) {
+            char *again = AllocBuffer(size);
+            EXPECT_EQ(again, buffer);
+            FreeBuffer(again, size);
+        }
+    }
+}
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <afina/execute/Command.h>
+#include <afina/execute/StaticCommand.h>
+#include <protocol/Parser.h>
+#include <storage/MapBasedGlobalLockImpl.h>
+
+using namespace Afina;
+
+namespace {
+
+// Runs commands through the given build/execute pair and returns replies joined by \r\n
+template <typename TRun>
+std::string Replay(const std::vector<std::pair<std::string, std::string>> &script, TRun run) {
+    std::string out;
+    for (auto &step : script) {
+        Protocol::Parser parser;
+        size_t parsed = 0;
+        EXPECT_TRUE(parser.Parse(step.first, parsed));
+        run(parser, step.second, out);
+        out.append("\r\n");
+    }
+    return out;
+}
+
+} // namespace
+
+// Static pipeline must reply exactly like command objects do
+TEST(StaticCommandTest, SameReplies) {
+    std::vector<std::pair<std::string, std::string>> script = {
+        {"get a\r\n", ""},         {"set a 0 0 1\r\n", "x"},  {"add a 0 0 1\r\n", "y"},
+        {"add b 0 0 1\r\n", "y"},  {"append a 0 0 2\r\n", "zz"}, {"append c 0 0 1\r\n", "q"},
+        {"get a b c\r\n", ""},     {"delete b\r\n", ""},       {"delete b\r\n", ""},
+        {"flush_all\r\n", ""},     {"get a\r\n", ""}};
+
+    Backend::MapBasedGlobalLockImpl runtime_storage(1024);
+    std::string runtime = Replay(script, [&](Protocol::Parser &parser, const std::string &body, std::string &out) {
+        uint32_t body_size = 0;
+        std::unique_ptr<Execute::Command> cmd = parser.Build(body_size);
+        ASSERT_EQ(body.size(), body_size);
+
+        std::string reply;
+        cmd->Execute(runtime_storage, body, reply);
+        out.append(reply);
+    });
+
+    Backend::MapBasedGlobalLockImpl static_storage(1024);
+    Execute::StaticCommand cmd;
+    std::string compiled = Replay(script, [&](Protocol::Parser &parser, const std::string &body, std::string &out) {
+        uint32_t body_size = 0;
+        ASSERT_TRUE(parser.Build(cmd, body_size));
+        ASSERT_EQ(body.size(), body_size);
+        Execute::ExecuteStatic(static_storage, cmd, body, out);
+    });
+
+    EXPECT_EQ(runtime, compiled);
+    EXPECT_EQ("END\r\nSTORED\r\nNOT_STORED\r\nSTORED\r\nSTORED\r\nNOT_STORED\r\n"
+              "VALUE a 0 3\r\nxzz\r\nVALUE b 0 1\r\ny\r\nEND\r\nDELETED\r\nNOT_FOUND\r\nOK\r\nEND\r\n",
+              compiled);
+}
+
+// Hot commands are built inline, the rest falls back to command objects
+TEST(StaticCommandTest, Kinds) {
+    Protocol::Parser parser;
+    Execute::StaticCommand cmd;
+    uint32_t body_size = 0;
+    size_t parsed = 0;
+
+    ASSERT_FALSE(parser.Parse("get foo ba", parsed));
+    EXPECT_FALSE(parser.Build(cmd, body_size));
+
+    ASSERT_TRUE(parser.Parse("r\r\n", parsed));
+    ASSERT_TRUE(parser.Build(cmd, body_size));
+    EXPECT_EQ(Execute::StaticCommand::Kind::Get, cmd.kind);
+    EXPECT_EQ(std::vector<std::string>({"foo", "bar"}), cmd.keys);
+    EXPECT_TRUE(cmd.dynamic == nullptr);
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("set foo 1 0 5\r\n", parsed));
+    ASSERT_TRUE(parser.Build(cmd, body_size));
+    EXPECT_EQ(Execute::StaticCommand::Kind::Set, cmd.kind);
+    EXPECT_EQ(5u, body_size);
+    EXPECT_EQ(std::vector<std::string>({"foo"}), cmd.keys);
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("stats\r\n", parsed));
+    ASSERT_TRUE(parser.Build(cmd, body_size));
+    EXPECT_EQ(Execute::StaticCommand::Kind::Dynamic, cmd.kind);
+    EXPECT_TRUE(cmd.dynamic != nullptr);
+    EXPECT_TRUE(cmd.keys.empty());
+}
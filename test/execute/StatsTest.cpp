@@ -0,0 +1,36 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include <afina/execute/Stats.h>
+
+using namespace Afina;
+
+TEST(StatsTest, Merge) {
+    std::string first = "STAT keyspace_items 3\r\n"
+                        "STAT keyspace_sample_ratio 0.500000\r\n"
+                        "STAT prefix:user 2 20\r\n"
+                        "STAT bigkey:a 100\r\n"
+                        "STAT eviction_policy lru\r\n"
+                        "END";
+    std::string second = "STAT keyspace_items 4\r\n"
+                         "STAT keyspace_sample_ratio 0.250000\r\n"
+                         "STAT prefix:user 1 10\r\n"
+                         "STAT bigkey:b 200\r\n"
+                         "STAT eviction_policy arc\r\n"
+                         "END";
+    std::string failed = "SERVER_ERROR oops";
+
+    std::string out;
+    Execute::Stats::Merge({&first, &second, &failed}, out);
+    EXPECT_EQ("STAT keyspace_items 7\r\n"
+              "STAT keyspace_sample_ratio 0.375000\r\n"
+              "STAT prefix:user 3 30\r\n"
+              "STAT bigkey:a 100\r\n"
+              "STAT eviction_policy lru\r\n"
+              "STAT bigkey:b 200\r\n"
+              "SERVER_ERROR oops\r\n"
+              "END",
+              out);
+}
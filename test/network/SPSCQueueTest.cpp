@@ -0,0 +1,52 @@
+#include "gtest/gtest.h"
+
+#include <thread>
+
+#include <network/uv/SPSCQueue.h>
+
+using namespace Afina::Network::UV;
+
+TEST(SPSCQueueTest, PushPop) {
+    SPSCQueue<int> queue(4);
+
+    int value;
+    EXPECT_FALSE(queue.Pop(value));
+
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(queue.Push(i));
+    }
+    EXPECT_FALSE(queue.Push(4));
+
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(queue.Pop(value));
+        EXPECT_EQ(i, value);
+    }
+    EXPECT_FALSE(queue.Pop(value));
+    EXPECT_TRUE(queue.Empty());
+}
+
+TEST(SPSCQueueTest, Concurrent) {
+    const long N = 1000000;
+    SPSCQueue<long> queue(128);
+
+    std::thread producer([&queue, N]() {
+        for (long i = 0; i < N; i++) {
+            while (!queue.Push(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    bool ordered = true;
+    long value;
+    for (long i = 0; i < N; i++) {
+        while (!queue.Pop(value)) {
+            std::this_thread::yield();
+        }
+        ordered = ordered && value == i;
+    }
+    producer.join();
+
+    EXPECT_TRUE(ordered);
+    EXPECT_TRUE(queue.Empty());
+}
@@ -0,0 +1,103 @@
+#include "gtest/gtest.h"
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+#include <network/uv/ServerImpl.h>
+#include <storage/MapBasedGlobalLockImpl.h>
+
+using namespace Afina;
+
+namespace {
+
+// Port that nobody listens on right now
+uint16_t FreePort() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr));
+    socklen_t len = sizeof(addr);
+    getsockname(fd, reinterpret_cast<struct sockaddr *>(&addr), &len);
+    close(fd);
+    return ntohs(addr.sin_port);
+}
+
+int Connect(uint16_t port) {
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    for (int attempt = 0; attempt < 100; attempt++) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == 0) {
+            return fd;
+        }
+        close(fd);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return -1;
+}
+
+// Sends request and reads reply until it has the given number of END lines
+std::string Request(int fd, const std::string &request, int ends) {
+    for (size_t sent = 0; sent < request.size();) {
+        ssize_t n = write(fd, request.data() + sent, request.size() - sent);
+        if (n <= 0) {
+            return "";
+        }
+        sent += n;
+    }
+
+    std::string reply;
+    char buf[65536];
+    size_t found = 0;
+    while (ends > 0) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n <= 0) {
+            break;
+        }
+        reply.append(buf, n);
+        while ((found = reply.find("END\r\n", found)) != std::string::npos) {
+            found += 5;
+            ends--;
+        }
+        found = reply.size() < 4 ? 0 : reply.size() - 4;
+    }
+    return reply;
+}
+
+} // namespace
+
+TEST(ServerTest, LargeValuesInBuddyRegion) {
+    // Sized the way server sizes storage by default
+    auto storage = std::make_shared<Backend::MapBasedGlobalLockImpl>(64 << 20);
+    storage->Start();
+    Network::UV::ServerImpl server(storage);
+    uint16_t port = FreePort();
+    server.Start(port, 1);
+
+    int fd = Connect(port);
+    ASSERT_GE(fd, 0);
+    std::string value(200000, 'v');
+    std::string reply = Request(fd, "set big 0 0 200000\r\n" + value + "\r\nget big\r\nstats\r\n", 2);
+    close(fd);
+
+    server.Stop();
+    server.Join();
+    storage->Stop();
+
+    EXPECT_EQ(reply.compare(0, 8, "STORED\r\n"), 0);
+    EXPECT_NE(reply.find("VALUE big 0 200000\r\n" + value + "\r\nEND\r\n"), std::string::npos);
+    EXPECT_NE(reply.find("STAT values_region_allocated 262144\r\n"), std::string::npos);
+    EXPECT_NE(reply.find("STAT values_region_overflows 0\r\n"), std::string::npos);
+}
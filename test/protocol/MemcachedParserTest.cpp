@@ -3,9 +3,15 @@
 #include <memory>
 #include <string>
 
+#include <afina/allocator/Bump.h>
 #include <afina/execute/Add.h>
+#include <afina/execute/Delete.h>
 #include <afina/execute/Get.h>
+#include <afina/execute/LeaseGet.h>
+#include <afina/execute/LeaseSet.h>
 #include <afina/execute/Set.h>
+#include <afina/execute/FlushAll.h>
+#include <afina/execute/Load.h>
 #include <afina/execute/Stats.h>
 
 #include <protocol/Parser.h>
@@ -74,13 +80,41 @@ TEST(MemcachedParserTest, SimpleGet) {
     ASSERT_EQ(0, value_size);
 
     Execute::Get *tmp = reinterpret_cast<Execute::Get *>(cmd.get());
-    std::vector<std::string> keys = tmp->keys();
+    Execute::Get::Keys keys = tmp->keys();
     ASSERT_EQ(3, keys.size());
     ASSERT_EQ("ke", keys[0]);
     ASSERT_EQ("key2", keys[1]);
     ASSERT_EQ("super_long_key", keys[2]);
 }
 
+// Keys live in the arena and are moved into the command, part of the next command survives arena reset
+TEST(MemcachedParserTest, ArenaKeys) {
+    Allocator::Bump arena("test.parser");
+    Protocol::Parser parser(arena);
+
+    size_t consumed = 0;
+    ASSERT_TRUE(parser.Parse("get some_long_key_of_the_first_get\r\n", consumed));
+    uint32_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    const Execute::Get::Keys &keys = reinterpret_cast<Execute::Get *>(cmd.get())->keys();
+    ASSERT_EQ(1u, keys.size());
+    ASSERT_EQ("some_long_key_of_the_first_get", keys[0]);
+    ASSERT_EQ(&arena, &keys.get_allocator().resource());
+    cmd.reset();
+
+    parser.Reset();
+    ASSERT_FALSE(parser.Parse("get first_long_key_of_the_second_get second_lo", consumed));
+    parser.Rebase(arena);
+    ASSERT_TRUE(parser.Parse("ng_key_of_the_second_get\r\n", consumed));
+    cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    const Execute::Get::Keys &next = reinterpret_cast<Execute::Get *>(cmd.get())->keys();
+    ASSERT_EQ(2u, next.size());
+    ASSERT_EQ("first_long_key_of_the_second_get", next[0]);
+    ASSERT_EQ("second_long_key_of_the_second_get", next[1]);
+}
+
 TEST(MemcachedParserTest, Stats) {
     Protocol::Parser parser;
 
@@ -98,3 +132,135 @@ TEST(MemcachedParserTest, Stats) {
     Execute::Stats *tmp = reinterpret_cast<Execute::Stats *>(cmd.get());
 	ASSERT_FALSE(tmp == nullptr);
 }
+
+TEST(MemcachedParserTest, StatsGroup) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    bool cmd_avail = parser.Parse("stats items\r\n", consumed);
+    ASSERT_TRUE(cmd_avail);
+    ASSERT_EQ(13u, consumed);
+    ASSERT_EQ("stats", parser.Name());
+
+    uint32_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ(0u, value_size);
+
+    Execute::Stats *tmp = reinterpret_cast<Execute::Stats *>(cmd.get());
+    ASSERT_EQ("items", tmp->group());
+}
+
+TEST(MemcachedParserTest, Load) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    bool cmd_avail = parser.Parse("load /tmp/items.dump\r\n", consumed);
+    ASSERT_TRUE(cmd_avail);
+    ASSERT_EQ(22u, consumed);
+    ASSERT_EQ("load", parser.Name());
+
+    uint32_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ(0u, value_size);
+
+    Execute::Load *tmp = reinterpret_cast<Execute::Load *>(cmd.get());
+    ASSERT_EQ("/tmp/items.dump", tmp->path());
+
+    parser.Reset();
+    ASSERT_THROW(parser.Parse("load\r\n", consumed), std::runtime_error);
+}
+
+TEST(MemcachedParserTest, FlushAll) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    ASSERT_TRUE(parser.Parse("flush_all\r\n", consumed));
+    uint32_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ(0u, reinterpret_cast<Execute::FlushAll *>(cmd.get())->delay());
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("flush_all 30\r\n", consumed));
+    cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ(30u, reinterpret_cast<Execute::FlushAll *>(cmd.get())->delay());
+    ASSERT_FALSE(parser.NoReply());
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("flush_all noreply\r\n", consumed));
+    ASSERT_TRUE(parser.NoReply());
+    cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ(0u, reinterpret_cast<Execute::FlushAll *>(cmd.get())->delay());
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("flush_all 30 noreply\r\n", consumed));
+    ASSERT_TRUE(parser.NoReply());
+    cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ(30u, reinterpret_cast<Execute::FlushAll *>(cmd.get())->delay());
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("flush_all soon\r\n", consumed));
+    ASSERT_THROW(parser.Build(value_size), std::runtime_error);
+}
+
+TEST(MemcachedParserTest, Delete) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    ASSERT_TRUE(parser.Parse("delete foo\r\n", consumed));
+    ASSERT_EQ(12u, consumed);
+    uint32_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ(0u, value_size);
+    ASSERT_EQ("foo", reinterpret_cast<Execute::Delete *>(cmd.get())->key());
+    ASSERT_FALSE(parser.NoReply());
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("delete foo noreply\r\n", consumed));
+    ASSERT_TRUE(parser.NoReply());
+    cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ("foo", reinterpret_cast<Execute::Delete *>(cmd.get())->key());
+
+    parser.Reset();
+    ASSERT_FALSE(parser.NoReply());
+    ASSERT_TRUE(parser.Parse("delete foo bar\r\n", consumed));
+    ASSERT_THROW(parser.Build(value_size), std::runtime_error);
+
+    parser.Reset();
+    ASSERT_THROW(parser.Parse("delete\r\n", consumed), std::runtime_error);
+}
+
+TEST(MemcachedParserTest, Leases) {
+    Protocol::Parser parser;
+
+    size_t consumed = 0;
+    ASSERT_TRUE(parser.Parse("lget foo\r\n", consumed));
+    uint32_t value_size;
+    std::unique_ptr<Execute::Command> cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ("foo", reinterpret_cast<Execute::LeaseGet *>(cmd.get())->key());
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("lset foo 0 0 3 12345678901\r\n", consumed));
+    cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+    ASSERT_EQ(3u, value_size);
+    Execute::LeaseSet *lset = reinterpret_cast<Execute::LeaseSet *>(cmd.get());
+    ASSERT_EQ("foo", lset->key());
+    ASSERT_EQ(12345678901ULL, lset->token());
+
+    parser.Reset();
+    ASSERT_TRUE(parser.Parse("invalidate foo\r\n", consumed));
+    cmd = parser.Build(value_size);
+    ASSERT_FALSE(cmd == nullptr);
+
+    parser.Reset();
+    ASSERT_THROW(parser.Parse("lget\r\n", consumed), std::runtime_error);
+}
@@ -0,0 +1,102 @@
+#include "gtest/gtest.h"
+#include <string>
+#include <vector>
+
+#include <storage/ARCPolicy.h>
+#include <storage/HashIndex.h>
+
+using namespace Afina::Backend;
+using namespace std;
+
+static Entry *NewEntry(const string &key) {
+    Entry *e = new Entry();
+    e->key = key;
+    e->value = "v";
+    e->hash = HashIndex::Hash(key);
+    return e;
+}
+
+// Evicts victims until policy holds no more than capacity bytes, returns number of evictions
+static size_t Shrink(ARCPolicy &policy, size_t &size, size_t capacity) {
+    size_t evicted = 0;
+    while (size > capacity) {
+        Entry *victim = policy.Victim();
+        size -= victim->key.size() + victim->value.size();
+        policy.Remove(victim, true);
+        evicted++;
+    }
+    return evicted;
+}
+
+TEST(ARCPolicyTest, FrequentSurviveScan) {
+    // Keys are 5 bytes with value, so 100 entries fit
+    const size_t capacity = 500;
+    ARCPolicy policy(capacity);
+    size_t size = 0;
+
+    // Working set is accessed twice and gets into T2
+    vector<Entry *> hot;
+    for (int i = 0; i < 50; i++) {
+        hot.push_back(NewEntry("h" + to_string(1000 + i)));
+        policy.Insert(hot.back());
+        size += 6;
+    }
+    for (Entry *e : hot) {
+        policy.Touch(e);
+        EXPECT_TRUE(e->frequent);
+    }
+
+    // Long scan of keys seen once evicts only from T1
+    for (int i = 0; i < 1000; i++) {
+        Entry *e = NewEntry("s" + to_string(1000 + i));
+        policy.Insert(e);
+        size += 6;
+        Shrink(policy, size, capacity);
+    }
+
+    Afina::Storage::StatsList stats;
+    policy.GetStats(stats);
+    EXPECT_EQ("arc_t2_bytes", stats[2].first);
+    EXPECT_EQ("300", stats[2].second);
+
+    // Victims are taken from T1 while it is above target
+    Entry *victim = policy.Victim();
+    EXPECT_FALSE(victim->frequent);
+    while (size > 0) {
+        Shrink(policy, size, size - 1);
+    }
+}
+
+TEST(ARCPolicyTest, AdaptsTarget) {
+    const size_t capacity = 60;
+    ARCPolicy policy(capacity);
+    size_t size = 0;
+
+    // Half of the cache is taken by T2, so T1 and its ghosts share the rest
+    for (int i = 0; i < 5; i++) {
+        Entry *e = NewEntry("f" + to_string(1000 + i));
+        policy.Insert(e);
+        policy.Touch(e);
+        size += 6;
+    }
+    for (int i = 0; i < 20; i++) {
+        policy.Insert(NewEntry("k" + to_string(1000 + i)));
+        size += 6;
+        Shrink(policy, size, capacity);
+    }
+
+    // Miss on the key recently evicted from T1 grows T1 target and inserts key into T2
+    Entry *back = NewEntry("k1012");
+    policy.Insert(back);
+    size += 6;
+    EXPECT_TRUE(back->frequent);
+
+    Afina::Storage::StatsList stats;
+    policy.GetStats(stats);
+    EXPECT_EQ("arc_target", stats[0].first);
+    EXPECT_EQ("6", stats[0].second);
+
+    while (size > 0) {
+        Shrink(policy, size, size - 1);
+    }
+}
@@ -0,0 +1,71 @@
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <storage/Dump.h>
+
+using namespace Afina::Backend;
+using namespace std;
+
+static string TempPath() { return "/tmp/afina_dump_test_" + to_string(getpid()); }
+
+TEST(DumpTest, WriteRead) {
+    string path = TempPath();
+    {
+        DumpWriter writer(path);
+        writer.Write("key", 1, 0, "value");
+        writer.Write("", 2, -1, "");
+        writer.Write("big", 3, 100, string(100000, 'x'));
+        writer.Close();
+    }
+
+    DumpReader reader(path);
+    vector<size_t> offsets = reader.Offsets();
+    ASSERT_EQ(3u, offsets.size());
+
+    DumpRecord record = reader.Read(offsets[0]);
+    EXPECT_EQ("key", string(record.key, record.key_len));
+    EXPECT_EQ("value", string(record.value, record.value_len));
+    EXPECT_EQ(1u, record.flags);
+    EXPECT_EQ(0, record.exptime);
+
+    record = reader.Read(offsets[1]);
+    EXPECT_EQ(0u, record.key_len);
+    EXPECT_EQ(0u, record.value_len);
+    EXPECT_EQ(-1, record.exptime);
+
+    record = reader.Read(offsets[2]);
+    EXPECT_EQ(string(100000, 'x'), string(record.value, record.value_len));
+    EXPECT_EQ(100, record.exptime);
+
+    unlink(path.c_str());
+}
+
+TEST(DumpTest, Truncated) {
+    string path = TempPath();
+    {
+        DumpWriter writer(path);
+        writer.Write("key", 1, 0, "value");
+        writer.Close();
+    }
+    ASSERT_EQ(0, truncate(path.c_str(), 8 + 16 + 4));
+
+    DumpReader reader(path);
+    EXPECT_THROW(reader.Offsets(), std::runtime_error);
+    unlink(path.c_str());
+}
+
+TEST(DumpTest, NotDump) {
+    string path = TempPath();
+    FILE *f = fopen(path.c_str(), "w");
+    fputs("set a 0 0 1\r\na\r\n", f);
+    fclose(f);
+
+    EXPECT_THROW(DumpReader reader(path), std::runtime_error);
+    EXPECT_THROW(DumpReader reader(path + ".missing"), std::runtime_error);
+    unlink(path.c_str());
+}
@@ -0,0 +1,48 @@
+#include "gtest/gtest.h"
+
+#include <storage/GhostList.h>
+
+using namespace Afina::Backend;
+using namespace std;
+
+TEST(GhostListTest, Distance) {
+    GhostList ghosts(100);
+    ghosts.Add(1, 10);
+    ghosts.Add(2, 20);
+    ghosts.Add(3, 30);
+    EXPECT_EQ(3u, ghosts.Size());
+
+    // Bytes evicted since the key inclusive
+    EXPECT_EQ(60u, ghosts.Take(1));
+    EXPECT_EQ(30u, ghosts.Take(3));
+    EXPECT_EQ(0u, ghosts.Take(1));
+    EXPECT_EQ(0u, ghosts.Take(4));
+    EXPECT_EQ(1u, ghosts.Size());
+}
+
+TEST(GhostListTest, Bounded) {
+    GhostList ghosts(100);
+    for (size_t i = 0; i < 1000; i++) {
+        ghosts.Add(i, 10);
+    }
+    EXPECT_EQ(10u, ghosts.Size());
+    EXPECT_EQ(0u, ghosts.Take(989));
+    EXPECT_EQ(100u, ghosts.Take(990));
+
+    // Evicted again, only the latest eviction counts
+    ghosts.Add(995, 10);
+    EXPECT_EQ(10u, ghosts.Take(995));
+    EXPECT_EQ(8u, ghosts.Size());
+}
+
+TEST(GhostListTest, Sampled) {
+    GhostList ghosts(1000, 3);
+    for (size_t i = 0; i < 64; i++) {
+        ghosts.Add(i << 48, 10);
+    }
+
+    // Distance accounts evictions of keys that are not sampled
+    EXPECT_EQ(8u, ghosts.Size());
+    EXPECT_EQ(0u, ghosts.Take(size_t(63) << 48));
+    EXPECT_EQ(80u, ghosts.Take(size_t(56) << 48));
+}
@@ -0,0 +1,145 @@
+#include "gtest/gtest.h"
+#include <set>
+#include <string>
+#include <vector>
+
+#include <storage/HashIndex.h>
+
+using namespace Afina::Backend;
+using namespace std;
+
+static Entry *NewEntry(const string &key) {
+    Entry *e = new Entry();
+    e->key = key;
+    e->hash = HashIndex::Hash(key);
+    return e;
+}
+
+TEST(HashIndexTest, InsertFindRemove) {
+    HashIndex index;
+    vector<Entry *> entries;
+
+    for (int i = 0; i < 1000; i++) {
+        entries.push_back(NewEntry("Key" + to_string(i)));
+        index.Insert(entries.back());
+    }
+    EXPECT_EQ(1000u, index.Size());
+
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_EQ(entries[i], index.Find("Key" + to_string(i)));
+    }
+    EXPECT_EQ(nullptr, index.Find("Key1000"));
+
+    for (int i = 0; i < 1000; i += 2) {
+        index.Remove(entries[i]);
+    }
+    EXPECT_EQ(500u, index.Size());
+
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_EQ(i % 2 == 0 ? nullptr : entries[i], index.Find("Key" + to_string(i)));
+    }
+
+    for (auto e : entries) {
+        delete e;
+    }
+}
+
+TEST(HashIndexTest, LookupDuringMigration) {
+    HashIndex index;
+    vector<Entry *> entries;
+
+    // Insert until resize starts, all entries must be visible while buckets migrate
+    int i = 0;
+    while (!index.Rehashing()) {
+        entries.push_back(NewEntry("Key" + to_string(i++)));
+        index.Insert(entries.back());
+    }
+
+    size_t found = 0;
+    for (int j = 0; j < i; j++) {
+        found += index.Find("Key" + to_string(j)) == entries[j];
+    }
+    EXPECT_EQ(entries.size(), found);
+
+    // Removal must work for entries from both old and new tables
+    for (auto e : entries) {
+        index.Remove(e);
+        delete e;
+    }
+    EXPECT_EQ(0u, index.Size());
+}
+
+TEST(HashIndexTest, Presize) {
+    HashIndex index(10000);
+    size_t buckets = index.Buckets();
+    EXPECT_GE(buckets, 10000u);
+
+    vector<Entry *> entries;
+    for (int i = 0; i < 10000; i++) {
+        entries.push_back(NewEntry("Key" + to_string(i)));
+        index.Insert(entries.back());
+        EXPECT_FALSE(index.Rehashing());
+    }
+    EXPECT_EQ(buckets, index.Buckets());
+
+    for (auto e : entries) {
+        delete e;
+    }
+}
+
+TEST(HashIndexTest, BulkInsert) {
+    vector<Entry *> entries;
+    for (int i = 0; i < 10000; i++) {
+        entries.push_back(NewEntry("Key" + to_string(i)));
+    }
+
+    // Later entry with the same key wins
+    Entry *dup = NewEntry("Key42");
+    entries.push_back(dup);
+
+    HashIndex index;
+    vector<Entry *> duplicates = index.BulkInsert(entries, 4);
+    ASSERT_EQ(1u, duplicates.size());
+    EXPECT_EQ(entries[42], duplicates[0]);
+    EXPECT_EQ(10000u, index.Size());
+    EXPECT_FALSE(index.Rehashing());
+
+    for (int i = 0; i < 10000; i++) {
+        EXPECT_EQ(i == 42 ? dup : entries[i], index.Find("Key" + to_string(i)));
+    }
+
+    for (auto e : entries) {
+        delete e;
+    }
+}
+
+TEST(HashIndexTest, ScanWhileGrowing) {
+    HashIndex index;
+    vector<Entry *> entries;
+    for (int i = 0; i < 100; i++) {
+        entries.push_back(NewEntry("Key" + to_string(i)));
+        index.Insert(entries.back());
+    }
+
+    // Index grows and migrates between steps, entries present from the start must be visited anyway
+    set<const Entry *> visited;
+    size_t cursor = 0;
+    int next = 100;
+    do {
+        cursor = index.Scan(cursor, 4, [&visited](const Entry *e) { visited.insert(e); });
+        for (int i = 0; i < 50 && next < 2000; i++, next++) {
+            entries.push_back(NewEntry("Key" + to_string(next)));
+            index.Insert(entries.back());
+        }
+    } while (cursor != 0);
+
+    EXPECT_TRUE(index.Buckets() > 128);
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(1u, visited.count(entries[i])) << i;
+    }
+
+    for (Entry *e : entries) {
+        index.Remove(e);
+        delete e;
+    }
+}
@@ -0,0 +1,88 @@
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <storage/HugePages.h>
+#include <storage/MapBasedGlobalLockImpl.h>
+
+using namespace Afina::Backend;
+using namespace std;
+
+TEST(HugePagesTest, Alloc) {
+    HugePageUsage before = GetHugePageUsage();
+
+    size_t size = 3 * HugePageSize + 100;
+    char *p = static_cast<char *>(HugeAlloc(size));
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(p) % HugePageSize);
+    for (size_t i = 0; i < size; i += 4096) {
+        ASSERT_EQ(0, p[i]);
+        p[i] = 1;
+    }
+
+    HugePageUsage usage = GetHugePageUsage();
+    EXPECT_EQ(before.mapped + 4 * HugePageSize, usage.mapped);
+    EXPECT_LE(usage.hugetlb + usage.transparent, usage.mapped);
+
+    HugeFree(p, size);
+    EXPECT_EQ(before.mapped, GetHugePageUsage().mapped);
+}
+
+TEST(HugePagesTest, Pool) {
+    HugePagePool pool(40);
+
+    int foreign;
+    EXPECT_FALSE(pool.Free(&foreign));
+
+    // More than fits into a single chunk
+    vector<char *> objects;
+    for (size_t i = 0; i < HugePageSize / 48 + 10; i++) {
+        objects.push_back(static_cast<char *>(pool.Allocate()));
+        objects.back()[0] = 'x';
+        objects.back()[39] = 'y';
+    }
+    EXPECT_NE(objects[0], objects[1]);
+    EXPECT_FALSE(pool.Free(&foreign));
+
+    for (auto p : objects) {
+        EXPECT_TRUE(pool.Free(p));
+    }
+
+    // Freed objects are reused
+    void *p = pool.Allocate();
+    EXPECT_EQ(objects.back(), p);
+}
+
+TEST(HugePagesTest, Storage) {
+    EnableHugePages(true);
+    {
+        MapBasedGlobalLockImpl storage(1 << 24, true, 1 << 20);
+        for (int i = 0; i < 10000; i++) {
+            storage.Put("Key" + to_string(i), "Val" + to_string(i));
+        }
+
+        string value;
+        for (int i = 0; i < 10000; i++) {
+            ASSERT_TRUE(storage.Get("Key" + to_string(i), value));
+            ASSERT_EQ("Val" + to_string(i), value);
+        }
+
+        Afina::Storage::StatsList stats;
+        storage.GetStats("", stats);
+        bool reported = false;
+        for (auto &stat : stats) {
+            reported = reported || (stat.first == "huge_pages_mapped" && stoul(stat.second) >= 8 * (1 << 20));
+        }
+        EXPECT_TRUE(reported);
+    }
+    EnableHugePages(false);
+
+    // Entries allocated before switch are released properly
+    MapBasedGlobalLockImpl storage;
+    EnableHugePages(true);
+    storage.Put("a", "b");
+    EnableHugePages(false);
+    storage.Put("c", "d");
+    EXPECT_TRUE(storage.Delete("a"));
+    EXPECT_TRUE(storage.Delete("c"));
+}
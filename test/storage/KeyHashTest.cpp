@@ -0,0 +1,56 @@
+#include "gtest/gtest.h"
+#include <set>
+#include <string>
+#include <vector>
+
+#include <storage/KeyHash.h>
+
+using namespace Afina::Backend;
+using namespace std;
+
+TEST(KeyHashTest, Deterministic) {
+    for (size_t len = 0; len < 200; len++) {
+        string key(len, 'k');
+        EXPECT_EQ(KeyHash(key), KeyHash(key.data(), key.size()));
+    }
+}
+
+TEST(KeyHashTest, AllBytesMatter) {
+    // Flipping any byte of keys of various lengths must change hash
+    for (size_t len = 1; len < 130; len++) {
+        string key(len, 'a');
+        uint64_t h = KeyHash(key);
+        for (size_t i = 0; i < len; i++) {
+            string other = key;
+            other[i] = 'b';
+            EXPECT_NE(h, KeyHash(other)) << "len=" << len << " pos=" << i;
+        }
+    }
+}
+
+TEST(KeyHashTest, LowBitsSpread) {
+    const size_t Buckets = 1024;
+    vector<size_t> hits(Buckets, 0);
+
+    for (size_t i = 0; i < 100 * Buckets; i++) {
+        hits[KeyHash("user:session:" + to_string(i)) & (Buckets - 1)]++;
+    }
+
+    for (auto h : hits) {
+        EXPECT_GT(h, 50u);
+        EXPECT_LT(h, 150u);
+    }
+}
+
+TEST(KeyHashTest, Shard) {
+    vector<size_t> hits(3, 0);
+    for (size_t i = 0; i < 30000; i++) {
+        size_t shard = KeyHashShard(KeyHash("Key" + to_string(i)), 3);
+        ASSERT_LT(shard, 3u);
+        hits[shard]++;
+    }
+
+    for (auto h : hits) {
+        EXPECT_GT(h, 9000u);
+    }
+}
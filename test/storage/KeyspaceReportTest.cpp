@@ -0,0 +1,49 @@
+#include "gtest/gtest.h"
+#include <string>
+
+#include <storage/KeyspaceReport.h>
+
+using namespace Afina::Backend;
+using namespace std;
+
+static string Find(const Afina::Storage::StatsList &stats, const string &name) {
+    for (auto &stat : stats) {
+        if (stat.first == name) {
+            return stat.second;
+        }
+    }
+    return "";
+}
+
+TEST(KeyspaceReportTest, Report) {
+    KeyspaceReport report(2, 1);
+    for (int i = 0; i < 100; i++) {
+        report.Add("user:" + to_string(i), 10, 30);
+    }
+    report.Add("session:1", 5000, 700);
+    report.Add("session:2", 3000, 100000);
+    report.Add("plain", 100, 0);
+
+    Afina::Storage::StatsList stats;
+    report.Report(stats);
+    EXPECT_EQ(103u, report.Items());
+    EXPECT_EQ("103", Find(stats, "keyspace_items"));
+
+    EXPECT_EQ("100", Find(stats, "value_size_le_16"));
+    EXPECT_EQ("1", Find(stats, "value_size_le_128"));
+    EXPECT_EQ("1", Find(stats, "value_size_le_4096"));
+    EXPECT_EQ("1", Find(stats, "value_size_le_8192"));
+
+    EXPECT_EQ("5000", Find(stats, "bigkey:session:1"));
+    EXPECT_EQ("3000", Find(stats, "bigkey:session:2"));
+    EXPECT_EQ("", Find(stats, "bigkey:plain"));
+
+    // session prefix takes more memory than 100 small users
+    EXPECT_EQ("2 8018", Find(stats, "prefix:session"));
+    EXPECT_EQ("", Find(stats, "prefix:user"));
+    EXPECT_EQ("101 1795", Find(stats, "prefix_other"));
+
+    EXPECT_EQ("101", Find(stats, "idle_le_60s"));
+    EXPECT_EQ("1", Find(stats, "idle_le_3600s"));
+    EXPECT_EQ("1", Find(stats, "idle_gt_86400s"));
+}
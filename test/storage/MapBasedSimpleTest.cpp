@@ -0,0 +1,234 @@
+#include "gtest/gtest.h"
+#include <atomic>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <storage/MapBasedSimpleImpl.h>
+
+using namespace Afina::Backend;
+
+namespace {
+
+std::string GetStat(const MapBasedSimpleImpl &storage, const std::string &name) {
+    Afina::Storage::StatsList stats;
+    storage.GetStats("", stats);
+    for (auto &stat : stats) {
+        if (stat.first == name) {
+            return stat.second;
+        }
+    }
+    return "";
+}
+
+} // namespace
+
+TEST(MapBasedSimpleTest, PutGetDelete) {
+    MapBasedSimpleImpl storage(4096);
+
+    EXPECT_TRUE(storage.Put("KEY1", "val1"));
+    EXPECT_TRUE(storage.PutIfAbsent("KEY2", "val2"));
+    EXPECT_FALSE(storage.PutIfAbsent("KEY2", "other"));
+    EXPECT_FALSE(storage.Set("KEY3", "val3"));
+    EXPECT_TRUE(storage.Set("KEY1", "longer value 1"));
+
+    std::string value;
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("longer value 1", value);
+    EXPECT_TRUE(storage.Get("KEY2", value));
+    EXPECT_EQ("val2", value);
+
+    EXPECT_TRUE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Delete("KEY1"));
+    EXPECT_FALSE(storage.Get("KEY1", value));
+    EXPECT_EQ("8", GetStat(storage, "bytes"));
+
+    storage.FlushAll(0);
+    EXPECT_FALSE(storage.Get("KEY2", value));
+    EXPECT_EQ("0", GetStat(storage, "region_used"));
+}
+
+// Region is never exceeded: the least recently used values are evicted, value larger than region is rejected
+TEST(MapBasedSimpleTest, Eviction) {
+    MapBasedSimpleImpl storage(4096);
+
+    std::string value(100, 'v');
+    for (int i = 0; i < 100; i++) {
+        ASSERT_TRUE(storage.Put("key" + std::to_string(i), value));
+
+        std::string out;
+        ASSERT_TRUE(storage.Get("key0", out));
+    }
+
+    std::string out;
+    EXPECT_TRUE(storage.Get("key0", out));
+    EXPECT_TRUE(storage.Get("key99", out));
+    EXPECT_FALSE(storage.Get("key1", out));
+    EXPECT_NE("0", GetStat(storage, "evictions"));
+
+    EXPECT_FALSE(storage.Put("huge", std::string(4096, 'h')));
+    EXPECT_TRUE(storage.Get("key99", out));
+}
+
+// Holes left by deletes are closed by incremental compaction steps, so large value fits without evicting others
+TEST(MapBasedSimpleTest, Defrag) {
+    MapBasedSimpleImpl storage(64 * 1024);
+
+    std::string value(200, 'v');
+    int n = 0;
+    while (GetStat(storage, "evictions") == "0") {
+        ASSERT_TRUE(storage.Put("key" + std::to_string(n++), value));
+    }
+    // The first value is evicted, the last one is removed to leave no gap at the top
+    storage.Delete("key" + std::to_string(n - 1));
+
+    // Every other value is freed, none of the holes fits the larger value
+    for (int i = 1; i < n - 1; i += 2) {
+        storage.Delete("key" + std::to_string(i));
+    }
+    size_t items = std::stoul(GetStat(storage, "curr_items"));
+    EXPECT_NE("0", GetStat(storage, "region_defrag_steps"));
+    EXPECT_NE("0", GetStat(storage, "region_moved_bytes"));
+
+    ASSERT_TRUE(storage.Put("large", std::string(2000, 'l')));
+    EXPECT_EQ("0", GetStat(storage, "region_defrags"));
+    EXPECT_EQ(std::to_string(items + 1), GetStat(storage, "curr_items"));
+
+    std::string out;
+    for (int i = 2; i < n - 1; i += 2) {
+        ASSERT_TRUE(storage.Get("key" + std::to_string(i), out));
+        ASSERT_EQ(value, out);
+    }
+}
+
+// Values read back are always the last ones written, whatever was moved or evicted
+TEST(MapBasedSimpleTest, RandomChurn) {
+    MapBasedSimpleImpl storage(32 * 1024);
+    std::map<std::string, std::string> model;
+    std::mt19937 rnd(1);
+
+    for (int i = 0; i < 20000; i++) {
+        std::string key = "key" + std::to_string(rnd() % 300);
+        int op = rnd() % 4;
+        if (op == 0) {
+            storage.Delete(key);
+            model.erase(key);
+        } else if (op == 1) {
+            std::string value(rnd() % 500, 'a' + rnd() % 26);
+            ASSERT_TRUE(storage.Put(key, value));
+            model[key] = value;
+        } else {
+            std::string out;
+            if (storage.Get(key, out)) {
+                ASSERT_EQ(model[key], out);
+            }
+        }
+    }
+    EXPECT_NE("0", GetStat(storage, "region_defrags"));
+}
+
+// Appended value grows in place or moves once per doubling, so its block is never more than twice the value
+TEST(MapBasedSimpleTest, Append) {
+    MapBasedSimpleImpl storage(1024 * 1024);
+
+    std::string value;
+    EXPECT_FALSE(storage.Append("key", "data"));
+    ASSERT_TRUE(storage.Put("key", ""));
+    for (int i = 0; i < 100; i++) {
+        ASSERT_TRUE(storage.Put("other" + std::to_string(i), std::string(100, 'o')));
+    }
+
+    std::string expected;
+    for (int i = 0; i < 10000; i++) {
+        std::string data(10, 'a' + i % 26);
+        ASSERT_TRUE(storage.Append("key", data));
+        expected.append(data);
+    }
+    EXPECT_TRUE(storage.Get("key", value));
+    EXPECT_EQ(expected, value);
+    EXPECT_LE(std::stoul(GetStat(storage, "region_used")), 2 * expected.size() + 100 * 112);
+    EXPECT_EQ("0", GetStat(storage, "evictions"));
+
+    // Value larger than region is rejected and left as is
+    EXPECT_FALSE(storage.Append("key", std::string(1024 * 1024, 'x')));
+    EXPECT_TRUE(storage.Get("key", value));
+    EXPECT_EQ(expected.size(), value.size());
+
+    // Put gives reserved room back
+    ASSERT_TRUE(storage.Put("key", "short"));
+    EXPECT_LE(std::stoul(GetStat(storage, "region_used")), 100 * 112 + 16u);
+}
+
+// Large values are read without the lock while writers replace, delete and compact them
+TEST(MapBasedSimpleTest, PinnedReads) {
+    MapBasedSimpleImpl storage(1024 * 1024);
+
+    std::atomic<bool> stop(false);
+    std::atomic<int> torn(0);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([&storage, &stop, &torn, t]() {
+            std::string out;
+            while (!stop) {
+                if (storage.Get("key" + std::to_string(t % 2), out) &&
+                    out.find_first_not_of(out[0]) != std::string::npos) {
+                    torn++;
+                }
+            }
+        });
+    }
+
+    std::mt19937 rnd(1);
+    for (int i = 0; i < 2000; i++) {
+        std::string key = "key" + std::to_string(rnd() % 4);
+        if (rnd() % 8 == 0) {
+            storage.Delete(key);
+        } else {
+            storage.Put(key, std::string(16 * 1024 + rnd() % (64 * 1024), 'a' + i % 26));
+        }
+    }
+    stop = true;
+
+    for (auto &reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(0, torn);
+
+    // Flushed values are reclaimed once touched, none of them is left pinned
+    storage.FlushAll(0);
+    for (int i = 0; i < 4; i++) {
+        EXPECT_FALSE(storage.Delete("key" + std::to_string(i)));
+    }
+    EXPECT_EQ("0", GetStat(storage, "region_used"));
+}
+
+// Flush only bumps generation, flushed values are reclaimed once touched or evicted
+TEST(MapBasedSimpleTest, FlushAll) {
+    MapBasedSimpleImpl storage(4096);
+    for (int i = 0; i < 10; i++) {
+        ASSERT_TRUE(storage.Put("key" + std::to_string(i), std::string(100, 'v')));
+    }
+
+    storage.FlushAll(0);
+    EXPECT_EQ("0", GetStat(storage, "curr_items"));
+    EXPECT_EQ("10", GetStat(storage, "stale_items"));
+
+    std::string value;
+    EXPECT_FALSE(storage.Get("key1", value));
+    EXPECT_FALSE(storage.Set("key2", "new"));
+    EXPECT_FALSE(storage.Append("key3", "new"));
+    EXPECT_TRUE(storage.PutIfAbsent("key4", "new"));
+    EXPECT_TRUE(storage.Get("key4", value));
+    EXPECT_EQ("new", value);
+    EXPECT_EQ("1", GetStat(storage, "curr_items"));
+    EXPECT_EQ("6", GetStat(storage, "stale_items"));
+
+    // The rest goes away with eviction
+    for (int i = 0; i < 100; i++) {
+        ASSERT_TRUE(storage.Put("other" + std::to_string(i), std::string(100, 'v')));
+    }
+    EXPECT_EQ("0", GetStat(storage, "stale_items"));
+    EXPECT_FALSE(storage.Get("key0", value));
+}
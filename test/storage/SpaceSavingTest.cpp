@@ -0,0 +1,68 @@
+#include "gtest/gtest.h"
+#include <string>
+
+#include <storage/SpaceSaving.h>
+
+using namespace Afina::Backend;
+using namespace std;
+
+TEST(SpaceSavingTest, ExactWhileFits) {
+    SpaceSaving sketch(4);
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j <= i; j++) {
+            sketch.Add("Key" + to_string(i));
+        }
+    }
+
+    auto top = sketch.Top(10);
+    ASSERT_EQ(4u, top.size());
+    for (size_t i = 0; i < 4; i++) {
+        EXPECT_EQ("Key" + to_string(3 - i), top[i].key);
+        EXPECT_EQ(4 - i, top[i].count);
+        EXPECT_EQ(0u, top[i].error);
+    }
+    EXPECT_EQ(10u, sketch.Total());
+}
+
+TEST(SpaceSavingTest, FindsHeavyHitters) {
+    SpaceSaving sketch(16);
+
+    // Two keys take 20% and 10% of stream, the rest is spread over thousands of keys
+    for (int i = 0; i < 100000; i++) {
+        if (i % 5 == 0) {
+            sketch.Add("heavy");
+        } else if (i % 10 == 1) {
+            sketch.Add("medium");
+        } else {
+            sketch.Add("Key" + to_string(i % 7919));
+        }
+    }
+
+    auto top = sketch.Top(2);
+    ASSERT_EQ(2u, top.size());
+    EXPECT_EQ("heavy", top[0].key);
+    EXPECT_EQ("medium", top[1].key);
+
+    // Count is overestimated by at most error
+    EXPECT_GE(top[0].count, 20000u);
+    EXPECT_LE(top[0].count - top[0].error, 20000u);
+    EXPECT_GE(top[1].count, 10000u);
+    EXPECT_LE(top[1].count - top[1].error, 10000u);
+}
+
+TEST(SpaceSavingTest, Decay) {
+    SpaceSaving sketch(4);
+    for (int i = 0; i < 100; i++) {
+        sketch.Add("old");
+    }
+    sketch.Decay();
+    sketch.Decay();
+    for (int i = 0; i < 30; i++) {
+        sketch.Add("new");
+    }
+
+    auto top = sketch.Top(1);
+    ASSERT_EQ(1u, top.size());
+    EXPECT_EQ("new", top[0].key);
+    EXPECT_EQ(55u, sketch.Total());
+}
@@ -1,8 +1,13 @@
 #include "gtest/gtest.h"
+#include <atomic>
+#include <chrono>
 #include <iostream>
 #include <set>
+#include <thread>
+#include <unistd.h>
 #include <vector>
 
+#include <storage/Dump.h>
 #include <storage/MapBasedGlobalLockImpl.h>
 #include <afina/execute/Get.h>
 #include <afina/execute/Set.h>
@@ -50,6 +55,27 @@ TEST(StorageTest, PutIfAbsent) {
     EXPECT_TRUE(value == "val1");
 }
 
+TEST(StorageTest, Append) {
+    MapBasedGlobalLockImpl storage(100);
+    std::string value;
+    EXPECT_FALSE(storage.Append("KEY1", "tail"));
+
+    storage.Put("KEY1", "val");
+    storage.Put("KEY2", std::string(40, 'v'));
+    for (int i = 0; i < 10; i++) {
+        ASSERT_TRUE(storage.Append("KEY1", "+"));
+    }
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ("val++++++++++", value);
+
+    // Others are evicted to make room, but value larger than storage is rejected
+    EXPECT_TRUE(storage.Append("KEY1", std::string(60, 'x')));
+    EXPECT_FALSE(storage.Get("KEY2", value));
+    EXPECT_TRUE(storage.Get("KEY1", value));
+    EXPECT_EQ(73u, value.size());
+    EXPECT_FALSE(storage.Append("KEY1", std::string(30, 'x')));
+}
+
 TEST(StorageTest, BigTest)  {
     const long SIZE = 100000;
     long cur_size = 0;
@@ -132,3 +158,452 @@ TEST(StorageTest, MaxTest) {
         EXPECT_FALSE(storage.Get(key, res));
     }
 }
+
+static std::string GetStatValue(const MapBasedGlobalLockImpl &storage, const std::string &group,
+                                const std::string &name) {
+    Afina::Storage::StatsList stats;
+    storage.GetStats(group, stats);
+    for (auto &stat : stats) {
+        if (stat.first == name) {
+            return stat.second;
+        }
+    }
+    return "";
+}
+
+static size_t GetStat(const MapBasedGlobalLockImpl &storage, const std::string &name) {
+    std::string value = GetStatValue(storage, "", name);
+    return value.empty() ? 0 : std::stoul(value);
+}
+
+TEST(StorageTest, MaintainerEvictsAhead) {
+    MapBasedGlobalLockImpl storage(1000);
+    storage.SetWatermarks(500, 800);
+    storage.Start();
+
+    // Each pair is 12 bytes, so usage gets over high watermark but never hits the limit
+    for (int i = 0; i < 80; i++) {
+        storage.Put("Key" + std::to_string(100 + i), "Val" + std::to_string(100 + i));
+    }
+
+    for (int i = 0; i < 100 && GetStat(storage, "bytes") > 500; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    storage.Stop();
+
+    EXPECT_LE(GetStat(storage, "bytes"), 500u);
+    EXPECT_GE(GetStat(storage, "maintainer_cycles"), 1u);
+    EXPECT_GE(GetStat(storage, "maintainer_evictions"), 39u);
+    EXPECT_EQ(0u, GetStat(storage, "inline_evictions"));
+
+    // The most recent entries survive
+    std::string value;
+    EXPECT_TRUE(storage.Get("Key179", value));
+    EXPECT_EQ("Val179", value);
+    EXPECT_FALSE(storage.Get("Key100", value));
+}
+
+TEST(StorageTest, InlineEvictionFallback) {
+    MapBasedGlobalLockImpl storage(7 * 8);
+
+    for (int i = 0; i < 10; i++) {
+        storage.Put("Key" + std::to_string(i), "Val" + std::to_string(i));
+    }
+    EXPECT_EQ(3u, GetStat(storage, "inline_evictions"));
+    EXPECT_EQ(7u, GetStat(storage, "curr_items"));
+}
+
+TEST(StorageTest, HotKeyDetected) {
+    MapBasedGlobalLockImpl storage;
+    for (int i = 0; i < 50; i++) {
+        storage.Put("Key" + std::to_string(i), "Val" + std::to_string(i));
+    }
+
+    // Key7 takes half of reads
+    std::string value;
+    for (int i = 0; i < 10000; i++) {
+        storage.Get(i % 2 ? "Key7" : "Key" + std::to_string(i % 50), value);
+    }
+
+    std::string stat = GetStatValue(storage, "hotkeys", "hotkey:Key7");
+    ASSERT_FALSE(stat.empty());
+    EXPECT_NE(std::string::npos, stat.find(" hot"));
+    EXPECT_EQ(std::string::npos, GetStatValue(storage, "hotkeys", "hotkey:Key8").find(" hot"));
+
+    // Served from replica now, writes must be visible anyway
+    EXPECT_TRUE(storage.Get("Key7", value));
+    EXPECT_EQ("Val7", value);
+
+    storage.Put("Key7", "New7");
+    EXPECT_TRUE(storage.Get("Key7", value));
+    EXPECT_EQ("New7", value);
+    EXPECT_TRUE(storage.Get("Key7", value));
+    EXPECT_EQ("New7", value);
+
+    storage.Set("Key7", "Set7");
+    EXPECT_TRUE(storage.Get("Key7", value));
+    EXPECT_EQ("Set7", value);
+
+    storage.Delete("Key7");
+    EXPECT_FALSE(storage.Get("Key7", value));
+    EXPECT_GE(std::stoul(GetStatValue(storage, "hotkeys", "hot_invalidations")), 3u);
+}
+
+TEST(StorageTest, HotKeyReplicasConcurrent) {
+    MapBasedGlobalLockImpl storage;
+    storage.Put("hot", "0");
+
+    // Readers must never observe value older than the last one written before they started reading
+    std::atomic<int> written(0);
+    std::atomic<bool> failed(false);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([&storage, &written, &failed]() {
+            std::string value;
+            for (int i = 0; i < 50000; i++) {
+                int min = written.load();
+                if (!storage.Get("hot", value) || std::stoi(value) < min) {
+                    failed = true;
+                }
+            }
+        });
+    }
+
+    for (int i = 1; i <= 200; i++) {
+        storage.Put("hot", std::to_string(i));
+        written = i;
+        std::this_thread::yield();
+    }
+
+    for (auto &reader : readers) {
+        reader.join();
+    }
+    EXPECT_FALSE(failed);
+}
+
+// Gets served by replica are folded back, so the replicated key stays hot and recent under eviction pressure
+TEST(StorageTest, HotKeyReplicaSurvivesEviction) {
+    MapBasedGlobalLockImpl storage(16 * 1024);
+    storage.Put("hot", "Value");
+
+    std::string value;
+    for (int i = 0; i < 20000; i++) {
+        ASSERT_TRUE(storage.Get("hot", value)) << "evicted after " << i << " reads";
+        storage.Put("Key" + std::to_string(i), "Value");
+        for (int j = 0; j < 2 && j <= i; j++) {
+            storage.Get("Key" + std::to_string(i - j), value);
+        }
+
+        // Once detected key must stay hot
+        if (i >= 5000 && i % 100 == 0) {
+            ASSERT_NE(std::string::npos, GetStatValue(storage, "hotkeys", "hotkey:hot").find(" hot")) << i;
+        }
+    }
+}
+
+TEST(StorageTest, Load) {
+    std::string path = "/tmp/afina_load_test_" + std::to_string(getpid());
+    {
+        DumpWriter writer(path);
+        for (int i = 0; i < 10000; i++) {
+            writer.Write("Key" + std::to_string(i), 0, 0, "Val" + std::to_string(i));
+        }
+        writer.Write("Key5", 0, 0, "New5");
+        writer.Write("Expired", 0, -1, "Val");
+        writer.Close();
+    }
+
+    MapBasedGlobalLockImpl storage(1000000);
+    storage.Put("Old", "Val");
+    EXPECT_EQ(10000u, storage.Load(path, nullptr));
+
+    std::string value;
+    EXPECT_FALSE(storage.Get("Old", value));
+    EXPECT_FALSE(storage.Get("Expired", value));
+    EXPECT_TRUE(storage.Get("Key5", value));
+    EXPECT_EQ("New5", value);
+    EXPECT_TRUE(storage.Get("Key9999", value));
+    EXPECT_EQ("Val9999", value);
+
+    // Storage keeps working after load
+    storage.Put("Key10000", "Val10000");
+    EXPECT_TRUE(storage.Delete("Key0"));
+    EXPECT_EQ(10000u, GetStat(storage, "curr_items"));
+
+    // The latest records are kept if dump doesn't fit
+    MapBasedGlobalLockImpl small(10 * 14);
+    EXPECT_EQ(10u, small.Load(path, nullptr));
+    EXPECT_TRUE(small.Get("Key9999", value));
+    EXPECT_TRUE(small.Get("Key5", value));
+    EXPECT_FALSE(small.Get("Key9990", value));
+
+    // Eviction follows dump order
+    small.Put("Key10000", "Val10000");
+    EXPECT_FALSE(small.Get("Key9991", value));
+    EXPECT_TRUE(small.Get("Key9992", value));
+
+    MapBasedGlobalLockImpl filtered(1000000);
+    EXPECT_EQ(9000u, filtered.Load(path, [](const std::string &key) { return key.size() == 7; }));
+    EXPECT_FALSE(filtered.Get("Key999", value));
+    EXPECT_TRUE(filtered.Get("Key1000", value));
+
+    unlink(path.c_str());
+    EXPECT_THROW(storage.Load(path, nullptr), std::runtime_error);
+    EXPECT_TRUE(storage.Get("Key10000", value));
+}
+
+TEST(StorageTest, FlushAll) {
+    MapBasedGlobalLockImpl storage(1000);
+    for (int i = 0; i < 10; i++) {
+        storage.Put("Key" + std::to_string(i), "Val" + std::to_string(i));
+    }
+
+    storage.FlushAll(0);
+    EXPECT_EQ(0u, GetStat(storage, "curr_items"));
+    EXPECT_EQ(10u, GetStat(storage, "stale_items"));
+
+    std::string value;
+    EXPECT_FALSE(storage.Get("Key1", value));
+    EXPECT_FALSE(storage.Set("Key2", "New2"));
+    EXPECT_FALSE(storage.Delete("Key3"));
+    EXPECT_TRUE(storage.PutIfAbsent("Key4", "New4"));
+    EXPECT_TRUE(storage.Get("Key4", value));
+    EXPECT_EQ("New4", value);
+
+    // Touched stale entries are reclaimed
+    EXPECT_EQ(1u, GetStat(storage, "curr_items"));
+    EXPECT_EQ(7u, GetStat(storage, "stale_items"));
+
+    // The rest goes away with eviction
+    for (int i = 0; i < 100; i++) {
+        storage.Put("Other" + std::to_string(i), "Val");
+    }
+    EXPECT_EQ(0u, GetStat(storage, "stale_items"));
+    EXPECT_FALSE(storage.Get("Key0", value));
+}
+
+TEST(StorageTest, FlushAllDelayed) {
+    MapBasedGlobalLockImpl storage;
+    storage.Put("Key", "Val");
+
+    // Replica of the hot key must not outlive flush
+    std::string value;
+    for (int i = 0; i < 5000; i++) {
+        storage.Get("Key", value);
+    }
+
+    storage.FlushAll(1);
+    EXPECT_TRUE(storage.Get("Key", value));
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    EXPECT_FALSE(storage.Get("Key", value));
+
+    storage.Put("Key", "New");
+    EXPECT_TRUE(storage.Get("Key", value));
+    EXPECT_EQ("New", value);
+}
+
+TEST(StorageTest, DeleteChurn) {
+    MapBasedGlobalLockImpl storage(1 << 20);
+    for (int i = 0; i < 1000; i++) {
+        storage.Put("Key" + std::to_string(i), "Val");
+    }
+    size_t buckets = GetStat(storage, "index_buckets");
+    size_t bytes = GetStat(storage, "bytes");
+
+    // Removed entries must free their memory and leave nothing behind in the index
+    std::string value;
+    for (int round = 0; round < 100; round++) {
+        for (int i = 0; i < 1000; i += 2) {
+            ASSERT_TRUE(storage.Delete("Key" + std::to_string(i)));
+        }
+        for (int i = 0; i < 1000; i += 2) {
+            ASSERT_TRUE(storage.PutIfAbsent("Key" + std::to_string(i), "Val"));
+        }
+    }
+
+    EXPECT_EQ(1000u, GetStat(storage, "curr_items"));
+    EXPECT_EQ(buckets, GetStat(storage, "index_buckets"));
+    EXPECT_EQ(bytes, GetStat(storage, "bytes"));
+
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_TRUE(storage.Delete("Key" + std::to_string(i)));
+        EXPECT_FALSE(storage.Get("Key" + std::to_string(i), value));
+    }
+    EXPECT_EQ(0u, GetStat(storage, "curr_items"));
+    EXPECT_EQ(0u, GetStat(storage, "bytes"));
+}
+
+TEST(StorageTest, KeyspaceStats) {
+    MapBasedGlobalLockImpl storage(1 << 20);
+    for (int i = 0; i < 2000; i++) {
+        storage.Put("small:" + std::to_string(i), "Val");
+    }
+    storage.Put("big:1", std::string(10000, 'v'));
+    storage.FlushAll(0);
+    storage.Put("big:2", std::string(20000, 'v'));
+    storage.Put("small:1", "Val");
+
+    // Flushed entries are not reported
+    EXPECT_EQ("2", GetStatValue(storage, "keyspace", "keyspace_items"));
+    EXPECT_EQ("20000", GetStatValue(storage, "keyspace", "bigkey:big:2"));
+    EXPECT_EQ("", GetStatValue(storage, "keyspace", "bigkey:big:1"));
+    EXPECT_EQ("1 20005", GetStatValue(storage, "keyspace", "prefix:big"));
+    EXPECT_EQ("2", GetStatValue(storage, "keyspace", "idle_le_60s"));
+}
+
+TEST(StorageTest, KeyspaceSample) {
+    // Index is presized to 131072 buckets, a call walks 64 steps of 256 buckets
+    MapBasedGlobalLockImpl storage(64 << 20, true, 100000);
+    for (int i = 0; i < 1000; i++) {
+        storage.Put("Key" + std::to_string(i), "Val");
+    }
+
+    // Calls continue one after another, together they walk the whole index once
+    size_t items = 0;
+    for (int i = 0; i < 8; i++) {
+        Afina::Storage::StatsList stats;
+        storage.GetStats("keyspace", stats);
+        for (auto &stat : stats) {
+            if (stat.first == "keyspace_sample_ratio") {
+                EXPECT_EQ("0.125000", stat.second);
+            } else if (stat.first == "keyspace_items") {
+                items += std::stoul(stat.second);
+            }
+        }
+    }
+    EXPECT_EQ(1000u, items);
+}
+
+TEST(StorageTest, LeaseMiss) {
+    MapBasedGlobalLockImpl storage;
+    std::string value;
+    uint64_t token = 0, other = 0;
+
+    // Only the first miss gets lease, others wait for refill
+    EXPECT_EQ(Afina::Storage::LeaseStatus::Granted, storage.LeaseGet("Key", value, token));
+    EXPECT_NE(0u, token);
+    EXPECT_EQ(Afina::Storage::LeaseStatus::Wait, storage.LeaseGet("Key", value, other));
+    EXPECT_FALSE(storage.Get("Key", value));
+    EXPECT_EQ(0u, GetStat(storage, "curr_items"));
+
+    EXPECT_FALSE(storage.LeaseSet("Key", "Val", token + 1));
+    EXPECT_TRUE(storage.LeaseSet("Key", "Val", token));
+    EXPECT_FALSE(storage.LeaseSet("Key", "Val", token));
+    EXPECT_EQ(Afina::Storage::LeaseStatus::Hit, storage.LeaseGet("Key", value, other));
+    EXPECT_EQ("Val", value);
+
+    EXPECT_EQ(1u, GetStat(storage, "lease_grants"));
+    EXPECT_EQ(1u, GetStat(storage, "lease_waits"));
+    EXPECT_EQ(2u, GetStat(storage, "lease_rejects"));
+    EXPECT_EQ(1u, GetStat(storage, "curr_items"));
+}
+
+TEST(StorageTest, LeaseStaleWhileRevalidate) {
+    MapBasedGlobalLockImpl storage;
+    std::string value;
+    uint64_t token = 0, other = 0;
+
+    storage.Put("Key", "Old");
+    EXPECT_TRUE(storage.Invalidate("Key"));
+    EXPECT_FALSE(storage.Invalidate("Key"));
+    EXPECT_FALSE(storage.Get("Key", value));
+
+    EXPECT_EQ(Afina::Storage::LeaseStatus::Granted, storage.LeaseGet("Key", value, token));
+    EXPECT_EQ(Afina::Storage::LeaseStatus::Stale, storage.LeaseGet("Key", value, other));
+    EXPECT_EQ("Old", value);
+
+    // Plain write cancels lease
+    storage.Put("Key", "New");
+    EXPECT_FALSE(storage.LeaseSet("Key", "Refill", token));
+    EXPECT_TRUE(storage.Get("Key", value));
+    EXPECT_EQ("New", value);
+
+    // So does flush
+    EXPECT_TRUE(storage.Invalidate("Key"));
+    EXPECT_EQ(Afina::Storage::LeaseStatus::Granted, storage.LeaseGet("Key", value, token));
+    storage.FlushAll(0);
+    EXPECT_FALSE(storage.LeaseSet("Key", "Refill", token));
+    EXPECT_EQ(Afina::Storage::LeaseStatus::Granted, storage.LeaseGet("Key", value, token));
+    EXPECT_TRUE(storage.LeaseSet("Key", "Refill", token));
+    EXPECT_EQ(1u, GetStat(storage, "curr_items"));
+    EXPECT_EQ(0u, GetStat(storage, "stale_items"));
+    EXPECT_EQ(9u, GetStat(storage, "bytes"));
+}
+
+TEST(StorageTest, GhostHits) {
+    // Fits 10 entries of 10 bytes
+    MapBasedGlobalLockImpl storage(100);
+    storage.EnableGhosts(true, 0);
+    for (int i = 0; i < 30; i++) {
+        storage.Put("Key" + std::to_string(10 + i), "Value");
+    }
+
+    // Key10..Key29 are evicted, Key29 is the latest. A cache of 1.25x would hold 2 more entries,
+    // 1.5x - 5 more, 2x - 10 more
+    std::string value;
+    for (int i = 0; i < 30; i++) {
+        storage.Get("Key" + std::to_string(10 + i), value);
+    }
+    EXPECT_EQ(20u, GetStat(storage, "ghost_misses"));
+    EXPECT_EQ(2u, GetStat(storage, "ghost_hits_1.25x"));
+    EXPECT_EQ(5u, GetStat(storage, "ghost_hits_1.5x"));
+    EXPECT_EQ(10u, GetStat(storage, "ghost_hits_2x"));
+    EXPECT_EQ(0u, GetStat(storage, "ghost_items"));
+}
+
+TEST(StorageTest, ARCEviction) {
+    // Fits 10 entries of 10 bytes
+    MapBasedGlobalLockImpl storage(100, true, 0, "arc");
+    std::string value;
+    for (int i = 0; i < 5; i++) {
+        storage.Put("Hot" + std::to_string(10 + i), "Value");
+        storage.Get("Hot" + std::to_string(10 + i), value);
+    }
+
+    // Scan of keys used once doesn't push out ones used twice
+    for (int i = 0; i < 100; i++) {
+        storage.Put("Key" + std::to_string(100 + i), "Value");
+    }
+    for (int i = 0; i < 5; i++) {
+        EXPECT_TRUE(storage.Get("Hot" + std::to_string(10 + i), value));
+    }
+    EXPECT_EQ("arc", GetStatValue(storage, "", "eviction_policy"));
+    EXPECT_TRUE(GetStat(storage, "bytes") <= 100);
+
+    EXPECT_THROW(MapBasedGlobalLockImpl(100, true, 0, "fifo"), std::runtime_error);
+}
+
+TEST(StorageTest, LargeValues) {
+    MapBasedGlobalLockImpl storage(8 << 20);
+    EXPECT_GT(GetStat(storage, "values_region"), 7u << 20);
+
+    // Large values are placed into the region, small ones are not
+    std::string value;
+    for (int i = 0; i < 10; i++) {
+        ASSERT_TRUE(storage.Put("Key" + std::to_string(i), std::string(100000 + i, 'a' + i)));
+    }
+    storage.Put("Small", "Val");
+    EXPECT_EQ(10 * 128 * 1024u, GetStat(storage, "values_region_allocated"));
+    EXPECT_EQ(0u, GetStat(storage, "values_region_overflows"));
+
+    ASSERT_TRUE(storage.Set("Key0", std::string(200000, 'z')));
+    ASSERT_TRUE(storage.Get("Key0", value));
+    EXPECT_EQ(std::string(200000, 'z'), value);
+    for (int i = 1; i < 10; i++) {
+        ASSERT_TRUE(storage.Get("Key" + std::to_string(i), value));
+        EXPECT_EQ(std::string(100000 + i, 'a' + i), value);
+    }
+
+    for (int i = 0; i < 10; i++) {
+        storage.Delete("Key" + std::to_string(i));
+    }
+    EXPECT_EQ(0u, GetStat(storage, "values_region_allocated"));
+    EXPECT_EQ("0.000000", GetStatValue(storage, "", "values_external_fragmentation"));
+
+    // Storage too small for a few large values keeps them in the heap
+    MapBasedGlobalLockImpl small(100000);
+    EXPECT_TRUE(small.Put("Key", std::string(70000, 'v')));
+    EXPECT_TRUE(small.Get("Key", value));
+    EXPECT_EQ(70000u, value.size());
+    EXPECT_EQ(0u, GetStat(small, "values_region"));
+}